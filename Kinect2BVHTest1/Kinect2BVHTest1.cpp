@@ -5,33 +5,99 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <string.h>
 
 #include "bvhexport.h"
+#include "capturereader.h"
+#include "retarget.h"
+#include "lodexport.h"
+#include "cliptransform.h"
+#include "exportplan.h"
+#include "replaysimulator.h"
+#include "syntheticcapture.h"
+#include "streamexport.h"
+#include "multisensor.h"
+#include "captureanalytics.h"
+#include "capturemerge.h"
+#include "conversionservice.h"
+#include "blockcompress.h"
+#include "bvhreader.h"
+#include "quaternion.h"
+#include "alloctracker.h"
 
-
-struct sKinectPosition
+// live Է  heap Ҵ ˻ (CAllocationTracker   build  )
+// inRepeatCount  з ̸    capture  inRepeatCount  ̾ ٿ ϴ  Ҵ Ƚ .
+// warm-up  heap Ҵ    true
+static bool ReplayAllocationTest(const CKinectCaptureReader& inCaptureReader, CBVH& outBVH, int inRepeatCount, size_t& outAllocationCount)
 {
-	int JointType;
-	Vector4 Position;
-};
+	outAllocationCount = 0;
 
-struct sKinectRotation
-{
-	int JointType;
-	Vector4 Quaternion;
-};
+	const auto& frames = inCaptureReader.GetFrames();
+	if (!CAllocationTracker::IsEnabled() || frames.empty() || inRepeatCount <= 0)
+		return false;
+
+	// warm-up : ݺ ü з arena block  frame chunk  ̸ ´.
+	outBVH.ClearFrames();
+	outBVH.ReserveFrames(frames.size() * inRepeatCount);
+
+	// ݺ   capture ڷ ð ̾ δ.
+	const DWORD captureLength = frames.back().MilliSecond - frames.front().MilliSecond + 1;
+
+	sKinectFrame frame;
+
+	CAllocationTracker::Start();
+	for (int repeat = 0; repeat < inRepeatCount; ++repeat)
+	{
+		for (auto const& value : frames)
+		{
+			frame = value;
+			frame.MilliSecond += repeat * captureLength;
+
+			CKinectCaptureReader::ReplayFrame(frame, outBVH);
+		}
+	}
+	CAllocationTracker::Stop();
+
+	outAllocationCount = CAllocationTracker::GetAllocationCount();
 
-struct sKinectFrame
+	return outAllocationCount == 0;
+}
+
+// "-selftest"    : export  Ʒ ˻縸 ϰ ϳ ϸ false
+static bool RunSelfTest(CBVH& inBVH, const CKinectCaptureReader& inCaptureReader)
 {
-	DWORD MilliSecond;
-	sKinectPosition Pos;
-	sKinectRotation Rot;
-};
+	bool bResult = true;
+
+	// live Է (Begin/Add*Value/End) heap Ҵ  Ȯ (Debug build) : capture  100  ̾ 
+	if (CAllocationTracker::IsEnabled())
+	{
+		size_t allocationCount = 0;
+		if (!ReplayAllocationTest(inCaptureReader, inBVH, 100, allocationCount))
+		{
+			std::cout << "live ingest allocations : " << allocationCount << std::endl;
+			bResult = false;
+		}
+
+		inBVH.ClearFrames();
+	}
+
+	// Euler ȯ е : tier    EULER_PRECISION_MAX_ERROR   SelectEulerPrecision  ߸  ȴ. (exact  ̹Ƿ )
+	for (int precision = EEulerPrecision_Exact + 1; precision < EEulerPrecision_Count; ++precision)
+	{
+		const double precisionError = MeasureEulerPrecisionError((EEulerPrecision)precision, 100000);
+		if (precisionError > EULER_PRECISION_MAX_ERROR[precision])
+		{
+			std::cout << "euler precision " << precision << " : " << precisionError << " > " << EULER_PRECISION_MAX_ERROR[precision] << std::endl;
+			bResult = false;
+		}
+	}
 
-int main()
+	return bResult;
+}
+
+int main(int argc, char* argv[])
 {
-	std::string content;
-	std::ifstream myfile;
+	const bool bSelfTest = argc > 1 && strcmp(argv[1], "-selftest") == 0;
 
 	CBVH bvh;
 
@@ -40,83 +106,157 @@ int main()
 	bvh.ImportRefPoseByBVHFile("Girl Blendswap5_AddRoot3.bvh");
 	//bvh.SetKinectBoneConfiguration();
 
-	myfile.open("rawtest.txt", std::ios::in);
+	// ٸ rig  retarget : ̸ ٸų rest pose  ٸ joint  Ģ 
+	//CBVH targetRig;
+	//targetRig.ImportRefPoseByBVHFile("Girl Blendswap5_AddRoot1.bvh");
+	//CRetargetMap retargetMap;
+	//retargetMap.Compile(bvh, targetRig, { FRetargetRule("HandTipLeft", "HandTipLeft", true) });
+	//bvh.AddRetargetOutput(targetRig, retargetMap, "test_retarget.bvh");
 
-	do
-	{
-		myfile >> content;
+	// ̸ LOD : ճ/  15 fps   export
+	//CBVHLODMap previewMap;
+	//previewMap.Compile(bvh, { "HandTipLeft", "ThumbLeft", "HandTipRight", "ThumbRight" }, 2);
+	//bvh.AddLODOutput(previewMap, "test_preview.bvh");
 
-		if (content != "")
-		{
-			DWORD milliSeconds = std::stoi(content);
-
-			bvh.Begin(milliSeconds);
-
-			myfile >> content;
-			if (content != "Pos")
-				break;
-
-			myfile >> content;
-			int posCount = std::stoi(content);
-			if (posCount == 0)
-				break;
-
-			for (int i = 0; i < posCount; ++i)
-			{
-				JointType jointType;
-				float x, y, z;
-				myfile >> content;
-				jointType = (JointType)std::stoi(content);
-
-				myfile >> content;
-				x = std::stof(content);
-				myfile >> content;
-				y = std::stof(content);
-				myfile >> content;
-				z = std::stof(content);
-
-				XMVECTOR position = { x, y, z };
-				bvh.AddJointPositionValue(jointType, position);
-			}
-
-
-			myfile >> content;
-			if (content != "Rot")
-				break;
-
-			myfile >> content;
-			int rotCount = std::stoi(content);
-			if (rotCount == 0)
-				break;
-
-			for (int i = 0; i < posCount; ++i)
-			{
-				JointType jointType;
-				float x, y, z, w;
-				myfile >> content;
-				jointType = (JointType)std::stoi(content);
-
-				myfile >> content;
-				x = std::stof(content);
-				myfile >> content;
-				y = std::stof(content);
-				myfile >> content;
-				z = std::stof(content);
-				myfile >> content;
-				w = std::stof(content);
-
-				XMVECTOR quat = { x,y,z,w };
-				bvh.AddJointRotationValue(jointType, quat);
-			}
-			bvh.End();
-		}
+	// ¿  + root  Y  180   export
+	//FClipTransformOptions clipOptions;
+	//clipOptions.bMirror = true;
+	//clipOptions.RootRotation = XMQuaternionRotationRollPitchYaw(0.0f, XM_PI, 0.0f);
+	//CClipTransform clipTransform;
+	//clipTransform.Compile(bvh, clipOptions);
+	//bvh.SetClipTransform(&clipTransform);
+
+	// root ̵ export : Kinect m -> sample rig  (mm)
+	//FClipTransformOptions rootOptions;
+	//rootOptions.UnitScale = 1000.0f;
+	//CClipTransform rootTransform;
+	//rootTransform.Compile(bvh, rootOptions);
+	//bvh.SetClipTransform(&rootTransform);
+	//bvh.SetRootTranslationExport(true);
 
-	} while (content != "");
+	// record 迡   thread  parsing   timestamp  
+	CKinectCaptureReader captureReader;
+	if (!captureReader.ReadTextFile("rawtest.txt"))
+		return 1;
 
-	myfile.close();
+	if (bSelfTest)
+		return RunSelfTest(bvh, captureReader) ? 0 : 1;
+
+	captureReader.Replay(bvh);
 
 	bvh.ExportFile("test.bvh");
 
+	// ȸ /е//frame rate  ٸ     export
+	//CBVHExportPlan exportPlan;
+	//exportPlan.AddTarget(FBVHExportTarget("test_zyx.bvh"));
+	//exportPlan.AddTarget(FBVHExportTarget("test_xyz.bvh", xyz, 3));
+	//exportPlan.AddTarget(FBVHExportTarget("test_60.bvhb", zyx, 6, EBVHExportFormat_Binary, 60));
+	//bvh.ExportFiles(exportPlan);
+
+	// ".gz" ̸̸ block  worker thread   (gzip  Ǯ  ְ, CBlockCompressedReader  block   Ǯ  ִ)
+	//bvh.ExportFile("test.bvh.gz");
+
+	// ū BVH   frame  : HIERARCHY  parsing ϰ MOTION  û frame   . ( test.bvh.idx  ´)
+	//CBVHFileReader bvhReader;
+	//if (bvhReader.Open("test.bvh", true))
+	//{
+	//	std::vector<float> channels(bvhReader.GetChannelCount() * 10);
+	//	bvhReader.ReadFrames(100, 10, channels.data());
+	//}
+
+	// Ϻ  export : sidecar (rawtest.txt.idx) ̿ؼ ʿ record  д´.
+	//captureReader.ExportClip(bvh, "rawtest.txt", 1000, 3000, "clip.bvh");
+
+	// live capture  journal  ,   Ŀ ̾ capture
+	//if (!bvh.ResumeJournal("session.kjnl"))
+	//	bvh.StartJournal("session.kjnl");
+
+	// live preview : resampling  pose   ޸𸮿 ø, body frame  bvh.PublishPendingPoses() ȣ
+	// ٸ process  CPoseSubscriber::Open("Local\\KinectPose")  ReadLatest  ֽ pose  д´.
+	//bvh.StartPosePublisher("Local\\KinectPose");
+
+	// sensor  capture  2 , body 2  ϸ鼭 ó  ð 
+	//CKinectReplaySimulator simulator(captureReader.GetFrames());
+	//FReplaySimulatorOptions simulatorOptions;
+	//simulatorOptions.Speed = 2.0f;
+	//simulatorOptions.BodyCount = 2;
+	//simulatorOptions.JitterMilliSeconds = 5;
+	//FReplaySimulatorReport simulatorReport;
+	//if (simulator.Run("Girl Blendswap5_AddRoot3.bvh", simulatorOptions, simulatorReport))
+	//	std::cout << CKinectReplaySimulator::FormatReport(simulatorReport);
+
+	// benchmark  capture : ref pose  seed      1 GB binary capture 
+	//FSyntheticCaptureOptions syntheticOptions;
+	//syntheticOptions.Format = ECaptureFileFormat_Binary;
+	//syntheticOptions.TargetSize = 1ull << 30;
+	//syntheticOptions.Seed = 42;
+	//CSyntheticCaptureGenerator generator(bvh, syntheticOptions);
+	//generator.WriteFile("synthetic_1g.kcap");
+	//captureReader.ReadBinaryFile("synthetic_1g.kcap");
+
+	// ū capture    ʰ reader -> solver -> formatter -> writer stage    export
+	//CBVHStreamExporter streamExporter(bvh);
+	//streamExporter.Export("synthetic_1g.kcap", "synthetic_1g.bvh");
+
+	// ref pose  ClipTransform  ٲ   capture  ٽ export   solver + resampling  
+	//bvh.SetRotationCacheDirectory("rotationcache");
+
+	// Euler ȯ е : 0.001   ϸ float ׽ ٻ tier . (tier   Ȯ -selftest)
+	//bvh.SetRotationTolerance(0.001f);
+
+	// sensor   : sensor  thread  Push, fusion thread  Poll (ȭ capture  sensor  ؼ Ȯ)
+	//CKinectCaptureReader sideReader;
+	//if (!sideReader.ReadTextFile("rawtest_side.txt"))
+	//	return 1;
+	//CMultiSensorFusion fusion;
+	//FSensorOptions sideSensor;
+	//sideSensor.ClockOffset = -7;
+	//sideSensor.Rotation = XMQuaternionRotationRollPitchYaw(0.0f, XM_PIDIV2, 0.0f);
+	//sideSensor.Translation = XMVectorSet(2.0f, 0.0f, 2.0f, 0.0f);
+	//const int frontIndex = fusion.AddSensor();
+	//const int sideIndex = fusion.AddSensor(sideSensor);
+	//std::thread frontThread([&] { for (auto const& frame : captureReader.GetFrames()) fusion.Push(frontIndex, frame); fusion.Close(frontIndex); });
+	//std::thread sideThread([&] { for (auto const& frame : sideReader.GetFrames()) fusion.Push(sideIndex, frame); fusion.Close(sideIndex); });
+	//CBVH fusedBVH;
+	//fusedBVH.ImportRefPoseByBVHFile("Girl Blendswap5_AddRoot3.bvh");
+	//while (!fusion.IsFinished())
+	//	fusion.Poll(fusedBVH);
+	//frontThread.join();
+	//sideThread.join();
+	//fusedBVH.ExportFile("fused.bvh");
+
+	// capture / export  BVH   thread   мϰ clip   پ  (tab )
+	//std::vector<FClipAnalytics> analytics;
+	//CCaptureAnalyzer::AnalyzeFiles({ "rawtest.txt", "test.bvh" }, analytics);
+	//CCaptureAnalyzer::WriteSummaryFile("analytics.tsv", analytics);
+
+	//   capture ϵ ϳ timeline  ̾ export (ġ   켱)
+	//CCaptureMerger merger(ECaptureOverlapRule_KeepLast);
+	//merger.AddSession(FCaptureSessionOptions("take1_a.txt"));
+	//merger.AddSession(FCaptureSessionOptions("take1_b.txt", true, 33));
+	//merger.AddSession(FCaptureSessionOptions("take1_c.kcap", 95000));
+	//CBVH mergedBVH;
+	//mergedBVH.ImportRefPoseByBVHFile("Girl Blendswap5_AddRoot3.bvh");
+	//if (merger.Open())
+	//	merger.Replay(mergedBVH);
+	//mergedBVH.ExportFile("take1.bvh");
+
+	// ȯ service : worker  ref pose  import  CBVH    ְ, spool directory  *.job  priority  ó
+	// ٸ process  CConversionService::WriteJobFile  job  ְ <name>.result, metrics.txt  д´.
+	//FConversionServiceOptions serviceOptions;
+	//serviceOptions.SpoolDirectory = "spool";
+	//serviceOptions.WorkerCount = 4;
+	//CConversionService service(serviceOptions);
+	//service.Start();
+	//FConversionJob previewJob;
+	//previewJob.CaptureFileName = "rawtest.txt";
+	//previewJob.RefPoseFileName = "Girl Blendswap5_AddRoot3.bvh";
+	//previewJob.OutputFileName = "preview.bvh";
+	//previewJob.Priority = EConversionPriority_Interactive;
+	//service.Submit(previewJob, "preview");
+	//service.WaitForIdle();
+	//service.Stop();
+
     return 0;
 }
 
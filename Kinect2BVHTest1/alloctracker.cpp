@@ -0,0 +1,97 @@
+#include "stdafx.h"
+
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+#include "alloctracker.h"
+
+static std::atomic<bool> bAllocationTracking(false);
+static std::atomic<size_t> AllocationCount(0);
+static std::atomic<size_t> AllocationBytes(0);
+
+void CAllocationTracker::Start()
+{
+	AllocationCount = 0;
+	AllocationBytes = 0;
+
+	bAllocationTracking = true;
+}
+
+void CAllocationTracker::Stop()
+{
+	bAllocationTracking = false;
+}
+
+size_t CAllocationTracker::GetAllocationCount()
+{
+	return AllocationCount;
+}
+
+size_t CAllocationTracker::GetAllocationBytes()
+{
+	return AllocationBytes;
+}
+
+#if ALLOCATION_TRACKER_ENABLED
+
+static void* TrackedAllocate(size_t inSize)
+{
+	if (bAllocationTracking.load(std::memory_order_relaxed))
+	{
+		AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		AllocationBytes.fetch_add(inSize, std::memory_order_relaxed);
+	}
+
+	return malloc(inSize ? inSize : 1);
+}
+
+void* operator new(size_t inSize)
+{
+	void* memory = TrackedAllocate(inSize);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	return memory;
+}
+
+void* operator new[](size_t inSize)
+{
+	void* memory = TrackedAllocate(inSize);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	return memory;
+}
+
+void* operator new(size_t inSize, const std::nothrow_t&) noexcept
+{
+	return TrackedAllocate(inSize);
+}
+
+void* operator new[](size_t inSize, const std::nothrow_t&) noexcept
+{
+	return TrackedAllocate(inSize);
+}
+
+void operator delete(void* inMemory) noexcept
+{
+	free(inMemory);
+}
+
+void operator delete[](void* inMemory) noexcept
+{
+	free(inMemory);
+}
+
+void operator delete(void* inMemory, const std::nothrow_t&) noexcept
+{
+	free(inMemory);
+}
+
+void operator delete[](void* inMemory, const std::nothrow_t&) noexcept
+{
+	free(inMemory);
+}
+
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+
+//  operator new/delete  ä Start ~ Stop  heap Ҵ .
+// _DEBUG  ALLOCATION_TRACKER  ǵ build  operator new  üѴ.
+#if defined(_DEBUG) || defined(ALLOCATION_TRACKER)
+#define ALLOCATION_TRACKER_ENABLED 1
+#else
+#define ALLOCATION_TRACKER_ENABLED 0
+#endif
+
+class CAllocationTracker
+{
+public:
+	static bool IsEnabled() { return ALLOCATION_TRACKER_ENABLED != 0; }
+
+	// count  0  ϰ   ( thread  Ҵ Եȴ)
+	static void Start();
+	static void Stop();
+
+	static size_t GetAllocationCount();
+	static size_t GetAllocationBytes();
+};
@@ -0,0 +1,1334 @@
+#include "stdafx.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <queue>
+#include <functional>
+
+#include "blockcompress.h"
+
+// member ϳ ִ ִ Է ũ. (stored block   member  64 KB   ʴ´)
+static const size_t BLOCK_COMPRESS_BLOCK_SIZE = 0xff00;
+
+// worker ϳ ring   block 
+static const size_t BLOCK_COMPRESS_BLOCKS_PER_WORKER = 4;
+
+// LZ77 match Ž
+static const int DEFLATE_HASH_BITS = 15;
+static const int DEFLATE_MAX_CHAIN = 32;
+static const size_t DEFLATE_WINDOW_SIZE = 32768;
+static const size_t DEFLATE_MIN_MATCH = 3;
+static const size_t DEFLATE_MAX_MATCH = 258;
+
+// gzip header (FEXTRA, "BC" subfield  block ũ - 1    ä) + 8 byte trailer
+static const uint8_t GZIP_MEMBER_HEADER[] = { 0x1f, 0x8b, 0x08, 0x04, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0 };
+static const size_t GZIP_MEMBER_HEADER_SIZE = sizeof(GZIP_MEMBER_HEADER);
+static const size_t GZIP_MEMBER_TRAILER_SIZE = 8;
+
+static const int DEFLATE_LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const int DEFLATE_LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const int DEFLATE_DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const int DEFLATE_DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// dynamic block  code length code 
+static const int DEFLATE_CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+static uint32_t ReverseBits(uint32_t inCode, int inLength)
+{
+	uint32_t result = 0;
+	for (int i = 0; i < inLength; ++i)
+	{
+		result = (result << 1) | (inCode & 1);
+		inCode >>= 1;
+	}
+	return result;
+}
+
+//  Huffman code, length/distance symbol, CRC ǥ. ó     .
+struct FDeflateTables
+{
+	uint16_t LiteralCode[288];			// bit    code
+	uint8_t LiteralLength[288];
+	uint8_t LengthSymbol[DEFLATE_MAX_MATCH + 1];
+	uint8_t DistSymbol[DEFLATE_WINDOW_SIZE + 1];
+	uint16_t FixedDistCode[30];
+	uint8_t FixedDistLength[30];
+	uint32_t Crc[256];
+
+	FDeflateTables()
+	{
+		for (int i = 0; i < 288; ++i)
+		{
+			uint32_t code;
+			int length;
+
+			if (i < 144)		{ code = 0x30 + i;			length = 8; }
+			else if (i < 256)	{ code = 0x190 + i - 144;	length = 9; }
+			else if (i < 280)	{ code = i - 256;			length = 7; }
+			else				{ code = 0xc0 + i - 280;	length = 8; }
+
+			LiteralCode[i] = (uint16_t)ReverseBits(code, length);
+			LiteralLength[i] = (uint8_t)length;
+		}
+
+		for (int i = 0; i < 29; ++i)
+		{
+			const int end = i + 1 < 29 ? DEFLATE_LENGTH_BASE[i + 1] : (int)DEFLATE_MAX_MATCH + 1;
+			for (int length = DEFLATE_LENGTH_BASE[i]; length < end; ++length)
+			{
+				LengthSymbol[length] = (uint8_t)i;
+			}
+		}
+
+		for (int i = 0; i < 30; ++i)
+		{
+			const int end = i + 1 < 30 ? DEFLATE_DIST_BASE[i + 1] : (int)DEFLATE_WINDOW_SIZE + 1;
+			for (int dist = DEFLATE_DIST_BASE[i]; dist < end; ++dist)
+			{
+				DistSymbol[dist] = (uint8_t)i;
+			}
+
+			FixedDistCode[i] = (uint16_t)ReverseBits(i, 5);
+			FixedDistLength[i] = 5;
+		}
+
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			uint32_t crc = i;
+			for (int k = 0; k < 8; ++k)
+			{
+				crc = (crc & 1) ? 0xedb88320 ^ (crc >> 1) : crc >> 1;
+			}
+			Crc[i] = crc;
+		}
+	}
+};
+
+static const FDeflateTables& GetDeflateTables()
+{
+	static const FDeflateTables tables;
+	return tables;
+}
+
+static uint32_t ComputeCrc32(const uint8_t* inData, size_t inSize)
+{
+	const uint32_t* table = GetDeflateTables().Crc;
+
+	uint32_t crc = 0xffffffff;
+	for (size_t i = 0; i < inSize; ++i)
+	{
+		crc = table[(crc ^ inData[i]) & 0xff] ^ (crc >> 8);
+	}
+
+	return crc ^ 0xffffffff;
+}
+
+static void AppendUInt32(std::string& outData, uint32_t inValue)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		outData.push_back((char)((inValue >> (i * 8)) & 0xff));
+	}
+}
+
+static uint32_t ReadUInt32(const uint8_t* inData)
+{
+	return (uint32_t)inData[0] | ((uint32_t)inData[1] << 8) | ((uint32_t)inData[2] << 16) | ((uint32_t)inData[3] << 24);
+}
+
+// deflate  LSB  bit  ä.
+struct FDeflateBitWriter
+{
+	std::string& Out;
+	uint32_t Bits;
+	int Count;
+
+	explicit FDeflateBitWriter(std::string& ioOut) : Out(ioOut), Bits(0), Count(0) {}
+
+	void Put(uint32_t inValue, int inCount)
+	{
+		Bits |= inValue << Count;
+		Count += inCount;
+
+		while (Count >= 8)
+		{
+			Out.push_back((char)(Bits & 0xff));
+			Bits >>= 8;
+			Count -= 8;
+		}
+	}
+
+	void Flush()
+	{
+		if (Count > 0)
+		{
+			Out.push_back((char)(Bits & 0xff));
+		}
+
+		Bits = 0;
+		Count = 0;
+	}
+};
+
+static uint32_t HashDeflateBytes(const uint8_t* inData)
+{
+	return (((uint32_t)inData[0] << 10) ^ ((uint32_t)inData[1] << 5) ^ inData[2]) & ((1 << DEFLATE_HASH_BITS) - 1);
+}
+
+// LZ77  ϳ
+struct FDeflateToken
+{
+	uint16_t Length;					// 0 ̸ literal
+	uint16_t Value;						// literal byte Ǵ distance
+};
+
+// hash chain  window    match  ã´.
+static void FindDeflateMatches(const uint8_t* inData, size_t inSize, std::vector<FDeflateToken>& outTokens)
+{
+	std::vector<int> head((size_t)1 << DEFLATE_HASH_BITS, -1);
+	std::vector<int> prev(inSize);
+
+	auto insert = [&](size_t inPos)
+	{
+		if (inPos + DEFLATE_MIN_MATCH <= inSize)
+		{
+			const uint32_t hash = HashDeflateBytes(inData + inPos);
+			prev[inPos] = head[hash];
+			head[hash] = (int)inPos;
+		}
+	};
+
+	outTokens.reserve(inSize / 4);
+
+	size_t pos = 0;
+	while (pos < inSize)
+	{
+		size_t bestLength = 0;
+		size_t bestDist = 0;
+
+		if (pos + DEFLATE_MIN_MATCH <= inSize)
+		{
+			const size_t maxLength = std::min(DEFLATE_MAX_MATCH, inSize - pos);
+
+			int candidate = head[HashDeflateBytes(inData + pos)];
+			int chain = DEFLATE_MAX_CHAIN;
+
+			while (candidate >= 0 && pos - candidate <= DEFLATE_WINDOW_SIZE && chain-- > 0)
+			{
+				const uint8_t* match = inData + candidate;
+
+				if (match[bestLength] == inData[pos + bestLength])
+				{
+					size_t length = 0;
+					while (length < maxLength && match[length] == inData[pos + length])
+					{
+						++length;
+					}
+
+					if (length > bestLength)
+					{
+						bestLength = length;
+						bestDist = pos - candidate;
+
+						if (length == maxLength)
+							break;
+					}
+				}
+
+				candidate = prev[candidate];
+			}
+		}
+
+		FDeflateToken token;
+
+		if (bestLength >= DEFLATE_MIN_MATCH)
+		{
+			token.Length = (uint16_t)bestLength;
+			token.Value = (uint16_t)bestDist;
+
+			for (size_t i = 0; i < bestLength; ++i)
+			{
+				insert(pos + i);
+			}
+
+			pos += bestLength;
+		}
+		else
+		{
+			token.Length = 0;
+			token.Value = inData[pos];
+
+			insert(pos);
+			++pos;
+		}
+
+		outTokens.push_back(token);
+	}
+}
+
+// 󵵷 Huffman code ̸ . inMaxLength  Ѵ code  ª code   ܰ辿 ÷ ڸ .
+static void BuildDeflateCodeLengths(const uint32_t* inFrequencies, int inSymbolCount, int inMaxLength, uint8_t* outLengths)
+{
+	memset(outLengths, 0, inSymbolCount);
+
+	std::vector<int> symbols;
+	for (int i = 0; i < inSymbolCount; ++i)
+	{
+		if (inFrequencies[i] > 0)
+		{
+			symbols.push_back(i);
+		}
+	}
+
+	if (symbols.empty())
+		return;
+
+	if (symbols.size() == 1)
+	{
+		outLengths[symbols[0]] = 1;
+		return;
+	}
+
+	// node 0 ~ leafCount - 1  symbol,   node
+	const int leafCount = (int)symbols.size();
+	std::vector<int> parents(leafCount * 2 - 1, -1);
+
+	typedef std::pair<ULONGLONG, int> TNode;
+	std::priority_queue<TNode, std::vector<TNode>, std::greater<TNode>> queue;
+
+	for (int i = 0; i < leafCount; ++i)
+	{
+		queue.push(TNode(inFrequencies[symbols[i]], i));
+	}
+
+	int nextNode = leafCount;
+	while (queue.size() > 1)
+	{
+		const TNode first = queue.top();
+		queue.pop();
+		const TNode second = queue.top();
+		queue.pop();
+
+		parents[first.second] = nextNode;
+		parents[second.second] = nextNode;
+		queue.push(TNode(first.first + second.first, nextNode++));
+	}
+
+	// ̺ code . inMaxLength    inMaxLength  .
+	std::vector<int> lengthCounts(inMaxLength + 1, 0);
+	for (int i = 0; i < leafCount; ++i)
+	{
+		int depth = 0;
+		for (int node = i; parents[node] >= 0; node = parents[node])
+		{
+			++depth;
+		}
+
+		++lengthCounts[std::min(depth, inMaxLength)];
+	}
+
+	uint32_t kraftTotal = 0;
+	for (int length = 1; length <= inMaxLength; ++length)
+	{
+		kraftTotal += (uint32_t)lengthCounts[length] << (inMaxLength - length);
+	}
+
+	while (kraftTotal > (1u << inMaxLength))
+	{
+		--lengthCounts[inMaxLength];
+
+		for (int length = inMaxLength - 1; length > 0; --length)
+		{
+			if (lengthCounts[length] > 0)
+			{
+				--lengthCounts[length];
+				lengthCounts[length + 1] += 2;
+				break;
+			}
+		}
+
+		--kraftTotal;
+	}
+
+	// 󵵰  symbol  ª code
+	std::stable_sort(symbols.begin(), symbols.end(), [inFrequencies](int inA, int inB) { return inFrequencies[inA] > inFrequencies[inB]; });
+
+	size_t index = 0;
+	for (int length = 1; length <= inMaxLength; ++length)
+	{
+		for (int i = 0; i < lengthCounts[length]; ++i)
+		{
+			outLengths[symbols[index++]] = (uint8_t)length;
+		}
+	}
+}
+
+// canonical code (bit  )
+static void BuildDeflateCodes(const uint8_t* inLengths, int inSymbolCount, uint16_t* outCodes)
+{
+	int counts[16] = { 0, };
+	for (int i = 0; i < inSymbolCount; ++i)
+	{
+		++counts[inLengths[i]];
+	}
+	counts[0] = 0;
+
+	uint32_t nextCodes[16] = { 0, };
+	uint32_t code = 0;
+	for (int length = 1; length < 16; ++length)
+	{
+		code = (code + counts[length - 1]) << 1;
+		nextCodes[length] = code;
+	}
+
+	for (int i = 0; i < inSymbolCount; ++i)
+	{
+		outCodes[i] = inLengths[i] > 0 ? (uint16_t)ReverseBits(nextCodes[inLengths[i]]++, inLengths[i]) : 0;
+	}
+}
+
+// code   16 (  ݺ), 17/18 (0 ݺ)  δ. (symbol, extra bit )
+static void RunLengthEncodeCodeLengths(const uint8_t* inLengths, int inCount, std::vector<std::pair<uint8_t, uint8_t>>& outTokens)
+{
+	int pos = 0;
+	while (pos < inCount)
+	{
+		const uint8_t length = inLengths[pos];
+
+		int run = 1;
+		while (pos + run < inCount && inLengths[pos + run] == length)
+		{
+			++run;
+		}
+
+		if (length == 0 && run >= 3)
+		{
+			const int count = std::min(run, 138);
+			outTokens.push_back(count >= 11 ? std::make_pair((uint8_t)18, (uint8_t)(count - 11)) : std::make_pair((uint8_t)17, (uint8_t)(count - 3)));
+			pos += count;
+		}
+		else if (length != 0 && run >= 4)
+		{
+			const int count = std::min(run - 1, 6);
+			outTokens.push_back(std::make_pair(length, (uint8_t)0));
+			outTokens.push_back(std::make_pair((uint8_t)16, (uint8_t)(count - 3)));
+			pos += 1 + count;
+		}
+		else
+		{
+			outTokens.push_back(std::make_pair(length, (uint8_t)0));
+			++pos;
+		}
+	}
+}
+
+static void WriteDeflateTokens(FDeflateBitWriter& ioWriter, const std::vector<FDeflateToken>& inTokens, const uint16_t* inLiteralCodes, const uint8_t* inLiteralLengths, const uint16_t* inDistCodes, const uint8_t* inDistLengths)
+{
+	const FDeflateTables& tables = GetDeflateTables();
+
+	for (auto const& token : inTokens)
+	{
+		if (token.Length == 0)
+		{
+			ioWriter.Put(inLiteralCodes[token.Value], inLiteralLengths[token.Value]);
+			continue;
+		}
+
+		const int lengthSymbol = tables.LengthSymbol[token.Length];
+		ioWriter.Put(inLiteralCodes[257 + lengthSymbol], inLiteralLengths[257 + lengthSymbol]);
+		ioWriter.Put(token.Length - DEFLATE_LENGTH_BASE[lengthSymbol], DEFLATE_LENGTH_EXTRA[lengthSymbol]);
+
+		const int distSymbol = tables.DistSymbol[token.Value];
+		ioWriter.Put(inDistCodes[distSymbol], inDistLengths[distSymbol]);
+		ioWriter.Put(token.Value - DEFLATE_DIST_BASE[distSymbol], DEFLATE_DIST_EXTRA[distSymbol]);
+	}
+
+	ioWriter.Put(inLiteralCodes[256], inLiteralLengths[256]);
+}
+
+//   Ǵ Է (inSize <= 65535)
+static void DeflateStored(const uint8_t* inData, size_t inSize, std::string& outData)
+{
+	outData.push_back(1);		// BFINAL = 1, BTYPE = 00
+
+	outData.push_back((char)(inSize & 0xff));
+	outData.push_back((char)((inSize >> 8) & 0xff));
+	outData.push_back((char)(~inSize & 0xff));
+	outData.push_back((char)((~inSize >> 8) & 0xff));
+
+	outData.append((const char*)inData, inSize);
+}
+
+// block ϳ deflate block ϳ. dynamic Huffman,  Huffman, stored    
+static void DeflateBlock(const uint8_t* inData, size_t inSize, std::string& outData)
+{
+	const FDeflateTables& tables = GetDeflateTables();
+
+	std::vector<FDeflateToken> tokens;
+	FindDeflateMatches(inData, inSize, tokens);
+
+	uint32_t literalFrequencies[286] = { 0, };
+	uint32_t distFrequencies[30] = { 0, };
+	ULONGLONG extraBits = 0;
+
+	for (auto const& token : tokens)
+	{
+		if (token.Length == 0)
+		{
+			++literalFrequencies[token.Value];
+			continue;
+		}
+
+		const int lengthSymbol = tables.LengthSymbol[token.Length];
+		const int distSymbol = tables.DistSymbol[token.Value];
+
+		++literalFrequencies[257 + lengthSymbol];
+		++distFrequencies[distSymbol];
+		extraBits += DEFLATE_LENGTH_EXTRA[lengthSymbol] + DEFLATE_DIST_EXTRA[distSymbol];
+	}
+
+	literalFrequencies[256] = 1;
+
+	uint8_t literalLengths[286];
+	uint8_t distLengths[30];
+	BuildDeflateCodeLengths(literalFrequencies, 286, 15, literalLengths);
+	BuildDeflateCodeLengths(distFrequencies, 30, 15, distLengths);
+
+	// distance code  ϳ  code ϳ ´.
+	if (std::count(distLengths, distLengths + 30, 0) == 30)
+	{
+		distLengths[0] = 1;
+	}
+
+	int literalCount = 286;
+	while (literalCount > 257 && literalLengths[literalCount - 1] == 0)
+	{
+		--literalCount;
+	}
+
+	int distCount = 30;
+	while (distCount > 1 && distLengths[distCount - 1] == 0)
+	{
+		--distCount;
+	}
+
+	uint8_t lengths[286 + 30];
+	memcpy(lengths, literalLengths, literalCount);
+	memcpy(lengths + literalCount, distLengths, distCount);
+
+	std::vector<std::pair<uint8_t, uint8_t>> lengthTokens;
+	RunLengthEncodeCodeLengths(lengths, literalCount + distCount, lengthTokens);
+
+	uint32_t codeLengthFrequencies[19] = { 0, };
+	for (auto const& token : lengthTokens)
+	{
+		++codeLengthFrequencies[token.first];
+	}
+
+	uint8_t codeLengthLengths[19];
+	BuildDeflateCodeLengths(codeLengthFrequencies, 19, 7, codeLengthLengths);
+
+	int codeLengthCount = 19;
+	while (codeLengthCount > 4 && codeLengthLengths[DEFLATE_CODE_LENGTH_ORDER[codeLengthCount - 1]] == 0)
+	{
+		--codeLengthCount;
+	}
+
+	// ũ  (bit)
+	ULONGLONG dynamicBits = 3 + 5 + 5 + 4 + codeLengthCount * 3 + extraBits;
+	ULONGLONG fixedBits = 3 + extraBits;
+
+	for (auto const& token : lengthTokens)
+	{
+		dynamicBits += codeLengthLengths[token.first] + (token.first == 16 ? 2 : token.first == 17 ? 3 : token.first == 18 ? 7 : 0);
+	}
+
+	for (int i = 0; i < 286; ++i)
+	{
+		dynamicBits += (ULONGLONG)literalFrequencies[i] * literalLengths[i];
+		fixedBits += (ULONGLONG)literalFrequencies[i] * tables.LiteralLength[i];
+	}
+
+	for (int i = 0; i < 30; ++i)
+	{
+		dynamicBits += (ULONGLONG)distFrequencies[i] * distLengths[i];
+		fixedBits += (ULONGLONG)distFrequencies[i] * 5;
+	}
+
+	if ((inSize + 5) * 8 < std::min(dynamicBits, fixedBits))
+	{
+		DeflateStored(inData, inSize, outData);
+		return;
+	}
+
+	FDeflateBitWriter writer(outData);
+
+	if (dynamicBits < fixedBits)
+	{
+		// BFINAL = 1, BTYPE = 10
+		writer.Put(1, 1);
+		writer.Put(2, 2);
+
+		writer.Put(literalCount - 257, 5);
+		writer.Put(distCount - 1, 5);
+		writer.Put(codeLengthCount - 4, 4);
+
+		for (int i = 0; i < codeLengthCount; ++i)
+		{
+			writer.Put(codeLengthLengths[DEFLATE_CODE_LENGTH_ORDER[i]], 3);
+		}
+
+		uint16_t codeLengthCodes[19];
+		BuildDeflateCodes(codeLengthLengths, 19, codeLengthCodes);
+
+		for (auto const& token : lengthTokens)
+		{
+			writer.Put(codeLengthCodes[token.first], codeLengthLengths[token.first]);
+
+			if (token.first >= 16)
+			{
+				writer.Put(token.second, token.first == 16 ? 2 : token.first == 17 ? 3 : 7);
+			}
+		}
+
+		uint16_t literalCodes[286];
+		uint16_t distCodes[30];
+		BuildDeflateCodes(literalLengths, 286, literalCodes);
+		BuildDeflateCodes(distLengths, 30, distCodes);
+
+		WriteDeflateTokens(writer, tokens, literalCodes, literalLengths, distCodes, distLengths);
+	}
+	else
+	{
+		// BFINAL = 1, BTYPE = 01
+		writer.Put(1, 1);
+		writer.Put(1, 2);
+
+		WriteDeflateTokens(writer, tokens, tables.LiteralCode, tables.LiteralLength, tables.FixedDistCode, tables.FixedDistLength);
+	}
+
+	writer.Flush();
+}
+
+struct FInflateBitReader
+{
+	const uint8_t* Data;
+	size_t Size;
+	size_t Pos;
+	uint32_t Bits;
+	int Count;
+	bool bError;
+
+	FInflateBitReader(const uint8_t* inData, size_t inSize) : Data(inData), Size(inSize), Pos(0), Bits(0), Count(0), bError(false) {}
+
+	int Get(int inCount)
+	{
+		uint32_t value = Bits;
+
+		while (Count < inCount)
+		{
+			if (Pos >= Size)
+			{
+				bError = true;
+				return 0;
+			}
+
+			value |= (uint32_t)Data[Pos++] << Count;
+			Count += 8;
+		}
+
+		Bits = value >> inCount;
+		Count -= inCount;
+
+		return (int)(value & ((1u << inCount) - 1));
+	}
+};
+
+// canonical Huffman : ̺ code  (, symbol)  ĵ symbol
+struct FInflateHuffman
+{
+	short Count[16];
+	short Symbol[288];
+};
+
+static void BuildInflateHuffman(FInflateHuffman& outHuffman, const short* inLengths, int inSymbolCount)
+{
+	memset(outHuffman.Count, 0, sizeof(outHuffman.Count));
+
+	for (int i = 0; i < inSymbolCount; ++i)
+	{
+		++outHuffman.Count[inLengths[i]];
+	}
+
+	short offsets[16];
+	offsets[1] = 0;
+	for (int length = 1; length < 15; ++length)
+	{
+		offsets[length + 1] = offsets[length] + outHuffman.Count[length];
+	}
+
+	for (int i = 0; i < inSymbolCount; ++i)
+	{
+		if (inLengths[i] != 0)
+		{
+			outHuffman.Symbol[offsets[inLengths[i]]++] = (short)i;
+		}
+	}
+
+	outHuffman.Count[0] = 0;
+}
+
+static int DecodeInflateSymbol(FInflateBitReader& ioReader, const FInflateHuffman& inHuffman)
+{
+	int code = 0;
+	int first = 0;
+	int index = 0;
+
+	for (int length = 1; length < 16; ++length)
+	{
+		code |= ioReader.Get(1);
+		if (ioReader.bError)
+			return -1;
+
+		const int count = inHuffman.Count[length];
+		if (code - count < first)
+			return inHuffman.Symbol[index + (code - first)];
+
+		index += count;
+		first = (first + count) << 1;
+		code <<= 1;
+	}
+
+	return -1;
+}
+
+static bool InflateCodes(FInflateBitReader& ioReader, const FInflateHuffman& inLengthCode, const FInflateHuffman& inDistCode, size_t inOutputStart, std::string& outData)
+{
+	for (;;)
+	{
+		int symbol = DecodeInflateSymbol(ioReader, inLengthCode);
+		if (symbol < 0)
+			return false;
+
+		if (symbol < 256)
+		{
+			outData.push_back((char)symbol);
+			continue;
+		}
+
+		if (symbol == 256)
+			return true;
+
+		symbol -= 257;
+		if (symbol >= 29)
+			return false;
+
+		const size_t length = DEFLATE_LENGTH_BASE[symbol] + ioReader.Get(DEFLATE_LENGTH_EXTRA[symbol]);
+
+		symbol = DecodeInflateSymbol(ioReader, inDistCode);
+		if (symbol < 0 || symbol >= 30)
+			return false;
+
+		const size_t dist = DEFLATE_DIST_BASE[symbol] + ioReader.Get(DEFLATE_DIST_EXTRA[symbol]);
+		if (ioReader.bError || dist > outData.size() - inOutputStart)
+			return false;
+
+		// ġ 簡 Ƿ  byte 
+		const size_t from = outData.size() - dist;
+		for (size_t i = 0; i < length; ++i)
+		{
+			outData.push_back(outData[from + i]);
+		}
+	}
+}
+
+static bool InflateDynamic(FInflateBitReader& ioReader, size_t inOutputStart, std::string& outData)
+{
+	const int lengthCount = ioReader.Get(5) + 257;
+	const int distCount = ioReader.Get(5) + 1;
+	const int codeCount = ioReader.Get(4) + 4;
+
+	if (ioReader.bError || lengthCount > 286 || distCount > 30)
+		return false;
+
+	short lengths[286 + 30] = { 0, };
+	for (int i = 0; i < codeCount; ++i)
+	{
+		lengths[DEFLATE_CODE_LENGTH_ORDER[i]] = (short)ioReader.Get(3);
+	}
+
+	FInflateHuffman lengthCode;
+	FInflateHuffman distCode;
+
+	BuildInflateHuffman(lengthCode, lengths, 19);
+
+	int index = 0;
+	while (index < lengthCount + distCount)
+	{
+		int symbol = DecodeInflateSymbol(ioReader, lengthCode);
+		if (symbol < 0)
+			return false;
+
+		if (symbol < 16)
+		{
+			lengths[index++] = (short)symbol;
+			continue;
+		}
+
+		short length = 0;
+		int repeat;
+
+		if (symbol == 16)
+		{
+			if (index == 0)
+				return false;
+
+			length = lengths[index - 1];
+			repeat = 3 + ioReader.Get(2);
+		}
+		else if (symbol == 17)
+		{
+			repeat = 3 + ioReader.Get(3);
+		}
+		else
+		{
+			repeat = 11 + ioReader.Get(7);
+		}
+
+		if (ioReader.bError || index + repeat > lengthCount + distCount)
+			return false;
+
+		while (repeat-- > 0)
+		{
+			lengths[index++] = length;
+		}
+	}
+
+	if (lengths[256] == 0)
+		return false;
+
+	BuildInflateHuffman(lengthCode, lengths, lengthCount);
+	BuildInflateHuffman(distCode, lengths + lengthCount, distCount);
+
+	return InflateCodes(ioReader, lengthCode, distCode, inOutputStart, outData);
+}
+
+static bool InflateFixed(FInflateBitReader& ioReader, size_t inOutputStart, std::string& outData)
+{
+	static const struct FFixedCodes
+	{
+		FInflateHuffman LengthCode;
+		FInflateHuffman DistCode;
+
+		FFixedCodes()
+		{
+			short lengths[288];
+			for (int i = 0; i < 288; ++i)
+			{
+				lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+			}
+			BuildInflateHuffman(LengthCode, lengths, 288);
+
+			for (int i = 0; i < 30; ++i)
+			{
+				lengths[i] = 5;
+			}
+			BuildInflateHuffman(DistCode, lengths, 30);
+		}
+	} codes;
+
+	return InflateCodes(ioReader, codes.LengthCode, codes.DistCode, inOutputStart, outData);
+}
+
+static bool InflateStored(FInflateBitReader& ioReader, std::string& outData)
+{
+	// byte 
+	ioReader.Bits = 0;
+	ioReader.Count = 0;
+
+	if (ioReader.Pos + 4 > ioReader.Size)
+		return false;
+
+	const uint8_t* data = ioReader.Data + ioReader.Pos;
+	const size_t length = data[0] | (data[1] << 8);
+	const size_t lengthComplement = data[2] | (data[3] << 8);
+
+	if (length != (~lengthComplement & 0xffff) || ioReader.Pos + 4 + length > ioReader.Size)
+		return false;
+
+	outData.append((const char*)data + 4, length);
+	ioReader.Pos += 4 + length;
+
+	return true;
+}
+
+static bool Inflate(const uint8_t* inData, size_t inSize, std::string& outData)
+{
+	const size_t outputStart = outData.size();
+
+	FInflateBitReader reader(inData, inSize);
+
+	bool bLast = false;
+	while (!bLast)
+	{
+		bLast = reader.Get(1) != 0;
+		const int type = reader.Get(2);
+
+		if (reader.bError)
+			return false;
+
+		bool bResult;
+		switch (type)
+		{
+		case 0: bResult = InflateStored(reader, outData); break;
+		case 1: bResult = InflateFixed(reader, outputStart, outData); break;
+		case 2: bResult = InflateDynamic(reader, outputStart, outData); break;
+		default: bResult = false; break;
+		}
+
+		if (!bResult)
+			return false;
+	}
+
+	return true;
+}
+
+CBlockCompressedWriter::CBlockCompressedWriter() : SubmitCount(0), CompressCount(0), WrittenCount(0), bClosing(false)
+{
+}
+
+CBlockCompressedWriter::~CBlockCompressedWriter()
+{
+	if (IsOpen())
+	{
+		Close();
+	}
+}
+
+bool CBlockCompressedWriter::Open(const std::string & inFileName, int inThreadCount)
+{
+	if (IsOpen())
+	{
+		Close();
+	}
+
+	File.open(inFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!File.is_open())
+		return false;
+
+	if (inThreadCount <= 0)
+	{
+		inThreadCount = std::max((int)std::thread::hardware_concurrency(), 1);
+	}
+
+	SubmitCount = 0;
+	CompressCount = 0;
+	WrittenCount = 0;
+	bClosing = false;
+
+	Pending.clear();
+	Pending.reserve(BLOCK_COMPRESS_BLOCK_SIZE);
+
+	Blocks.clear();
+
+	// thread  ϳ worker  Write ϴ thread  
+	if (inThreadCount > 1)
+	{
+		Blocks.resize(inThreadCount * BLOCK_COMPRESS_BLOCKS_PER_WORKER);
+
+		for (int i = 0; i < inThreadCount; ++i)
+		{
+			Workers.emplace_back(&CBlockCompressedWriter::WorkerMain, this);
+		}
+	}
+
+	return true;
+}
+
+void CBlockCompressedWriter::WorkerMain()
+{
+	for (;;)
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		WorkAvailable.wait(lock, [this] { return bClosing || CompressCount < SubmitCount; });
+
+		if (CompressCount >= SubmitCount)
+			return;
+
+		FBlock& block = Blocks[CompressCount % Blocks.size()];
+		++CompressCount;
+
+		lock.unlock();
+
+		block.Output.clear();
+		CompressBlock(block.Input.data(), block.Input.size(), block.Output);
+
+		lock.lock();
+
+		block.bDone = true;
+		BlockDone.notify_all();
+	}
+}
+
+void CBlockCompressedWriter::WriteBlocks(std::unique_lock<std::mutex>& ioLock, size_t inMinWrittenCount)
+{
+	while (WrittenCount < SubmitCount)
+	{
+		FBlock& block = Blocks[WrittenCount % Blocks.size()];
+
+		if (!block.bDone)
+		{
+			if (WrittenCount >= inMinWrittenCount)
+				break;
+
+			BlockDone.wait(ioLock, [&block] { return block.bDone; });
+		}
+
+		//  block  ٽ Submit   worker  ǵ帮 ʴ´.
+		ioLock.unlock();
+		File.write(block.Output.data(), block.Output.size());
+		ioLock.lock();
+
+		++WrittenCount;
+	}
+}
+
+void CBlockCompressedWriter::SubmitPending()
+{
+	if (Workers.empty())
+	{
+		std::string member;
+		CompressBlock(Pending.data(), Pending.size(), member);
+
+		File.write(member.data(), member.size());
+		Pending.clear();
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	// ring      block    ٸ. ̹  block  ٷ .
+	WriteBlocks(lock, SubmitCount >= Blocks.size() ? SubmitCount - Blocks.size() + 1 : 0);
+
+	FBlock& block = Blocks[SubmitCount % Blocks.size()];
+	block.Input.swap(Pending);
+	block.bDone = false;
+	++SubmitCount;
+
+	lock.unlock();
+	WorkAvailable.notify_one();
+
+	Pending.clear();
+}
+
+void CBlockCompressedWriter::Write(const char * inData, size_t inSize)
+{
+	while (inSize > 0)
+	{
+		const size_t size = std::min(inSize, BLOCK_COMPRESS_BLOCK_SIZE - Pending.size());
+		Pending.append(inData, size);
+
+		inData += size;
+		inSize -= size;
+
+		if (Pending.size() >= BLOCK_COMPRESS_BLOCK_SIZE)
+		{
+			SubmitPending();
+		}
+	}
+}
+
+void CBlockCompressedWriter::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		bClosing = true;
+	}
+
+	WorkAvailable.notify_all();
+
+	for (auto& worker : Workers)
+	{
+		worker.join();
+	}
+
+	Workers.clear();
+}
+
+bool CBlockCompressedWriter::Close()
+{
+	if (!IsOpen())
+		return false;
+
+	if (!Pending.empty())
+	{
+		SubmitPending();
+	}
+
+	if (!Workers.empty())
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		WriteBlocks(lock, SubmitCount);
+	}
+
+	StopWorkers();
+
+	// EOF member ( block)
+	std::string member;
+	CompressBlock(nullptr, 0, member);
+	File.write(member.data(), member.size());
+
+	Blocks.clear();
+
+	const bool bResult = File.good();
+	File.close();
+
+	return bResult;
+}
+
+size_t CBlockCompressedWriter::GetBlockSize()
+{
+	return BLOCK_COMPRESS_BLOCK_SIZE;
+}
+
+bool CBlockCompressedWriter::IsCompressedFileName(const std::string & inFileName)
+{
+	static const char extension[] = ".gz";
+	const size_t length = sizeof(extension) - 1;
+
+	return inFileName.size() > length && _stricmp(inFileName.c_str() + inFileName.size() - length, extension) == 0;
+}
+
+bool CBlockCompressedWriter::WriteFile(const std::string & inFileName, const std::string & inContent, int inThreadCount)
+{
+	CBlockCompressedWriter writer;
+	if (!writer.Open(inFileName, inThreadCount))
+		return false;
+
+	writer.Write(inContent);
+
+	return writer.Close();
+}
+
+void CBlockCompressedWriter::CompressBlock(const char * inData, size_t inSize, std::string & outMember)
+{
+	const uint8_t* data = (const uint8_t*)inData;
+
+	const size_t memberStart = outMember.size();
+	outMember.append((const char*)GZIP_MEMBER_HEADER, GZIP_MEMBER_HEADER_SIZE);
+
+	DeflateBlock(data, inSize, outMember);
+
+	AppendUInt32(outMember, ComputeCrc32(data, inSize));
+	AppendUInt32(outMember, (uint32_t)inSize);
+
+	const size_t blockSize = outMember.size() - memberStart - 1;
+	outMember[memberStart + GZIP_MEMBER_HEADER_SIZE - 2] = (char)(blockSize & 0xff);
+	outMember[memberStart + GZIP_MEMBER_HEADER_SIZE - 1] = (char)((blockSize >> 8) & 0xff);
+}
+
+CBlockCompressedReader::CBlockCompressedReader() : UncompressedSize(0)
+{
+}
+
+bool CBlockCompressedReader::Open(const std::string & inFileName)
+{
+	Close();
+
+	if (!File.Open(inFileName))
+		return false;
+
+	const uint8_t* data = (const uint8_t*)File.GetData();
+	const size_t size = File.GetSize();
+
+	size_t offset = 0;
+	while (offset < size)
+	{
+		if (offset + GZIP_MEMBER_HEADER_SIZE + GZIP_MEMBER_TRAILER_SIZE > size || data[offset] != 0x1f || data[offset + 1] != 0x8b || data[offset + 2] != 8 || !(data[offset + 3] & 0x04))
+		{
+			Close();
+			return false;
+		}
+
+		// extra field  "BC" subfield  ã´.
+		const size_t extraSize = data[offset + 10] | (data[offset + 11] << 8);
+		const size_t extraEnd = offset + 12 + extraSize;
+
+		size_t blockSize = 0;
+		for (size_t field = offset + 12; field + 4 <= extraEnd && extraEnd <= size; )
+		{
+			const size_t fieldSize = data[field + 2] | (data[field + 3] << 8);
+
+			if (data[field] == 'B' && data[field + 1] == 'C' && fieldSize == 2 && field + 6 <= extraEnd)
+			{
+				blockSize = (data[field + 4] | (data[field + 5] << 8)) + 1;
+				break;
+			}
+
+			field += 4 + fieldSize;
+		}
+
+		if (blockSize < extraEnd - offset + GZIP_MEMBER_TRAILER_SIZE || offset + blockSize > size)
+		{
+			Close();
+			return false;
+		}
+
+		FBlockInfo block;
+		block.Offset = offset;
+		block.Size = blockSize;
+		block.UncompressedOffset = UncompressedSize;
+		block.UncompressedSize = ReadUInt32(data + offset + blockSize - 4);
+
+		//  member (EOF)  index   ʴ´.
+		if (block.UncompressedSize > 0)
+		{
+			Blocks.push_back(block);
+			UncompressedSize += block.UncompressedSize;
+		}
+
+		offset += blockSize;
+	}
+
+	return true;
+}
+
+void CBlockCompressedReader::Close()
+{
+	File.Close();
+	Blocks.clear();
+	UncompressedSize = 0;
+}
+
+bool CBlockCompressedReader::ReadBlock(size_t inBlockIndex, std::string & outData) const
+{
+	outData.clear();
+
+	if (inBlockIndex >= Blocks.size())
+		return false;
+
+	const FBlockInfo& block = Blocks[inBlockIndex];
+	outData.reserve(block.UncompressedSize);
+
+	return DecompressMember(File.GetData() + block.Offset, block.Size, outData) && outData.size() == block.UncompressedSize;
+}
+
+size_t CBlockCompressedReader::FindBlock(ULONGLONG inUncompressedOffset) const
+{
+	if (inUncompressedOffset >= UncompressedSize)
+		return Blocks.size();
+
+	// inUncompressedOffset  ڿ ϴ ù block  ٷ 
+	auto iter = std::upper_bound(Blocks.begin(), Blocks.end(), inUncompressedOffset,
+		[](ULONGLONG offset, const FBlockInfo& block) { return offset < block.UncompressedOffset; });
+
+	return (iter - Blocks.begin()) - 1;
+}
+
+bool CBlockCompressedReader::ReadAll(std::string & outData, int inThreadCount) const
+{
+	outData.clear();
+	outData.resize((size_t)UncompressedSize);
+
+	if (inThreadCount <= 0)
+	{
+		inThreadCount = std::max((int)std::thread::hardware_concurrency(), 1);
+	}
+
+	inThreadCount = (int)std::min((size_t)inThreadCount, std::max(Blocks.size(), (size_t)1));
+
+	std::atomic<size_t> nextBlock(0);
+	std::atomic<bool> bFailed(false);
+
+	// block   Ǯ ڸ 
+	auto decompress = [&]()
+	{
+		std::string block;
+
+		for (size_t i = nextBlock++; i < Blocks.size() && !bFailed; i = nextBlock++)
+		{
+			if (!ReadBlock(i, block))
+			{
+				bFailed = true;
+				return;
+			}
+
+			memcpy(&outData[(size_t)Blocks[i].UncompressedOffset], block.data(), block.size());
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < inThreadCount; ++i)
+	{
+		threads.emplace_back(decompress);
+	}
+
+	decompress();
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	if (bFailed)
+	{
+		outData.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool CBlockCompressedReader::DecompressMember(const char * inData, size_t inSize, std::string & outData)
+{
+	const uint8_t* data = (const uint8_t*)inData;
+
+	if (inSize < 10 + GZIP_MEMBER_TRAILER_SIZE || data[0] != 0x1f || data[1] != 0x8b || data[2] != 8)
+		return false;
+
+	const uint8_t flags = data[3];
+	size_t offset = 10;
+
+	// FEXTRA
+	if (flags & 0x04)
+	{
+		if (offset + 2 > inSize)
+			return false;
+
+		offset += 2 + (data[offset] | (data[offset + 1] << 8));
+	}
+
+	// FNAME, FCOMMENT : 0   ڿ
+	for (uint8_t flag = 0x08; flag <= 0x10; flag <<= 1)
+	{
+		if (flags & flag)
+		{
+			while (offset < inSize && data[offset] != 0)
+			{
+				++offset;
+			}
+			++offset;
+		}
+	}
+
+	// FHCRC
+	if (flags & 0x02)
+	{
+		offset += 2;
+	}
+
+	if (offset + GZIP_MEMBER_TRAILER_SIZE > inSize)
+		return false;
+
+	const size_t outputStart = outData.size();
+	const uint8_t* trailer = data + inSize - GZIP_MEMBER_TRAILER_SIZE;
+
+	if (!Inflate(data + offset, inSize - GZIP_MEMBER_TRAILER_SIZE - offset, outData))
+		return false;
+
+	const size_t outputSize = outData.size() - outputStart;
+
+	return ReadUInt32(trailer) == ComputeCrc32((const uint8_t*)outData.data() + outputStart, outputSize) && ReadUInt32(trailer + 4) == (uint32_t)outputSize;
+}
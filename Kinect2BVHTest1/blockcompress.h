@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "mappedfile.h"
+
+// block    gzip  (BGZF ).
+// Է 64 KB Ϸ ߶  ϳ gzip member  ,
+// member header  extra field "BC"   member ũ⸦   Ǯ ʰ block 踦 ã  ְ Ѵ.
+//    member  δ. member  ̾  ̹Ƿ Ϲ gzip ε ü Ǯ  ִ.
+
+// Ͽ   block  worker thread  ϰ,  block  Է  Ͽ .
+// Write  ȣϴ thread   ٸ ʰ     ִ.
+//   block  worker   踦    block    Write  ٸ. (memory )
+class CBlockCompressedWriter
+{
+	struct FBlock
+	{
+		std::string Input;
+		std::string Output;
+		bool bDone;
+	};
+
+	std::ofstream File;
+
+	std::vector<FBlock> Blocks;				// ring buffer. block ȣ % ũ
+	size_t SubmitCount;						// Write  ѱ block 
+	size_t CompressCount;					// worker   block 
+	size_t WrittenCount;					// Ͽ  block 
+	std::string Pending;					//  block ũⰡ   Է
+
+	std::vector<std::thread> Workers;
+	std::mutex Mutex;
+	std::condition_variable WorkAvailable;
+	std::condition_variable BlockDone;
+	bool bClosing;
+
+	CBlockCompressedWriter(const CBlockCompressedWriter&) = delete;
+	CBlockCompressedWriter& operator=(const CBlockCompressedWriter&) = delete;
+
+	void WorkerMain();
+	void SubmitPending();
+	void WriteBlocks(std::unique_lock<std::mutex>& ioLock, size_t inMinWrittenCount);
+	void StopWorkers();
+
+public:
+	CBlockCompressedWriter();
+	~CBlockCompressedWriter();
+
+	// inThreadCount :  worker . 0 ̸ hardware thread , 1 ̸ Write ϴ thread  ٷ 
+	bool Open(const std::string& inFileName, int inThreadCount = 0);
+
+	void Write(const char* inData, size_t inSize);
+	void Write(const std::string& inData) { Write(inData.data(), inData.size()); }
+
+	//  block    EOF member  δ.
+	bool Close();
+
+	bool IsOpen() const { return File.is_open(); }
+
+	// member ϳ ִ ִ Է ũ
+	static size_t GetBlockSize();
+
+	// ".gz"    ̸̸ ؼ .
+	static bool IsCompressedFileName(const std::string& inFileName);
+
+	// inContent ü block   ؼ inFileName  . (̸  )
+	static bool WriteFile(const std::string& inFileName, const std::string& inContent, int inThreadCount = 0);
+
+	// inSize  GetBlockSize . outMember ڿ member ϳ δ.
+	static void CompressBlock(const char* inData, size_t inSize, std::string& outMember);
+};
+
+// CBlockCompressedWriter (Ǵ bgzip)    block  д´.
+// Open  member header  block ũ⸸ 󰡸 index  ,  block   Ǯ  ִ.
+class CBlockCompressedReader
+{
+	struct FBlockInfo
+	{
+		size_t Offset;						//   member 
+		size_t Size;						// member ũ
+		ULONGLONG UncompressedOffset;
+		size_t UncompressedSize;
+	};
+
+	CMappedFile File;
+	std::vector<FBlockInfo> Blocks;
+	ULONGLONG UncompressedSize;
+
+	CBlockCompressedReader(const CBlockCompressedReader&) = delete;
+	CBlockCompressedReader& operator=(const CBlockCompressedReader&) = delete;
+
+public:
+	CBlockCompressedReader();
+
+	// BGZF  ƴ member   false
+	bool Open(const std::string& inFileName);
+	void Close();
+
+	size_t GetBlockCount() const { return Blocks.size(); }
+	ULONGLONG GetUncompressedSize() const { return UncompressedSize; }
+	ULONGLONG GetBlockUncompressedOffset(size_t inBlockIndex) const { return Blocks[inBlockIndex].UncompressedOffset; }
+	size_t GetBlockUncompressedSize(size_t inBlockIndex) const { return Blocks[inBlockIndex].UncompressedSize; }
+
+	//  Ǭ  inUncompressedOffset   ִ block (̰ų  GetBlockCount())
+	size_t FindBlock(ULONGLONG inUncompressedOffset) const;
+
+	// Open     ð (CMappedFile::GetLastWriteTime)
+	ULONGLONG GetLastWriteTime() const { return File.GetLastWriteTime(); }
+
+	// outData  block ϳ Ǭ  . CRC    false
+	bool ReadBlock(size_t inBlockIndex, std::string& outData) const;
+
+	//  block  inThreadCount  thread   Ǭ. (0 ̸ hardware thread )
+	bool ReadAll(std::string& outData, int inThreadCount = 0) const;
+
+	// gzip member ϳ Ǯ outData ڿ δ.
+	static bool DecompressMember(const char* inData, size_t inSize, std::string& outData);
+};
@@ -0,0 +1,213 @@
+#include "stdafx.h"
+
+#include <string.h>
+#include <fstream>
+#include <new>
+
+#include "bvhapi.h"
+#include "bvhexport.h"
+
+static_assert(KINECT2BVH_JOINT_TYPE_COUNT == JointType_Count, "Kinect JointType count");
+
+struct FKinect2BVHSession
+{
+	CBVH BVH;
+};
+
+// C ȣڿ ܰ Ѿ ʵ  entry  Ѵ.
+template<typename TFunc>
+static int CallSession(HKinect2BVHSession inSession, TFunc inFunc)
+{
+	if (inSession == nullptr)
+		return Kinect2BVH_InvalidArgument;
+
+	try
+	{
+		return inFunc(inSession->BVH);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return Kinect2BVH_OutOfMemory;
+	}
+	catch (...)
+	{
+		return Kinect2BVH_InternalError;
+	}
+}
+
+int Kinect2BVH_GetApiVersion(void)
+{
+	return KINECT2BVH_API_VERSION;
+}
+
+HKinect2BVHSession Kinect2BVH_CreateSession(const char * inRefPoseFileName)
+{
+	if (inRefPoseFileName == nullptr)
+		return nullptr;
+
+	// ImportRefPoseByBVHFile       Ƿ  Ȯ
+	{
+		std::ifstream file(inRefPoseFileName);
+		if (!file.good())
+			return nullptr;
+	}
+
+	try
+	{
+		FKinect2BVHSession* session = new FKinect2BVHSession();
+		session->BVH.ImportRefPoseByBVHFile(inRefPoseFileName);
+
+		if (session->BVH.GetJointCount() <= 0)
+		{
+			delete session;
+			return nullptr;
+		}
+
+		return session;
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void Kinect2BVH_DestroySession(HKinect2BVHSession inSession)
+{
+	delete inSession;
+}
+
+int Kinect2BVH_GetJointCount(HKinect2BVHSession inSession)
+{
+	return CallSession(inSession, [](CBVH& inBVH)
+	{
+		return inBVH.GetJointCount();
+	});
+}
+
+int Kinect2BVH_GetFrameRate(HKinect2BVHSession inSession)
+{
+	return CallSession(inSession, [](CBVH& inBVH)
+	{
+		return inBVH.GetExportFrameRate();
+	});
+}
+
+int Kinect2BVH_GetJointInfo(HKinect2BVHSession inSession, int inJointIndex, char * outName, int inNameSize, int * outParentIndex, int * outJointType)
+{
+	return CallSession(inSession, [=](CBVH& inBVH)
+	{
+		if (inJointIndex < 0 || inJointIndex >= inBVH.GetJointCount())
+			return (int)Kinect2BVH_InvalidArgument;
+
+		const FBVHJoint* bvhJoint = inBVH.GetSortedJointArray()[inJointIndex];
+
+		if (outName && inNameSize > 0)
+		{
+			strncpy_s(outName, inNameSize, bvhJoint->JointName.c_str(), _TRUNCATE);
+		}
+
+		if (outParentIndex)
+		{
+			*outParentIndex = bvhJoint->ParentJoint ? bvhJoint->ParentJoint->JointIndex : -1;
+		}
+
+		if (outJointType)
+		{
+			*outJointType = bvhJoint->KinectJointType < JointType_Count ? (int)bvhJoint->KinectJointType : -1;
+		}
+
+		return (int)Kinect2BVH_OK;
+	});
+}
+
+int Kinect2BVH_ReserveFrames(HKinect2BVHSession inSession, uint32_t inFrameCount)
+{
+	return CallSession(inSession, [=](CBVH& inBVH)
+	{
+		inBVH.ReserveFrames(inFrameCount);
+		return (int)Kinect2BVH_OK;
+	});
+}
+
+int Kinect2BVH_PushFrames(HKinect2BVHSession inSession, int inFrameCount, const uint32_t * inTimes, const float * inPositions, const float * inQuats, const uint32_t * inJointMasks)
+{
+	return CallSession(inSession, [=](CBVH& inBVH)
+	{
+		if (inFrameCount < 0 || (inFrameCount > 0 && inTimes == nullptr))
+			return (int)Kinect2BVH_InvalidArgument;
+
+		for (int i = 0; i < inFrameCount; ++i)
+		{
+			const uint32_t jointMask = inJointMasks ? inJointMasks[i] : 0xffffffff;
+
+			// live callback    : position  rotation
+			inBVH.Begin(inTimes[i]);
+
+			if (inPositions)
+			{
+				const float* positions = inPositions + (size_t)i * JointType_Count * 3;
+
+				for (int j = 0; j < JointType_Count; ++j)
+				{
+					if (jointMask & (1u << j))
+					{
+						inBVH.AddJointPositionValue((JointType)j, XMVectorSet(positions[j * 3], positions[j * 3 + 1], positions[j * 3 + 2], 0.0f));
+					}
+				}
+			}
+
+			if (inQuats)
+			{
+				const float* quats = inQuats + (size_t)i * JointType_Count * 4;
+
+				for (int j = 0; j < JointType_Count; ++j)
+				{
+					if (jointMask & (1u << j))
+					{
+						inBVH.AddJointRotationValue((JointType)j, XMVectorSet(quats[j * 4], quats[j * 4 + 1], quats[j * 4 + 2], quats[j * 4 + 3]));
+					}
+				}
+			}
+
+			inBVH.End();
+		}
+
+		return inFrameCount;
+	});
+}
+
+int Kinect2BVH_PullFrames(HKinect2BVHSession inSession, int inQuatType, int inMaxFrameCount, float * outQuats, uint32_t * outTimes)
+{
+	return CallSession(inSession, [=](CBVH& inBVH)
+	{
+		if (inMaxFrameCount < 0 || (inMaxFrameCount > 0 && outQuats == nullptr) ||
+			(inQuatType != Kinect2BVH_LocalQuat && inQuatType != Kinect2BVH_DevQuat))
+		{
+			return (int)Kinect2BVH_InvalidArgument;
+		}
+
+		static_assert(sizeof(uint32_t) == sizeof(DWORD), "timestamp type");
+
+		return (int)inBVH.PullPendingFrames(outQuats, (DWORD*)outTimes, (size_t)inMaxFrameCount, inQuatType == Kinect2BVH_DevQuat);
+	});
+}
+
+int Kinect2BVH_ExportFile(HKinect2BVHSession inSession, const char * inFileName)
+{
+	return CallSession(inSession, [=](CBVH& inBVH)
+	{
+		if (inFileName == nullptr)
+			return (int)Kinect2BVH_InvalidArgument;
+
+		return inBVH.ExportFile(inFileName) ? (int)Kinect2BVH_OK : (int)Kinect2BVH_FileError;
+	});
+}
+
+int Kinect2BVH_ClearFrames(HKinect2BVHSession inSession)
+{
+	return CallSession(inSession, [](CBVH& inBVH)
+	{
+		inBVH.ClearFrames();
+		return (int)Kinect2BVH_OK;
+	});
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+/*
+ * Kinect2BVH C API
+ *
+ * CBVH  DLL    C ABI. (Kinect2BVH project  build)
+ * DLL  build   KINECT2BVH_EXPORTS,  binary  static    KINECT2BVH_STATIC  Ѵ.
+ *
+ * 迭  ȣϴ  ޸𸮸 ״ а . (߰  )
+ * frame      ѱ Ƿ ȣ  frame  .
+ */
+
+#include <stdint.h>
+
+#if defined(KINECT2BVH_EXPORTS)
+#define KINECT2BVH_API __declspec(dllexport)
+#elif defined(KINECT2BVH_STATIC)
+#define KINECT2BVH_API
+#else
+#define KINECT2BVH_API __declspec(dllimport)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KINECT2BVH_API_VERSION			1
+
+/* Kinect JointType  (push 迭 frame  joint ) */
+#define KINECT2BVH_JOINT_TYPE_COUNT		25
+
+typedef struct FKinect2BVHSession* HKinect2BVHSession;
+
+enum EKinect2BVHResult
+{
+	Kinect2BVH_OK = 0,
+	Kinect2BVH_InvalidArgument = -1,
+	Kinect2BVH_OutOfMemory = -2,
+	Kinect2BVH_InternalError = -3,
+	Kinect2BVH_FileError = -4,		/*     */
+};
+
+enum EKinect2BVHQuatType
+{
+	Kinect2BVH_LocalQuat = 0,		/* parent  ȸ */
+	Kinect2BVH_DevQuat = 1,			/* ref pose   ȸ (BVH MOTION ) */
+};
+
+KINECT2BVH_API int Kinect2BVH_GetApiVersion(void);
+
+/* inRefPoseFileName  HIERARCHY  session . ϸ NULL */
+KINECT2BVH_API HKinect2BVHSession Kinect2BVH_CreateSession(const char* inRefPoseFileName);
+KINECT2BVH_API void Kinect2BVH_DestroySession(HKinect2BVHSession inSession);
+
+/* skeleton : joint index  pull 迭 joint  (parent  ׻ ) */
+KINECT2BVH_API int Kinect2BVH_GetJointCount(HKinect2BVHSession inSession);
+KINECT2BVH_API int Kinect2BVH_GetFrameRate(HKinect2BVHSession inSession);
+
+/* outName  null  . outParentIndex  root ̸ -1, outJointType  Kinect ̸ ƴϸ -1 (NULL ̸  ) */
+KINECT2BVH_API int Kinect2BVH_GetJointInfo(HKinect2BVHSession inSession, int inJointIndex, char* outName, int inNameSize, int* outParentIndex, int* outJointType);
+
+/*  push  frame ŭ ̸ Ҵ */
+KINECT2BVH_API int Kinect2BVH_ReserveFrames(HKinect2BVHSession inSession, uint32_t inFrameCount);
+
+/*
+ * inFrameCount  frame  ð  Է. Է frame  Ǵ EKinect2BVHResult ȯ
+ *   inTimes      [inFrameCount]										milliseconds
+ *   inPositions  [inFrameCount][KINECT2BVH_JOINT_TYPE_COUNT][3]		camera space (m). NULL ̸ Է 
+ *   inQuats      [inFrameCount][KINECT2BVH_JOINT_TYPE_COUNT][4]		x y z w absolute orientation. zero quaternion   
+ *   inJointMasks [inFrameCount]										bit j : JointType j  frame  . NULL ̸  
+ */
+KINECT2BVH_API int Kinect2BVH_PushFrames(HKinect2BVHSession inSession, int inFrameCount, const uint32_t* inTimes,
+	const float* inPositions, const float* inQuats, const uint32_t* inJointMasks);
+
+/*
+ *  pull  resampling (GetFrameRate )   ְ  frame  ִ inMaxFrameCount  ޴´.
+ *  frame  Ǵ EKinect2BVHResult ȯ.  frame   ȣ⿡ ̾ ޴´.
+ *   outQuats [inMaxFrameCount][JointCount][4]	x y z w
+ *   outTimes [inMaxFrameCount]					milliseconds (capture timestamp). NULL ̸  
+ */
+KINECT2BVH_API int Kinect2BVH_PullFrames(HKinect2BVHSession inSession, int inQuatType, int inMaxFrameCount, float* outQuats, uint32_t* outTimes);
+
+/* ݱ Է frame ü BVH Ϸ  */
+KINECT2BVH_API int Kinect2BVH_ExportFile(HKinect2BVHSession inSession, const char* inFileName);
+
+/* Է frame   . (skeleton  ) */
+KINECT2BVH_API int Kinect2BVH_ClearFrames(HKinect2BVHSession inSession);
+
+#ifdef __cplusplus
+}
+#endif
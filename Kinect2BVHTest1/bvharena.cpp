@@ -0,0 +1,133 @@
+#include "stdafx.h"
+
+#include <stdint.h>
+
+#include "bvharena.h"
+
+CBVHArena::CBVHArena(size_t inBlockSize) : UsedBlocks(nullptr), UsedBlocksTail(nullptr), FreeBlocks(nullptr), Cursor(nullptr), Limit(nullptr), BlockSize(inBlockSize), BlockCount(0), UsedBytes(0)
+{
+}
+
+CBVHArena::~CBVHArena()
+{
+	Release();
+}
+
+void CBVHArena::NextBlock(size_t inMinSize)
+{
+	FBlock* block = nullptr;
+
+	//  Ͽ  ū ù block   (Reserve   block   ⼭ ã  ִ)
+	FBlock** link = &FreeBlocks;
+	while (*link && (*link)->Size < inMinSize)
+	{
+		link = &(*link)->Next;
+	}
+
+	if (*link)
+	{
+		block = *link;
+		*link = block->Next;
+	}
+	else
+	{
+		size_t size = inMinSize > BlockSize ? inMinSize : BlockSize;
+
+		block = static_cast<FBlock*>(::operator new(sizeof(FBlock) + size));
+		block->Size = size;
+
+		++BlockCount;
+	}
+
+	block->Next = UsedBlocks;
+	UsedBlocks = block;
+
+	if (UsedBlocksTail == nullptr)
+		UsedBlocksTail = block;
+
+	Cursor = reinterpret_cast<char*>(block + 1);
+	Limit = Cursor + block->Size;
+}
+
+void* CBVHArena::Allocate(size_t inSize, size_t inAlignment)
+{
+	uintptr_t address = (reinterpret_cast<uintptr_t>(Cursor) + inAlignment - 1) & ~(uintptr_t)(inAlignment - 1);
+
+	if (Cursor == nullptr || address + inSize > reinterpret_cast<uintptr_t>(Limit))
+	{
+		//  б 
+		NextBlock(inSize + inAlignment);
+
+		address = (reinterpret_cast<uintptr_t>(Cursor) + inAlignment - 1) & ~(uintptr_t)(inAlignment - 1);
+	}
+
+	Cursor = reinterpret_cast<char*>(address + inSize);
+	UsedBytes += inSize;
+
+	return reinterpret_cast<void*>(address);
+}
+
+void CBVHArena::Reserve(size_t inSize, size_t inMaxAllocationSize)
+{
+	size_t available = Limit - Cursor;
+	if (available > inMaxAllocationSize)
+		available -= inMaxAllocationSize;
+	else
+		available = 0;
+
+	for (FBlock* block = FreeBlocks; block; block = block->Next)
+	{
+		if (block->Size > inMaxAllocationSize)
+			available += block->Size - inMaxAllocationSize;
+	}
+
+	if (available >= inSize)
+		return;
+
+	// block 迡    ϳ block  ޾Ƽ    տ д.
+	size_t size = inSize + inMaxAllocationSize;
+
+	FBlock* block = static_cast<FBlock*>(::operator new(sizeof(FBlock) + size));
+	block->Size = size;
+	block->Next = FreeBlocks;
+	FreeBlocks = block;
+
+	++BlockCount;
+}
+
+void CBVHArena::Reset()
+{
+	if (UsedBlocks)
+	{
+		UsedBlocksTail->Next = FreeBlocks;
+		FreeBlocks = UsedBlocks;
+	}
+
+	UsedBlocks = nullptr;
+	UsedBlocksTail = nullptr;
+
+	Cursor = nullptr;
+	Limit = nullptr;
+
+	UsedBytes = 0;
+}
+
+void CBVHArena::Release()
+{
+	Reset();
+
+	FreeBlockList(FreeBlocks);
+	FreeBlocks = nullptr;
+
+	BlockCount = 0;
+}
+
+void CBVHArena::FreeBlockList(FBlock * inBlock)
+{
+	while (inBlock)
+	{
+		FBlock* next = inBlock->Next;
+		::operator delete(inBlock);
+		inBlock = next;
+	}
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <stddef.h>
+#include <new>
+#include <vector>
+
+// arena    ޸ ( )
+template<typename T>
+struct TBVHArray
+{
+	T* Data;
+	size_t Count;
+
+	TBVHArray() : Data(nullptr), Count(0) {}
+	TBVHArray(T* inData, size_t inCount) : Data(inData), Count(inCount) {}
+
+	size_t size() const { return Count; }
+	bool empty() const { return Count == 0; }
+
+	T* data() { return Data; }
+	const T* data() const { return Data; }
+
+	T& operator[](size_t inIndex) { return Data[inIndex]; }
+	const T& operator[](size_t inIndex) const { return Data[inIndex]; }
+
+	T* begin() { return Data; }
+	T* end() { return Data + Count; }
+	const T* begin() const { return Data; }
+	const T* end() const { return Data + Count; }
+};
+
+// session  monotonic arena
+// block  ̾ ̸ pointer  о Ҵϰ,    ʴ´.
+// Reset  block  heap   ʰ   űǷ (O(1))  session   Ҵ  ۵ȴ.
+// Ҹڸ ȣ Ƿ trivially destructible  type  ƾ Ѵ.
+class CBVHArena
+{
+	struct FBlock
+	{
+		FBlock* Next;
+		size_t Size;				// header   ũ
+	};
+
+	FBlock* UsedBlocks;				//   block (   block)
+	FBlock* UsedBlocksTail;
+	FBlock* FreeBlocks;				// Reset   block
+
+	char* Cursor;
+	char* Limit;
+
+	size_t BlockSize;
+	size_t BlockCount;				// heap   block 
+	size_t UsedBytes;
+
+	void NextBlock(size_t inMinSize);
+	static void FreeBlockList(FBlock* inBlock);
+
+	CBVHArena(const CBVHArena&) = delete;
+	CBVHArena& operator=(const CBVHArena&) = delete;
+
+public:
+	static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+	explicit CBVHArena(size_t inBlockSize = DEFAULT_BLOCK_SIZE);
+	~CBVHArena();
+
+	void* Allocate(size_t inSize, size_t inAlignment = 16);
+
+	// ⺻ ڷ ʱȭ inCount 
+	template<typename T>
+	TBVHArray<T> AllocateArray(size_t inCount)
+	{
+		T* data = static_cast<T*>(Allocate(sizeof(T) * inCount, alignof(T)));
+		for (size_t i = 0; i < inCount; ++i)
+		{
+			new (&data[i]) T();
+		}
+
+		return TBVHArray<T>(data, inCount);
+	}
+
+	//  inSize byte  heap Ҵ  Allocate   ֵ block  ̸ ޾ д.
+	// inMaxAllocationSize :   Ҵϴ ִ ũ ( ). block    ִ  Ѵ.
+	void Reserve(size_t inSize, size_t inMaxAllocationSize);
+
+	//  Ҵ ȿȭѴ. block  
+	void Reset();
+
+	// block  heap  ȯ
+	void Release();
+
+	size_t GetBlockCount() const { return BlockCount; }
+	size_t GetUsedBytes() const { return UsedBytes; }
+};
+
+template<typename TOwner, typename TValue>
+class TBVHChunkedIterator
+{
+	TOwner* Owner;
+	size_t Index;
+
+public:
+	TBVHChunkedIterator(TOwner* inOwner, size_t inIndex) : Owner(inOwner), Index(inIndex) {}
+
+	TValue& operator*() const { return (*Owner)[Index]; }
+	TValue* operator->() const { return &(*Owner)[Index]; }
+
+	TBVHChunkedIterator& operator++() { ++Index; return *this; }
+	bool operator!=(const TBVHChunkedIterator& inOther) const { return Index != inOther.Index; }
+};
+
+// arena  ChunkSize  ޾  迭
+// ũⰡ þ  Ҹ ű Ƿ  ּҰ ȴ.
+// clear  chunk ϸ Ƿ ޸𸮴 arena  Reset   ؾ Ѵ.
+template<typename T, size_t ChunkSize = 256>
+class TBVHChunkedArray
+{
+	CBVHArena& Arena;
+	std::vector<T*> Chunks;
+	size_t Count;
+
+public:
+	typedef TBVHChunkedIterator<TBVHChunkedArray, T> iterator;
+	typedef TBVHChunkedIterator<const TBVHChunkedArray, const T> const_iterator;
+
+	explicit TBVHChunkedArray(CBVHArena& inArena) : Arena(inArena), Count(0) {}
+
+	// inCount  arena Ҵ  ߰  ֵ chunk  ̸ ޾ д.
+	void reserve(size_t inCount)
+	{
+		Chunks.reserve((inCount + ChunkSize - 1) / ChunkSize);
+
+		while (Chunks.size() * ChunkSize < inCount)
+		{
+			Chunks.push_back(static_cast<T*>(Arena.Allocate(sizeof(T) * ChunkSize, alignof(T))));
+		}
+	}
+
+	// ⺻ ڷ ʱȭ Ҹ  ߰
+	T& AddDefaulted()
+	{
+		reserve(Count + 1);
+
+		T* value = &Chunks[Count / ChunkSize][Count % ChunkSize];
+		new (value) T();
+		++Count;
+
+		return *value;
+	}
+
+	void clear()
+	{
+		Chunks.clear();
+		Count = 0;
+	}
+
+	size_t size() const { return Count; }
+	bool empty() const { return Count == 0; }
+
+	T& operator[](size_t inIndex) { return Chunks[inIndex / ChunkSize][inIndex % ChunkSize]; }
+	const T& operator[](size_t inIndex) const { return Chunks[inIndex / ChunkSize][inIndex % ChunkSize]; }
+
+	T& back() { return (*this)[Count - 1]; }
+	const T& back() const { return (*this)[Count - 1]; }
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, Count); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, Count); }
+};
@@ -1,14 +1,87 @@
 #include "stdafx.h"
 
 #include <assert.h>
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 #include <string>
 #include <list>
+#include <memory>
+#include <random>
 
 #include <iostream>
 #include <fstream>
 
 #include "bvhexport.h"
+#include "retarget.h"
+#include "lodexport.h"
+#include "exportplan.h"
+#include "capturejournal.h"
+#include "posepublisher.h"
+#include "cliptransform.h"
+#include "rotationcache.h"
 #include "quaternion.h"
+#include "blockcompress.h"
+
+// ExportFile   ϸ MOTION  ̸ŭ    (̸  writer)  ѱ. (byte)
+static const size_t BVH_EXPORT_FLUSH_SIZE = 1 << 20;
+
+// ExportFile    ϳ : frame loop  Text    BVH_EXPORT_FLUSH_SIZE  Ƿ
+// clip ̿ ϰ ׸ŭ ޸𸮸 . ".gz" ̸ loop    worker thread  block  Ѵ.
+struct FBVHExportOutput
+{
+	std::string Text;
+	std::ofstream File;
+	std::unique_ptr<CBlockCompressedWriter> CompressedWriter;
+
+	bool Open(const std::string& inFileName, int inJointCount)
+	{
+		// joint  channel 3 ,  ϳ 뷫 12 
+		Text.reserve(BVH_EXPORT_FLUSH_SIZE + (inJointCount * 3 + 3) * 12);
+
+		if (CBlockCompressedWriter::IsCompressedFileName(inFileName))
+		{
+			CompressedWriter.reset(new CBlockCompressedWriter());
+			return CompressedWriter->Open(inFileName);
+		}
+
+		File.open(inFileName.c_str());
+		return File.is_open();
+	}
+
+	// bAll  ƴϸ BVH_EXPORT_FLUSH_SIZE ŭ   . (  ̸ )
+	void Flush(bool bAll)
+	{
+		if (!bAll && Text.size() < BVH_EXPORT_FLUSH_SIZE)
+			return;
+
+		if (CompressedWriter && CompressedWriter->IsOpen())
+		{
+			CompressedWriter->Write(Text);
+		}
+		else if (File.is_open())
+		{
+			File.write(Text.data(), Text.size());
+		}
+
+		Text.clear();
+	}
+
+	bool Close()
+	{
+		Flush(true);
+
+		if (CompressedWriter)
+			return CompressedWriter->IsOpen() && CompressedWriter->Close();
+
+		if (!File.is_open())
+			return false;
+
+		File.close();
+		return !File.fail();
+	}
+};
 
 void QuaternionToEulerAngles(const XMVECTOR& inQuat, XMVECTOR& outEulerianAngles)
 {
@@ -20,6 +93,154 @@ void QuaternionToEulerAngles(const XMVECTOR& inQuat, XMVECTOR& outEulerianAngles
 	outEulerianAngles = { (float)eulerxyz[0], (float)eulerxyz[1], (float)eulerxyz[2], 0.0f };
 }
 
+void QuaternionToEulerAngles(const XMVECTOR& inQuat, XMVECTOR& outEulerianAngles, RotSeq inRotSeq)
+{
+	double eulerxyz[3];
+	Quaternion quaternion = inQuat;
+	quaternion.normalize();
+	quaternion2Euler(quaternion, eulerxyz, inRotSeq);
+
+	outEulerianAngles = { (float)eulerxyz[0], (float)eulerxyz[1], (float)eulerxyz[2], 0.0f };
+}
+
+template<typename TMath>
+static void QuaternionToEulerAnglesFloat(const XMVECTOR& inQuat, XMVECTOR& outEulerianAngles, RotSeq inRotSeq)
+{
+	QuaternionF quaternion = { XMVectorGetX(inQuat), XMVectorGetY(inQuat), XMVectorGetZ(inQuat), XMVectorGetW(inQuat) };
+
+	const float norm = TMath::Sqrt(quaternion.x*quaternion.x + quaternion.y*quaternion.y + quaternion.z*quaternion.z + quaternion.w*quaternion.w);
+	quaternion.x /= norm;
+	quaternion.y /= norm;
+	quaternion.z /= norm;
+	quaternion.w /= norm;
+
+	float eulerxyz[3];
+	if (!quaternion2Euler<TMath>(quaternion, eulerxyz, inRotSeq))
+	{
+		// gimbal lock ó : float δ ù°/°   Ŀ.
+		QuaternionToEulerAngles(inQuat, outEulerianAngles, inRotSeq);
+		return;
+	}
+
+	outEulerianAngles = { eulerxyz[0], eulerxyz[1], eulerxyz[2], 0.0f };
+}
+
+void QuaternionToEulerAngles(const XMVECTOR& inQuat, XMVECTOR& outEulerianAngles, RotSeq inRotSeq, EEulerPrecision inPrecision)
+{
+	switch (inPrecision)
+	{
+	case EEulerPrecision_Float:
+		QuaternionToEulerAnglesFloat<FEulerMathFloat>(inQuat, outEulerianAngles, inRotSeq);
+		break;
+
+	case EEulerPrecision_Fast:
+		QuaternionToEulerAnglesFloat<FEulerMathFast>(inQuat, outEulerianAngles, inRotSeq);
+		break;
+
+	default:
+		QuaternionToEulerAngles(inQuat, outEulerianAngles, inRotSeq);
+		break;
+	}
+}
+
+// MeasureEulerPrecisionError    (sample 1000000 )    
+const float EULER_PRECISION_MAX_ERROR[EEulerPrecision_Count] = { 0.0f, 0.0004f, 0.0005f };
+
+EEulerPrecision SelectEulerPrecision(float inToleranceDegrees)
+{
+	//  tier ϼ .
+	for (int precision = EEulerPrecision_Count - 1; precision > EEulerPrecision_Exact; --precision)
+	{
+		if (EULER_PRECISION_MAX_ERROR[precision] <= inToleranceDegrees)
+			return (EEulerPrecision)precision;
+	}
+
+	return EEulerPrecision_Exact;
+}
+
+// quaternion2Euler  ȸ ٽ .    (zyx ...)  res[2], res[1], res[0]  ù ,
+//    (zyz ...)  res[0], res[1], res[2]  ù  Ѵ.
+static const char* const ROT_SEQ_AXES[xzx + 1] = { "zyx", "zyz", "zxy", "zxz", "yxz", "yxy", "yzx", "yzy", "xyz", "xyx", "xzy", "xzx" };
+
+Quaternion EulerToQuaternion(const double inEuler[3], RotSeq inRotSeq)
+{
+	const char* axes = ROT_SEQ_AXES[inRotSeq];
+	const bool bThreeAxis = axes[0] != axes[2];
+
+	Quaternion result;
+	for (int i = 0; i < 3; ++i)
+	{
+		const double angle = bThreeAxis ? inEuler[2 - i] : inEuler[i];
+
+		Quaternion axisRotation(0.0, 0.0, 0.0, cos(angle*0.5));
+		const double s = sin(angle*0.5);
+		if (axes[i] == 'x')
+			axisRotation.x = s;
+		else if (axes[i] == 'y')
+			axisRotation.y = s;
+		else
+			axisRotation.z = s;
+
+		result = result*axisRotation;
+	}
+
+	return result;
+}
+
+double MeasureEulerPrecisionError(EEulerPrecision inPrecision, int inSampleCount, unsigned int inSeed)
+{
+	std::mt19937 random(inSeed);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+	double maxError = 0.0;
+
+	for (int i = 0; i < inSampleCount; ++i)
+	{
+		XMVECTOR quat = XMQuaternionNormalize(XMVectorSet(uniform(random), uniform(random), uniform(random), uniform(random)));
+
+		// 1/4  Ư ó :      +-90 ,    0 Ǵ 180  α
+		if (i % 4 == 0)
+		{
+			const RotSeq sampleRotSeq = (RotSeq)(i / 4 % (xzx + 1));
+			const bool bThreeAxis = ROT_SEQ_AXES[sampleRotSeq][0] != ROT_SEQ_AXES[sampleRotSeq][2];
+
+			double euler[3] = { uniform(random)*XM_PI, 0.0, uniform(random)*XM_PI };
+			if (bThreeAxis)
+				euler[1] = (uniform(random) < 0.0f ? -XM_PIDIV2 : XM_PIDIV2) + uniform(random)*0.01;
+			else
+				euler[1] = (uniform(random) < 0.0f ? 0.0 : XM_PI) + uniform(random)*0.01;
+
+			const Quaternion sample = EulerToQuaternion(euler, sampleRotSeq);
+			quat = XMVectorSet((float)sample.x, (float)sample.y, (float)sample.z, (float)sample.w);
+		}
+
+		for (int rotSeq = 0; rotSeq <= xzx; ++rotSeq)
+		{
+			XMVECTOR exact, approx;
+			QuaternionToEulerAngles(quat, exact, (RotSeq)rotSeq);
+			QuaternionToEulerAngles(quat, approx, (RotSeq)rotSeq, inPrecision);
+
+			const double exactEuler[3] = { XMVectorGetX(exact), XMVectorGetY(exact), XMVectorGetZ(exact) };
+			const double approxEuler[3] = { XMVectorGetX(approx), XMVectorGetY(approx), XMVectorGetZ(approx) };
+
+			Quaternion q0 = EulerToQuaternion(exactEuler, (RotSeq)rotSeq);
+			Quaternion q1 = EulerToQuaternion(approxEuler, (RotSeq)rotSeq);
+
+			//  ȸ   : inverse(q0)*q1  ȸ (acos  0 ó е )
+			q0.x = -q0.x;
+			q0.y = -q0.y;
+			q0.z = -q0.z;
+			const Quaternion delta = q0*q1;
+
+			const double error = rad2deg(2.0*atan2(sqrt(delta.x*delta.x + delta.y*delta.y + delta.z*delta.z), fabs(delta.w)));
+			if (error > maxError)
+				maxError = error;
+		}
+	}
+
+	return maxError;
+}
+
 void CBVH::ResetJointParentIndex()
 {
 	if (RootJoint)
@@ -76,6 +297,7 @@ void CBVH::ResetJointParentIndex()
 	RootJoint->GatherJoints(SortedJointArray);
 
 	IndexConvertTable.resize(JointCount);
+	RawMissingJoints.assign(JointCount, 0);
 
 	index = 0;
 	for (auto const& value : SortedJointArray)
@@ -87,155 +309,143 @@ void CBVH::ResetJointParentIndex()
 
 void CBVH::GenerateLocalRotation()
 {
-	// SortedJointArray, RawFrames    ϴ.
+	// Ϸ  frame    ̹ 
+	for (size_t i = RawFrames.GetSpilledCount(); i < RawFrames.size(); ++i)
+	{
+		SolveLocalRotation(RawFrames.GetResident(i).FrameInfo.data());
+	}
+}
+
+void CBVH::SolveLocalRotation(FBVHJointTransform* ioFrameInfo) const
+{
+	// SortedJointArray, ioFrameInfo    ϴ.
 
-	int frameIndex = 0;
-	for (auto& frame : RawFrames)
+	for (int index = 0; index < JointCount; ++index)
 	{
-		int index = 0;
-		for (auto& frameInfo : frame.FrameInfo)
+		auto& frameInfo = ioFrameInfo[index];
+
+		FBVHJoint* bvhJoint = SortedJointArray[index];
+		if (bvhJoint)
 		{
-			FBVHJoint* bvhJoint = SortedJointArray[index];
-			if (bvhJoint)
+			if (bvhJoint->ParentJoint)
 			{
-				if (bvhJoint->ParentJoint)
-				{
-					auto parentIndex = bvhJoint->ParentJoint->JointIndex;
-					auto& parentFrameInfo = frame.FrameInfo[parentIndex];
+				auto parentIndex = bvhJoint->ParentJoint->JointIndex;
+				auto& parentFrameInfo = ioFrameInfo[parentIndex];
 
-					assert(index > parentIndex);
+				assert(index > parentIndex);
 
-					if (frameInfo.Initialized)
-					{
-						// local*parent.world = world
-						// local = world*inverse(parent.world)
-						frameInfo.WorldQuat = XMQuaternionNormalize(frameInfo.WorldQuat);
-						frameInfo.LocalQuat = XMQuaternionMultiply(frameInfo.WorldQuat, XMQuaternionInverse(parentFrameInfo.WorldQuat));
-						frameInfo.LocalQuat = XMQuaternionNormalize(frameInfo.LocalQuat);
-
-						if (XMVectorGetX(frameInfo.LocalQuat) == 0.0f &&
-							XMVectorGetY(frameInfo.LocalQuat) == 0.0f &&
-							XMVectorGetZ(frameInfo.LocalQuat) == 0.0f &&
-							XMVectorGetW(frameInfo.LocalQuat) == 0.0f)
-						{
-							int a = 0;
-						}
-					}
-					else
-					{
-						frameInfo.LocalQuat = bvhJoint->RefQuat;
-						frameInfo.WorldQuat = frameInfo.LocalQuat*parentFrameInfo.WorldQuat;
-					}
+				if (frameInfo.Initialized)
+				{
+					// local*parent.world = world
+					// local = world*inverse(parent.world)
+					frameInfo.WorldQuat = XMQuaternionNormalize(frameInfo.WorldQuat);
+					frameInfo.LocalQuat = XMQuaternionMultiply(frameInfo.WorldQuat, XMQuaternionInverse(parentFrameInfo.WorldQuat));
+					frameInfo.LocalQuat = XMQuaternionNormalize(frameInfo.LocalQuat);
 				}
 				else
 				{
-					if (frameInfo.Initialized)
-					{
-						frameInfo.WorldQuat = XMQuaternionNormalize(frameInfo.WorldQuat);
-						frameInfo.LocalQuat = XMQuaternionNormalize(frameInfo.WorldQuat);
-					}
-					else
-					{
-						frameInfo.WorldQuat = bvhJoint->RefQuat;
-						frameInfo.LocalQuat = bvhJoint->RefQuat;
-					}
+					frameInfo.LocalQuat = bvhJoint->RefQuat;
+					frameInfo.WorldQuat = frameInfo.LocalQuat*parentFrameInfo.WorldQuat;
+				}
+			}
+			else
+			{
+				if (frameInfo.Initialized)
+				{
+					frameInfo.WorldQuat = XMQuaternionNormalize(frameInfo.WorldQuat);
+					frameInfo.LocalQuat = XMQuaternionNormalize(frameInfo.WorldQuat);
+				}
+				else
+				{
+					frameInfo.WorldQuat = bvhJoint->RefQuat;
+					frameInfo.LocalQuat = bvhJoint->RefQuat;
 				}
 			}
-
-			//frameInfo.LocalQuat = frameInfo.WorldQuat;
-
-			++index;
 		}
 
-		frameIndex++;
+		//frameInfo.LocalQuat = frameInfo.WorldQuat;
 	}
 }
 
-void CBVH::GenerateEvenSpacedFrameData()
+void CBVH::InterpolateFrame(const FBVHJointTransform * inRawFrame0, const FBVHJointTransform * inRawFrame1, float inInterpTime, const XMVECTOR & inRootOrigin, FBVHJointTransform * outFrameInfo) const
 {
-	if (RawFrames.size() < 2)
-		return;
-
-	Frames.clear();
-
-	int currentFrameIndex = 0;
-	DWORD initialFrameTime = RawFrames[0].ElapseTime;
-	DWORD currentFrameTime = RawFrames[0].ElapseTime;
-
-	for (size_t i = 0; i < RawFrames.size() - 1; ++i)
+	if (inInterpTime == 0.0f)
 	{
-		auto& rawframe0 = RawFrames[i];
-		auto& rawframe1 = RawFrames[i + 1];
-
-		auto frameCount = Frames.size();
-
-		if (rawframe0.ElapseTime == currentFrameTime)
+		// raw frame  ð Ȯ ġ
+		for (int j = 0; j < JointCount; ++j)
 		{
-			Frames.resize(frameCount + 1);
-
-			Frames[frameCount].ElapseTime = currentFrameTime - initialFrameTime;
-			Frames[frameCount].FrameInfo = rawframe0.FrameInfo;
-
-			for (size_t j = 0; j < Frames[frameCount].FrameInfo.size(); ++j)
-			{
-				auto& value = Frames[frameCount].FrameInfo[j];
-
-
+			outFrameInfo[j].LocalQuat = inRawFrame0[j].LocalQuat;
+		}
+	}
+	else
+	{
+		for (int j = 0; j < JointCount; ++j)
+		{
+			outFrameInfo[j].LocalQuat = XMQuaternionSlerp(inRawFrame0[j].LocalQuat, inRawFrame1[j].LocalQuat, inInterpTime);
+		}
+	}
 
-				// deviation from refPose
-				auto& joint = SortedJointArray[j];
+	outFrameInfo[0].Position = XMVectorLerp(inRawFrame0[0].Position, inRawFrame1[0].Position, inInterpTime) - inRootOrigin;
+}
 
-				// localQuat = devQuat*refPoseQuat;
-				// devQuat = localQuat*inverse(refPoseQuat)
-				value.LocalQuat = rawframe0.FrameInfo[j].LocalQuat;
-				value.DevQuat = XMQuaternionMultiply(value.LocalQuat, joint->InvRefQuat);
+void CBVH::ApplyFrameTransform(FBVHJointTransform * ioFrameInfo, const CClipTransform * inClipTransform, bool bRootTranslation) const
+{
+	for (int j = 0; j < JointCount; ++j)
+	{
+		// localQuat = devQuat*refPoseQuat;
+		// devQuat = localQuat*inverse(refPoseQuat)
+		ioFrameInfo[j].DevQuat = XMQuaternionMultiply(ioFrameInfo[j].LocalQuat, SortedJointArray[j]->InvRefQuat);
+	}
 
-				// quaternion to eulerian angles
-				QuaternionToEulerAngles(value.DevQuat, value.Rotation);
-				//QuaternionToEulerAngles(value.LocalQuat, value.Rotation);
-			}
+	if (inClipTransform)
+	{
+		inClipTransform->Apply(ioFrameInfo);
 
-			++currentFrameIndex;
-			currentFrameTime = initialFrameTime + (currentFrameIndex) * 1000 / ExportFrameRate;
+		if (bRootTranslation)
+		{
+			inClipTransform->ApplyPositions(&ioFrameInfo[0].Position, 1, 1);
 		}
+	}
+}
 
+void CBVH::MakeRotationCacheKey(FRotationCacheKey & outKey) const
+{
+	ULONGLONG skeletonHash = CRotationCache::HASH_SEED;
 
-		while(rawframe0.ElapseTime <= currentFrameTime && currentFrameTime < rawframe1.ElapseTime)
-		{
-			auto frameCount = Frames.size();
-
-			Frames.resize(frameCount + 1);
+	for (int j = 0; j < JointCount; ++j)
+	{
+		const FBVHJoint* joint = SortedJointArray[j];
 
-			float interpTime = (float)(currentFrameTime - rawframe0.ElapseTime)/ (float)(rawframe1.ElapseTime - rawframe0.ElapseTime);
-			
-			auto& dest = Frames[frameCount].FrameInfo;
-			Frames[frameCount].ElapseTime = currentFrameTime - initialFrameTime;
+		const int parentIndex = joint->ParentJoint ? joint->ParentJoint->JointIndex : -1;
+		skeletonHash = CRotationCache::Hash(skeletonHash, &parentIndex, sizeof(parentIndex));
 
-			for (size_t j = 0; j < rawframe0.FrameInfo.size(); ++j)
-			{
-				auto& rawJoint0 = rawframe0.FrameInfo[j];
-				auto& rawJoint1 = rawframe1.FrameInfo[j];
+		// Է  ִ frame  LocalQuat ( child  parent WorldQuat)  RefQuat  ä.
+		if (RawMissingJoints[j])
+		{
+			skeletonHash = CRotationCache::Hash(skeletonHash, joint->RefQuat.m128_f32, sizeof(float) * 4);
+		}
+	}
 
-				FBVHJointTransform interpTransform;
-				interpTransform.LocalQuat = XMQuaternionSlerp(rawJoint0.LocalQuat, rawJoint1.LocalQuat, interpTime);
+	outKey.CaptureHash = RawInputHash;
+	outKey.SkeletonHash = skeletonHash;
+	outKey.JointCount = (DWORD)JointCount;
+	outKey.FrameRate = (DWORD)ExportFrameRate;
+	outKey.BeginTime = ExportBeginTime;
+	outKey.EndTime = ExportEndTime;
+}
 
-				// deviation from refPose
-				auto& joint = SortedJointArray[j];
+size_t CBVH::GetEvenSpacedFrameCount(int inFrameRate) const
+{
+	if (RawFrames.size() < 2)
+		return 0;
 
-				// localQuat = devQuat*refPoseQuat;
-				// devQuat = localQuat*inverse(refPoseQuat)
-				interpTransform.DevQuat = XMQuaternionMultiply(interpTransform.LocalQuat, joint->InvRefQuat);
+	DWORD beginTime, endTime;
+	GetExportTimeRange(beginTime, endTime);
 
-				// quaternion to eulerian angles
-				QuaternionToEulerAngles(interpTransform.DevQuat, interpTransform.Rotation);
-				//QuaternionToEulerAngles(interpTransform.LocalQuat, interpTransform.Rotation);
-				dest.push_back(interpTransform);
-			}
+	CBVHResampleCursor cursor(inFrameRate, beginTime, endTime);
+	cursor.Start(RawFrames.GetFrame(0).ElapseTime);
 
-			++currentFrameIndex;
-			currentFrameTime = initialFrameTime + (currentFrameIndex) * 1000 / ExportFrameRate;
-		}
-	}
+	return cursor.GetFrameCount(RawFrames.GetFrame(RawFrames.size() - 1).ElapseTime);
 }
 
 void CBVH::MakeNameJointTypeMap()
@@ -275,16 +485,18 @@ JointType CBVH::GetJointType(const std::string & inJointName)
 		return iter->second;
 	}
 
-	return _JointType();
+	return JointType_Count;
 }
 
-CBVH::CBVH() : NumberOfFrames(0), NumberOfFramesInSecond(0), CurrentElapseTime(INVALID_ELAPSE_TIME), JointCount(0), RootJoint(nullptr), CurrentRawBVHFrame(nullptr)
+CBVH::CBVH() : NumberOfFrames(0), NumberOfFramesInSecond(0), CurrentElapseTime(INVALID_ELAPSE_TIME), ExportBeginTime(INVALID_ELAPSE_TIME), ExportEndTime(INVALID_ELAPSE_TIME), JointCount(0), RootJoint(nullptr), RawFrames(SessionArena), bRawFrameSpillFailed(false), CurrentRawBVHFrame(nullptr), EmitBeginTime(INVALID_ELAPSE_TIME), EmitRawIndex(0), EmittedFrameCount(0), EmitRootOrigin(XMVectorZero()), bExportRootTranslation(false), EulerPrecision(EEulerPrecision_Exact), ClipTransform(nullptr), RawInputHash(CRotationCache::HASH_SEED), bRawInputHashValid(true), bLastExportFromCache(false)
 {
 
 }
 
 CBVH::~CBVH()
 {
+	StopJournal();
+
 	if (RootJoint)
 	{
 		delete RootJoint;
@@ -295,12 +507,28 @@ void CBVH::Begin(DWORD inMilliSeconds)
 {
 	CurrentElapseTime = inMilliSeconds;
 
-	auto count = RawFrames.size();
-	RawFrames.resize(count + 1);
+	// resampling  raw frame  ð  Ƿ ð ǵư frame  . (CBVHStreamExporter  )
+	if (RawFrames.size() > 0 && inMilliSeconds < RawFrames.GetFrame(RawFrames.size() - 1).ElapseTime)
+	{
+		CurrentRawBVHFrame = nullptr;
+		return;
+	}
+
+	// memory     frame  local rotation  Ǯ Ϸ   ڸ Ѵ.
+	if (RawFrames.IsFull())
+	{
+		SolveLocalRotation(RawFrames.GetOldestResident().FrameInfo.data());
+
+		if (!RawFrames.SpillOldest())
+		{
+			// Ͽ    ̹ frame  , export  з ˸.
+			bRawFrameSpillFailed = true;
+			CurrentRawBVHFrame = nullptr;
+			return;
+		}
+	}
 
-	CurrentRawBVHFrame = &RawFrames[count];
-	CurrentRawBVHFrame->ElapseTime = CurrentElapseTime;
-	CurrentRawBVHFrame->FrameInfo.resize(JointCount);
+	CurrentRawBVHFrame = &RawFrames.Add(CurrentElapseTime, JointCount);
 }
 
 void CBVH::AddJointRotationValue(JointType inKinectJointType, const XMVECTOR& inQuat)
@@ -308,6 +536,8 @@ void CBVH::AddJointRotationValue(JointType inKinectJointType, const XMVECTOR& in
 	if (CurrentRawBVHFrame && inKinectJointType < JointType_Count)
 	{
 		int SortedIndex = IndexConvertTable[inKinectJointType];
+		if (SortedIndex < 0)
+			return;
 
 		if (XMVectorGetX(inQuat) == 0.0f &&
 			XMVectorGetY(inQuat) == 0.0f &&
@@ -330,6 +560,9 @@ void CBVH::AddJointPositionValue(JointType inKinectJointType, const XMVECTOR& in
 	if (CurrentRawBVHFrame && inKinectJointType < JointType_Count)
 	{
 		int SortedIndex = IndexConvertTable[inKinectJointType];
+		if (SortedIndex < 0)
+			return;
+
 		CurrentRawBVHFrame->FrameInfo[SortedIndex].Initialized = true;
 		CurrentRawBVHFrame->FrameInfo[SortedIndex].Position = inPosition;
 
@@ -339,7 +572,210 @@ void CBVH::AddJointPositionValue(JointType inKinectJointType, const XMVECTOR& in
 
 void CBVH::End()
 {
+	// rotation cache key : local rotation  Ǯ  Է  
+	// cache    hash  ǳʶٰ,  frame  Ƿ  session  hash   ̻  ʴ´.
+	if (CurrentRawBVHFrame && (int)RawMissingJoints.size() == JointCount)
+	{
+		if (RotationCacheDirectory.empty())
+		{
+			bRawInputHashValid = false;
+		}
+
+		if (bRawInputHashValid)
+		{
+			RawInputHash = CRotationCache::Hash(RawInputHash, &CurrentRawBVHFrame->ElapseTime, sizeof(DWORD));
+		}
+
+		for (int j = 0; j < JointCount; ++j)
+		{
+			const auto& frameInfo = CurrentRawBVHFrame->FrameInfo[j];
+
+			if (!frameInfo.Initialized)
+			{
+				RawMissingJoints[j] = 1;
+			}
+
+			if (!bRawInputHashValid)
+				continue;
+
+			const char initialized = frameInfo.Initialized ? 1 : 0;
+			RawInputHash = CRotationCache::Hash(RawInputHash, &initialized, sizeof(initialized));
+
+			if (frameInfo.Initialized)
+			{
+				RawInputHash = CRotationCache::Hash(RawInputHash, frameInfo.WorldQuat.m128_f32, sizeof(float) * 4);
+			}
+		}
+
+		if (bRawInputHashValid)
+		{
+			RawInputHash = CRotationCache::Hash(RawInputHash, CurrentRawBVHFrame->FrameInfo[0].Position.m128_f32, sizeof(float) * 3);
+		}
+	}
+
+	// snapshot    ֵ  frame  ݿ  ¸  ѱ.
+	if (Journal && CurrentRawBVHFrame)
+	{
+		FCaptureJournalState state;
+		state.RawInputHash = RawInputHash;
+		state.RawInputHashValid = bRawInputHashValid ? 1 : 0;
+		state.EmitRawIndex = EmitRawIndex;
+		state.EmittedFrameCount = EmittedFrameCount;
+		state.EmitBeginTime = EmitBeginTime;
+		memcpy(state.EmitRootOrigin, EmitRootOrigin.m128_f32, sizeof(state.EmitRootOrigin));
+
+		Journal->Append(*CurrentRawBVHFrame, state, RawMissingJoints.data());
+	}
+
+	CurrentElapseTime = INVALID_ELAPSE_TIME;
+}
+
+void CBVH::ClearFrames()
+{
+	StopJournal();
+
+	RawFrames.Clear();
+	bRawFrameSpillFailed = false;
+
+	SessionArena.Reset();
+
+	CurrentRawBVHFrame = nullptr;
 	CurrentElapseTime = INVALID_ELAPSE_TIME;
+
+	EmitBeginTime = INVALID_ELAPSE_TIME;
+	EmitRawIndex = 0;
+	EmittedFrameCount = 0;
+
+	RawInputHash = CRotationCache::HASH_SEED;
+	bRawInputHashValid = true;
+	std::fill(RawMissingJoints.begin(), RawMissingJoints.end(), 0);
+}
+
+void CBVH::ReserveFrames(size_t inFrameCount)
+{
+	RawFrames.Reserve(inFrameCount, JointCount);
+}
+
+bool CBVH::SetRawFrameMemoryBudget(size_t inBudget, const std::string & inSpillFileName)
+{
+	return RawFrames.SetMemoryBudget(inBudget, inSpillFileName);
+}
+
+bool CBVH::StartJournal(const std::string & inFileName)
+{
+	StopJournal();
+
+	std::unique_ptr<CCaptureJournal> journal(new CCaptureJournal());
+	if (!journal->Open(inFileName, JointCount))
+		return false;
+
+	Journal = std::move(journal);
+
+	return true;
+}
+
+void CBVH::StopJournal()
+{
+	if (Journal)
+	{
+		Journal->Close();
+		Journal.reset();
+	}
+}
+
+bool CBVH::ResumeJournal(const std::string & inFileName)
+{
+	ClearFrames();
+
+	// Է  ״ ǵǷ local rotation  export (Ǵ  emit)  ٽ ϸ ȴ.
+	//  snapshot  frame  RawFrames  ֱ⸸ ϰ, hash  emit  ´ snapshot  Ѵ.
+	// End    frame  ٽ ģ.
+	FCaptureJournalResumeInfo resumeInfo;
+
+	auto restoreSnapshotState = [this, &resumeInfo]()
+	{
+		const auto& state = resumeInfo.SnapshotState;
+
+		RawInputHash = state.RawInputHash;
+		bRawInputHashValid = state.RawInputHashValid != 0;
+		EmitRawIndex = (size_t)state.EmitRawIndex;
+		EmittedFrameCount = (size_t)state.EmittedFrameCount;
+		EmitBeginTime = state.EmitBeginTime;
+		EmitRootOrigin = XMVectorSet(state.EmitRootOrigin[0], state.EmitRootOrigin[1], state.EmitRootOrigin[2], 0.0f);
+
+		if ((int)RawMissingJoints.size() == JointCount)
+		{
+			std::copy(resumeInfo.SnapshotMissingJoints.begin(), resumeInfo.SnapshotMissingJoints.end(), RawMissingJoints.begin());
+		}
+	};
+
+	bool bResult = CCaptureJournal::Read(inFileName, JointCount, [&](ULONGLONG inFrameIndex, DWORD inElapseTime, const FCaptureJournalJoint* inJoints)
+	{
+		const bool bReplay = inFrameIndex >= resumeInfo.SnapshotFrameCount;
+
+		if (resumeInfo.SnapshotFrameCount > 0 && inFrameIndex == resumeInfo.SnapshotFrameCount)
+		{
+			restoreSnapshotState();
+		}
+
+		Begin(inElapseTime);
+
+		if (CurrentRawBVHFrame)
+		{
+			for (int j = 0; j < JointCount; ++j)
+			{
+				auto& frameInfo = CurrentRawBVHFrame->FrameInfo[j];
+
+				memcpy(frameInfo.WorldQuat.m128_f32, inJoints[j].WorldQuat, sizeof(inJoints[j].WorldQuat));
+				memcpy(frameInfo.Position.m128_f32, inJoints[j].Position, sizeof(inJoints[j].Position));
+				frameInfo.Initialized = inJoints[j].Initialized != 0;
+			}
+		}
+
+		if (bReplay)
+		{
+			End();
+		}
+		else
+		{
+			CurrentRawBVHFrame = nullptr;
+			CurrentElapseTime = INVALID_ELAPSE_TIME;
+		}
+	}, resumeInfo);
+
+	if (!bResult)
+		return false;
+
+	if (resumeInfo.SnapshotFrameCount > 0 && resumeInfo.SnapshotFrameCount == resumeInfo.FrameCount)
+	{
+		restoreSnapshotState();
+	}
+
+	std::unique_ptr<CCaptureJournal> journal(new CCaptureJournal());
+	if (!journal->Open(inFileName, JointCount, &resumeInfo))
+		return false;
+
+	Journal = std::move(journal);
+
+	return true;
+}
+
+void CBVH::SetExportTimeRange(DWORD inBeginTime, DWORD inEndTime)
+{
+	ExportBeginTime = inBeginTime;
+	ExportEndTime = inEndTime;
+}
+
+void CBVH::ResetExportTimeRange()
+{
+	ExportBeginTime = INVALID_ELAPSE_TIME;
+	ExportEndTime = INVALID_ELAPSE_TIME;
+}
+
+void CBVH::GetExportTimeRange(DWORD & outBeginTime, DWORD & outEndTime) const
+{
+	outBeginTime = ExportBeginTime == INVALID_ELAPSE_TIME ? 0 : ExportBeginTime;
+	outEndTime = ExportEndTime;
 }
 
 void CBVH::ImportRefPoseByBVHFile(const std::string & inFileName)
@@ -480,11 +916,16 @@ void CBVH::ImportRefPoseByBVHFile(const std::string & inFileName)
 	JointCount = (int)SortedJointArray.size();
 
 	// Kinect  JointType  JointArray Index ȯ
-	IndexConvertTable.resize(JointCount);
+	// Kinect ̸ ƴ joint (retarget  target rig)  table   ʴ´.
+	IndexConvertTable.assign(JointType_Count, -1);
+	RawMissingJoints.assign(JointCount, 0);
 
 	for (auto const& value : SortedJointArray)
 	{
-		IndexConvertTable[value->KinectJointType] = value->JointIndex;
+		if (value->KinectJointType < JointType_Count)
+		{
+			IndexConvertTable[value->KinectJointType] = value->JointIndex;
+		}
 
 		OutputDebugStringA(value->JointName.c_str());
 		OutputDebugStringA(" ");
@@ -650,8 +1091,11 @@ void CBVH::DataValidationTest()
 	// AddJointRotationValue  AddJointPositionValue     ´ Ȯ
 	////////////////////////////////////////////////////////////////////////////////////
 
-	for (auto& rawFrame : RawFrames)
+	// Ϸ  frame  LocalQuat   Ƿ ޸𸮿 ִ frame  Ȯ
+	for (size_t frameIndex = RawFrames.GetSpilledCount(); frameIndex < RawFrames.size(); ++frameIndex)
 	{
+		auto& rawFrame = RawFrames.GetResident(frameIndex);
+
 		for (auto i = 0;i < rawFrame.FrameInfo.size(); ++i)
 		{
 			auto& frameInfo = rawFrame.FrameInfo[i];
@@ -771,50 +1215,476 @@ void CBVH::AddJointOffsetValue(int inJointIndex, float inX, float inY, float inZ
 	}
 }
 
-void CBVH::ExportFile(const std::string & inFileName)
+bool CBVH::ExportFile(const std::string & inFileName)
 {
-	GenerateLocalRotation();
+	bLastExportFromCache = false;
+
+	if (RootJoint == nullptr)
+		return false;
+
+	FRotationCacheKey cacheKey;
+	std::string cacheFileName;
+
+	if (!RotationCacheDirectory.empty() && bRawInputHashValid && RawFrames.size() >= 2 && (int)RawMissingJoints.size() == JointCount)
+	{
+		MakeRotationCacheKey(cacheKey);
+		cacheFileName = CRotationCache::GetFileName(RotationCacheDirectory, cacheKey);
+	}
+
+	CRotationCacheReader cacheReader;
+	bLastExportFromCache = !cacheFileName.empty() && cacheReader.Open(cacheFileName, cacheKey);
+
+	size_t frameCount;
+
+	if (bLastExportFromCache)
+	{
+		frameCount = cacheReader.GetFrameCount();
+	}
+	else
+	{
+		GenerateLocalRotation();
+
+		frameCount = GetEvenSpacedFrameCount(ExportFrameRate);
+	}
 
 	DataValidationTest();
 
-	GenerateEvenSpacedFrameData();
+	//    ϳ  ϸ  (  )
+	bool bResult = true;
 
-	if (RootJoint)
-	{ 
-		std::string content;
+	FBVHExportOutput output;
+	bResult = output.Open(inFileName, JointCount) && bResult;
+
+	ExportHeader(output.Text, frameCount);
+
+	// retarget  rig   frame loop   .
+	std::vector<FBVHExportOutput> retargetOutputs(RetargetOutputs.size());
+	std::vector<std::vector<FBVHJointTransform>> retargetFrames(RetargetOutputs.size());
+
+	for (size_t i = 0; i < RetargetOutputs.size(); ++i)
+	{
+		retargetFrames[i].resize(RetargetOutputs[i].Map->GetTargetJointCount());
+
+		bResult = retargetOutputs[i].Open(RetargetOutputs[i].FileName, (int)retargetFrames[i].size()) && bResult;
+		RetargetOutputs[i].TargetRig->ExportHeader(retargetOutputs[i].Text, frameCount);
+	}
+
+	// LOD µ  loop  (frame   ش frame )
+	std::vector<FBVHExportOutput> lodOutputs(LODOutputs.size());
+	std::vector<std::vector<FBVHJointTransform>> lodFrames(LODOutputs.size());
+
+	for (size_t i = 0; i < LODOutputs.size(); ++i)
+	{
+		lodFrames[i].resize(LODOutputs[i].Map->GetJointCount());
+
+		bResult = lodOutputs[i].Open(LODOutputs[i].FileName, (int)lodFrames[i].size()) && bResult;
+		LODOutputs[i].Map->ExportHeader(lodOutputs[i].Text, frameCount, ExportFrameRate);
+	}
+
+	// resampling  frame  ׾  ʰ ϳ  ¿ .
+	std::vector<FBVHJointTransform> row(JointCount);
+	size_t frameIndex = 0;
+
+	auto exportFrame = [&]()
+	{
+		ApplyFrameTransform(row.data(), ClipTransform, bExportRootTranslation);
+
+		for (auto& value : row)
+		{
+			// quaternion to eulerian angles
+			QuaternionToEulerAngles(value.DevQuat, value.Rotation, zyx, EulerPrecision);
+		}
+
+		FBVHFrame::ExportMOTION(row.data(), row.size(), output.Text, false, bExportRootTranslation);
+		output.Flush(false);
+
+		for (size_t i = 0; i < RetargetOutputs.size(); ++i)
+		{
+			auto& targetFrame = retargetFrames[i];
+
+			RetargetOutputs[i].Map->Apply(row.data(), targetFrame.data());
+
+			for (auto& targetValue : targetFrame)
+			{
+				QuaternionToEulerAngles(targetValue.DevQuat, targetValue.Rotation, zyx, EulerPrecision);
+			}
+
+			FBVHFrame::ExportMOTION(targetFrame.data(), targetFrame.size(), retargetOutputs[i].Text, false);
+			retargetOutputs[i].Flush(false);
+		}
+
+		for (size_t i = 0; i < LODOutputs.size(); ++i)
+		{
+			if (!LODOutputs[i].Map->IsExportedFrame(frameIndex))
+				continue;
+
+			auto& lodFrame = lodFrames[i];
+
+			LODOutputs[i].Map->Apply(row.data(), lodFrame.data(), EulerPrecision);
+
+			FBVHFrame::ExportMOTION(lodFrame.data(), lodFrame.size(), lodOutputs[i].Text, false, bExportRootTranslation);
+			lodOutputs[i].Flush(false);
+		}
+
+		++frameIndex;
+	};
+
+	if (bLastExportFromCache)
+	{
+		for (size_t i = 0; i < frameCount; ++i)
+		{
+			cacheReader.Read(i, row.data());
+			exportFrame();
+		}
+	}
+	else
+	{
+		// cache  ClipTransform  ϱ  LocalQuat  root ̵ frame  ̾ .
+		CRotationCacheWriter cacheWriter;
+		const bool bWriteCache = !cacheFileName.empty() && cacheWriter.Open(cacheFileName, cacheKey);
+
+		const XMVECTOR rootOrigin = RawFrames.size() > 0 ? RawFrames.GetFrame(0).FrameInfo[0].Position : XMVectorZero();
+
+		const size_t writtenCount = ForEachEvenSpacedFrame(ExportFrameRate, [&](DWORD inElapseTime, const FRawBVHFrame& rawframe0, const FRawBVHFrame& rawframe1, float interpTime)
+		{
+			InterpolateFrame(rawframe0.FrameInfo.data(), rawframe1.FrameInfo.data(), interpTime, rootOrigin, row.data());
+
+			if (bWriteCache)
+			{
+				cacheWriter.Write(inElapseTime, row.data());
+			}
+
+			exportFrame();
+		});
+
+		assert(writtenCount == frameCount);
+
+		if (bWriteCache)
+		{
+			cacheWriter.Close();
+		}
+	}
+
+	bResult = output.Close() && bResult;
+
+	for (auto& retargetOutput : retargetOutputs)
+	{
+		bResult = retargetOutput.Close() && bResult;
+	}
+
+	for (auto& lodOutput : lodOutputs)
+	{
+		bResult = lodOutput.Close() && bResult;
+	}
+
+	//  raw frame     frame   ִ.
+	return bResult && !bRawFrameSpillFailed;
+}
+
+void CBVH::AddRetargetOutput(const CBVH & inTargetRig, const CRetargetMap & inMap, const std::string & inFileName)
+{
+	FBVHRetargetOutput output = { &inTargetRig, &inMap, inFileName };
+	RetargetOutputs.push_back(output);
+}
+
+void CBVH::ClearRetargetOutputs()
+{
+	RetargetOutputs.clear();
+}
+
+void CBVH::AddLODOutput(const CBVHLODMap & inMap, const std::string & inFileName)
+{
+	FBVHLODOutput output = { &inMap, inFileName };
+	LODOutputs.push_back(output);
+}
+
+void CBVH::ClearLODOutputs()
+{
+	LODOutputs.clear();
+}
+
+bool CBVH::SetClipTransform(const CClipTransform * inTransform)
+{
+	if (inTransform && inTransform->GetJointCount() != JointCount)
+		return false;
+
+	ClipTransform = inTransform;
+
+	return true;
+}
+
+int CBVH::FindSortedJointIndex(const std::string & inJointName) const
+{
+	for (auto const& value : SortedJointArray)
+	{
+		if (value->JointName == inJointName)
+			return value->JointIndex;
+	}
+
+	return -1;
+}
+
+void CBVH::ExportHeader(std::string & outData, size_t inFrameCount) const
+{
+	ExportHeader(outData, inFrameCount, ExportFrameRate, "Xrotation Yrotation Zrotation");
+}
+
+void CBVH::ExportHeader(std::string & outData, size_t inFrameCount, int inFrameRate, const char * inRotationChannels) const
+{
+	if (RootJoint == nullptr)
+		return;
+
+	RootJoint->ExportHIERARCHY(outData, 0, inRotationChannels);
+
+	outData.append("MOTION\n");
+
+	outData.append("Frames: ");
+	outData.append(std::to_string(inFrameCount));
+	outData.append("\n");
+
+	outData.append("Frame Time: ");
+	outData.append(std::to_string(1.0f/(float)inFrameRate));
+	outData.append("\n");
+}
+
+bool CBVH::ExportFiles(const CBVHExportPlan & inPlan)
+{
+	const auto& targets = inPlan.GetTargets();
+
+	for (auto const& target : targets)
+	{
+		if (!CBVHExportPlan::IsValidTarget(target))
+			return false;
+	}
+
+	if (RootJoint == nullptr)
+		return false;
+
+	GenerateLocalRotation();
+
+	std::vector<bool> exported(targets.size(), false);
+	bool bResult = true;
+
+	const XMVECTOR rootOrigin = RawFrames.size() > 0 ? RawFrames.GetFrame(0).FrameInfo[0].Position : XMVectorZero();
+
+	std::vector<FBVHJointTransform> row(JointCount);
+	std::vector<XMVECTOR> eulerAngles[xzx + 1];
+
+	// frame rate   target    resampling  Ѵ.
+	for (size_t i = 0; i < targets.size(); ++i)
+	{
+		if (exported[i])
+			continue;
 
-		RootJoint->ExportHIERARCHY(content);
+		const int frameRate = targets[i].FrameRate;
 
-		content.append("MOTION\n");
+		std::vector<std::unique_ptr<CBVHExportSink>> sinks;
+		bool bUsedRotSeq[xzx + 1] = { false, };
 
-		content.append("Frames: ");
-		content.append(std::to_string(Frames.size()));
-		content.append("\n");
+		for (size_t j = i; j < targets.size(); ++j)
+		{
+			if (!exported[j] && targets[j].FrameRate == frameRate)
+			{
+				exported[j] = true;
+				sinks.emplace_back(new CBVHExportSink(targets[j]));
+				bUsedRotSeq[targets[j].RotationOrder] = true;
+				eulerAngles[targets[j].RotationOrder].resize(JointCount);
+			}
+		}
 
-		content.append("Frame Time: ");
-		content.append(std::to_string(1.0f/(float)ExportFrameRate));
-		content.append("\n");
+		// header  Frames   ˾ƾ frame  ٷ   ִ.
+		const size_t frameCount = GetEvenSpacedFrameCount(frameRate);
 
-		for (auto& value : Frames)
+		for (auto& sink : sinks)
 		{
-			value.ExportMOTION(content, false);
+			if (!sink->Begin(*this, frameCount))
+			{
+				//  frame rate  ̹  ϵ header   ä  ʴ´.
+				for (auto& openedSink : sinks)
+				{
+					openedSink->Abort();
+				}
+
+				return false;
+			}
 		}
 
-		std::ofstream myfile;
-		myfile.open(inFileName.c_str());
-		myfile << content;
+		const size_t writtenCount = ForEachEvenSpacedFrame(frameRate, [&](DWORD inElapseTime, const FRawBVHFrame& rawframe0, const FRawBVHFrame& rawframe1, float interpTime)
+		{
+			InterpolateFrame(rawframe0.FrameInfo.data(), rawframe1.FrameInfo.data(), interpTime, rootOrigin, row.data());
+			ApplyFrameTransform(row.data(), ClipTransform, bExportRootTranslation);
+
+			// ȸ    ȯ
+			for (int rotSeq = 0; rotSeq <= xzx; ++rotSeq)
+			{
+				if (!bUsedRotSeq[rotSeq])
+					continue;
+
+				for (int j = 0; j < JointCount; ++j)
+				{
+					QuaternionToEulerAngles(row[j].DevQuat, eulerAngles[rotSeq][j], (RotSeq)rotSeq, EulerPrecision);
+				}
+			}
+
+			for (auto& sink : sinks)
+			{
+				sink->WriteFrame(eulerAngles[sink->GetTarget().RotationOrder].data(), JointCount, bExportRootTranslation ? &row[0].Position : nullptr);
+			}
+		});
+
+		assert(writtenCount == frameCount);
 
-		myfile.close();
+		for (auto& sink : sinks)
+		{
+			if (!sink->End())
+				bResult = false;
+		}
 	}
 
+	return bResult && !bRawFrameSpillFailed;
+}
 
+size_t CBVH::EmitPendingMotion(std::string & outData)
+{
+	return ForEachPendingFrame(true, SIZE_MAX, [this, &outData](DWORD inElapseTime)
+	{
+		FBVHFrame::ExportMOTION(EmitRow.data(), EmitRow.size(), outData, false, bExportRootTranslation);
+	});
 }
 
-FBVHJoint::FBVHJoint() : ParentJoint(nullptr), KinectJointType(JointType_Count)
+size_t CBVH::PublishPendingPoses()
 {
+	return ForEachPendingFrame(false, SIZE_MAX, [](DWORD inElapseTime) {});
 }
 
-FBVHJoint::FBVHJoint(FBVHJoint* inParentJoint) : ParentJoint(inParentJoint)
+size_t CBVH::PullPendingFrames(float * outQuats, DWORD * outElapseTimes, size_t inMaxCount, bool bDevQuat)
+{
+	size_t frameIndex = 0;
+
+	return ForEachPendingFrame(false, inMaxCount, [&](DWORD inElapseTime)
+	{
+		float* quats = outQuats + frameIndex * JointCount * 4;
+
+		for (int j = 0; j < JointCount; ++j)
+		{
+			const XMVECTOR& quat = bDevQuat ? EmitRow[j].DevQuat : EmitRow[j].LocalQuat;
+			memcpy(quats + j * 4, quat.m128_f32, sizeof(float) * 4);
+		}
+
+		if (outElapseTimes)
+		{
+			outElapseTimes[frameIndex] = inElapseTime;
+		}
+
+		++frameIndex;
+	});
+}
+
+bool CBVH::StartPosePublisher(const std::string & inName)
+{
+	StopPosePublisher();
+
+	std::unique_ptr<CPosePublisher> publisher(new CPosePublisher());
+	if (!publisher->Create(inName, *this))
+		return false;
+
+	PosePublisher = std::move(publisher);
+
+	return true;
+}
+
+void CBVH::StopPosePublisher()
+{
+	PosePublisher.reset();
+}
+
+template<typename TFunc>
+size_t CBVH::ForEachPendingFrame(bool bEulerAngles, size_t inMaxCount, TFunc inFunc)
+{
+	const size_t rawFrameCount = RawFrames.size();
+	if (rawFrameCount < 2 || RootJoint == nullptr)
+		return 0;
+
+	if (EmitBeginTime == INVALID_ELAPSE_TIME)
+	{
+		EmitBeginTime = RawFrames.GetFrame(0).ElapseTime;
+		EmitRootOrigin = RawFrames.GetFrame(0).FrameInfo[0].Position;
+	}
+
+	EmitRow.resize(JointCount);
+
+	//   frame  local rotation (Ϸ  frame  ̹ )
+	for (size_t i = EmitRawIndex; i < rawFrameCount; ++i)
+	{
+		if (i >= RawFrames.GetSpilledCount())
+		{
+			SolveLocalRotation(RawFrames.GetResident(i).FrameInfo.data());
+		}
+	}
+
+	// emit  export  ϰ ù raw frame 
+	CBVHResampleCursor cursor(ExportFrameRate);
+	cursor.Start(EmitBeginTime, EmittedFrameCount);
+
+	size_t rowCount = 0;
+	float interpTime;
+
+	for (; EmitRawIndex + 1 < rawFrameCount; ++EmitRawIndex)
+	{
+		const auto& rawframe0 = RawFrames.GetFrame(EmitRawIndex);
+		const auto& rawframe1 = RawFrames.GetFrame(EmitRawIndex + 1);
+
+		for (; cursor.GetFrame(rawframe0.ElapseTime, rawframe1.ElapseTime, interpTime); cursor.Next())
+		{
+			//  frame   ȣ⿡ (EmitRawIndex  ״ д)
+			if (rowCount >= inMaxCount)
+			{
+				EmittedFrameCount = cursor.GetFrameIndex();
+				return rowCount;
+			}
+
+			InterpolateFrame(rawframe0.FrameInfo.data(), rawframe1.FrameInfo.data(), interpTime, EmitRootOrigin, EmitRow.data());
+			ApplyFrameTransform(EmitRow.data(), ClipTransform, bExportRootTranslation);
+
+			const DWORD currentFrameTime = cursor.GetFrameTime();
+
+			if (bEulerAngles)
+			{
+				for (auto& value : EmitRow)
+				{
+					QuaternionToEulerAngles(value.DevQuat, value.Rotation, zyx, EulerPrecision);
+				}
+			}
+
+			inFunc(currentFrameTime);
+
+			if (PosePublisher)
+			{
+				PosePublisher->Publish(currentFrameTime, EmitRow.data());
+			}
+
+			++rowCount;
+		}
+	}
+
+	EmittedFrameCount = cursor.GetFrameIndex();
+
+	return rowCount;
+}
+
+int CBVH::GetSortedJointIndex(JointType inKinectJointType) const
+{
+	if (inKinectJointType < 0 || inKinectJointType >= (int)IndexConvertTable.size())
+		return -1;
+
+	return IndexConvertTable[inKinectJointType];
+}
+
+FBVHJoint::FBVHJoint() : ParentJoint(nullptr), KinectJointType(JointType_Count), RefQuat(XMQuaternionIdentity()), InvRefQuat(XMQuaternionIdentity())
+{
+}
+
+FBVHJoint::FBVHJoint(FBVHJoint* inParentJoint) : ParentJoint(inParentJoint), KinectJointType(JointType_Count), RefQuat(XMQuaternionIdentity()), InvRefQuat(XMQuaternionIdentity())
 {
 }
 
@@ -855,7 +1725,7 @@ char* Tabs[] =
 };
 
 
-void FBVHJoint::ExportHIERARCHY(std::string & outData, int inDepth)
+void FBVHJoint::ExportHIERARCHY(std::string & outData, int inDepth, const char* inRotationChannels)
 {
 	if (ParentJoint == NULL)
 	{
@@ -917,17 +1787,21 @@ void FBVHJoint::ExportHIERARCHY(std::string & outData, int inDepth)
 	if (ParentJoint == NULL)
 	{
 		outData.append(Tabs[inDepth + 1]);
-		outData.append("CHANNELS 6 Xposition Yposition Zposition Xrotation Yrotation Zrotation\n");
+		outData.append("CHANNELS 6 Xposition Yposition Zposition ");
+		outData.append(inRotationChannels);
+		outData.append("\n");
 	}
 	else if (ChildrenJoint.size() > 0)
 	{
 		outData.append(Tabs[inDepth + 1]);
-		outData.append("CHANNELS 3 Xrotation Yrotation Zrotation\n");
+		outData.append("CHANNELS 3 ");
+		outData.append(inRotationChannels);
+		outData.append("\n");
 	}
 
 	for (auto value : ChildrenJoint)
 	{
-		value->ExportHIERARCHY(outData, inDepth + 1);
+		value->ExportHIERARCHY(outData, inDepth + 1, inRotationChannels);
 	}
 
 	outData.append(Tabs[inDepth]); outData.append("}\n");
@@ -956,20 +1830,42 @@ XMVECTOR FBVHJoint::CalculateWorldPostionByParentJoint()
 	return zeroVector;
 }
 
-void FBVHFrame::ExportMOTION(std::string & outData, bool bQuaternion)
+// outData += " " + std::to_string(inValue)    ӽ ڿ  δ.
+static void AppendMotionValue(std::string& outData, float inValue)
+{
+	char buffer[64];
+	int length = snprintf(buffer, sizeof(buffer), " %f", inValue);
+
+	outData.append(buffer, length);
+}
+
+void FBVHFrame::ExportMOTION(const FBVHJointTransform * inFrameInfo, size_t inCount, std::string & outData, bool bQuaternion, bool bRootTranslation)
 {
 	const float convertRad2Deg = 180.0f / XM_PI;
-	outData += "0.0 0.0 0.0";
+
+	if (bRootTranslation && inCount > 0)
+	{
+		char buffer[96];
+		int length = snprintf(buffer, sizeof(buffer), "%f %f %f", XMVectorGetX(inFrameInfo[0].Position), XMVectorGetY(inFrameInfo[0].Position), XMVectorGetZ(inFrameInfo[0].Position));
+
+		outData.append(buffer, length);
+	}
+	else
+	{
+		outData += "0.0 0.0 0.0";
+	}
 
 	int index = 0;
-	for (auto value : FrameInfo)
+	for (size_t i = 0; i < inCount; ++i)
 	{
+		const auto& value = inFrameInfo[i];
+
 		if (bQuaternion)
 		{
-			outData += " " + std::to_string(value.DevQuat.m128_f32[0]);
-			outData += " " + std::to_string(value.DevQuat.m128_f32[1]);
-			outData += " " + std::to_string(value.DevQuat.m128_f32[2]);
-			outData += " " + std::to_string(value.DevQuat.m128_f32[3]);
+			AppendMotionValue(outData, value.DevQuat.m128_f32[0]);
+			AppendMotionValue(outData, value.DevQuat.m128_f32[1]);
+			AppendMotionValue(outData, value.DevQuat.m128_f32[2]);
+			AppendMotionValue(outData, value.DevQuat.m128_f32[3]);
 
 			//outData += " " + std::to_string(value.LocalQuat.m128_f32[0]);
 			//outData += " " + std::to_string(value.LocalQuat.m128_f32[1]);
@@ -978,9 +1874,9 @@ void FBVHFrame::ExportMOTION(std::string & outData, bool bQuaternion)
 		}
 		else
 		{
-			outData += " " + std::to_string(XMVectorGetX(value.Rotation)*convertRad2Deg);
-			outData += " " + std::to_string(XMVectorGetY(value.Rotation)*convertRad2Deg);
-			outData += " " + std::to_string(XMVectorGetZ(value.Rotation)*convertRad2Deg);
+			AppendMotionValue(outData, XMVectorGetX(value.Rotation)*convertRad2Deg);
+			AppendMotionValue(outData, XMVectorGetY(value.Rotation)*convertRad2Deg);
+			AppendMotionValue(outData, XMVectorGetZ(value.Rotation)*convertRad2Deg);
 
 			if (std::isnan(XMVectorGetX(value.Rotation)) ||
 				std::isnan(XMVectorGetY(value.Rotation)) ||
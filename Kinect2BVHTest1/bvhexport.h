@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include <tuple>
 #include <unordered_map>
 #include <string>
@@ -11,6 +12,9 @@
 
 using namespace DirectX;
 
+#include "bvharena.h"
+#include "rawframestore.h"
+
 
 // https://social.msdn.microsoft.com/Forums/en-US/f2e6a544-705c-43ed-a0e1-731ad907b776/meaning-of-rotation-data-of-k4w-v2
 enum EKinectJointBoneDirection
@@ -23,7 +27,29 @@ enum EKinectJointBoneDirection
 	EKinectJointBoneDirection_NZ,
 };
 
+// quaternion.h  using namespace std  zyx, xyz  ̸  Ǯ Ƿ .cpp  include Ѵ.
+enum RotSeq : int;
+enum EEulerPrecision : int;
+struct Quaternion;
+
 void QuaternionToEulerAngles(const XMVECTOR& inQuat, XMVECTOR& outEulerianAngles);
+void QuaternionToEulerAngles(const XMVECTOR& inQuat, XMVECTOR& outEulerianAngles, RotSeq inRotSeq);
+
+// inPrecision tier   (EEulerPrecision_Exact ̸  )
+void QuaternionToEulerAngles(const XMVECTOR& inQuat, XMVECTOR& outEulerianAngles, RotSeq inRotSeq, EEulerPrecision inPrecision);
+
+// quaternion2Euler  (radian, res[0..2]  = BVH channel )  ȸ ٽ .
+Quaternion EulerToQuaternion(const double inEuler[3], RotSeq inRotSeq);
+
+// tier  ִ  (degree) : exact  Euler   ȸ  . channel  ϳϳ ̰ ƴϴ.
+// (gimbal lock ó channel  ũ ޶  ȸ  ִ)
+extern const float EULER_PRECISION_MAX_ERROR[];	// EEulerPrecision_Count 
+
+// ִ  inToleranceDegrees    tier
+EEulerPrecision SelectEulerPrecision(float inToleranceDegrees);
+
+//  quaternion (1/4  gimbal lock ó) inSampleCount ,  ȸ   exact ο ִ  (degree) 
+double MeasureEulerPrecisionError(EEulerPrecision inPrecision, int inSampleCount, unsigned int inSeed = 1);
 
 inline void QuaternionToEulerAngles2(const XMVECTOR& inQuat, XMVECTOR& outEulerianAngles)
 {
@@ -137,7 +163,7 @@ struct FBVHJoint
 	
 
 	void GatherJoints(std::vector<FBVHJoint*>& outJoints);
-	void ExportHIERARCHY(std::string& outData, int inDepth = 0);
+	void ExportHIERARCHY(std::string& outData, int inDepth = 0, const char* inRotationChannels = "Xrotation Yrotation Zrotation");
 
 	XMVECTOR CalculateWorldPostionByParentJoint();
 };
@@ -145,14 +171,97 @@ struct FBVHJoint
 struct FRawBVHFrame
 {
 	DWORD ElapseTime;				// milliseconds
-	std::vector<FBVHJointTransform> FrameInfo;
+	TBVHArray<FBVHJointTransform> FrameInfo;		// CBVH::SessionArena
 };
 
 struct FBVHFrame
 {
-	DWORD ElapseTime;				// milliseconds
-	std::vector<FBVHJointTransform> FrameInfo;
-	void ExportMOTION(std::string& outData, bool bQuaternion);
+	// MOTION  . bRootTranslation ̸ root channel  inFrameInfo[0].Position (resampling  root ̵) , ƴϸ 0  .
+	static void ExportMOTION(const FBVHJointTransform* inFrameInfo, size_t inCount, std::string& outData, bool bQuaternion, bool bRootTranslation = false);
+};
+
+//   resampling   frame ġ (ExportFile, ExportFiles, EmitPendingMotion, CMultiBodyBVH, CBVHStreamExporter )
+//  frame i  ð ù  frame + i * 1000 / FrameRate.
+// raw frame  [time0, time1)  ʷ ѱ鼭 GetFrame  true   Next  Ѵ.
+class CBVHResampleCursor
+{
+	int FrameRate;
+	DWORD BeginTime;				// export  (raw frame  ElapseTime ,   )
+	DWORD EndTime;
+
+	DWORD InitialFrameTime;			// ù  frame : max(ù raw frame, BeginTime)
+	size_t FrameIndex;				//   frame
+
+public:
+	CBVHResampleCursor(int inFrameRate, DWORD inBeginTime = 0, DWORD inEndTime = 0xffffffff)
+		: FrameRate(inFrameRate), BeginTime(inBeginTime), EndTime(inEndTime), InitialFrameTime(0), FrameIndex(0)
+	{
+	}
+
+	// ù raw frame  ð ù  frame  Ѵ. ̾   inFrameIndex  ̹  frame 
+	void Start(DWORD inFirstRawTime, size_t inFrameIndex = 0)
+	{
+		InitialFrameTime = inFirstRawTime > BeginTime ? inFirstRawTime : BeginTime;
+		FrameIndex = inFrameIndex;
+	}
+
+	//   frame  [inRawTime0, inRawTime1) ȿ   raw frame    (0 ̸ inRawTime0  ġ)
+	bool GetFrame(DWORD inRawTime0, DWORD inRawTime1, float& outInterpTime) const
+	{
+		const DWORD frameTime = GetFrameTime();
+		if (frameTime < inRawTime0 || frameTime >= inRawTime1 || frameTime > EndTime)
+			return false;
+
+		outInterpTime = frameTime > inRawTime0 ? (float)(frameTime - inRawTime0) / (float)(inRawTime1 - inRawTime0) : 0.0f;
+		return true;
+	}
+
+	void Next() { ++FrameIndex; }
+
+	// export     frame  
+	bool IsFinished() const { return GetFrameTime() > EndTime; }
+
+	//  raw frame  inLastRawTime   Start    frame  (raw frame  ð )
+	size_t GetFrameCount(DWORD inLastRawTime) const
+	{
+		//  frame  ð [InitialFrameTime, min(inLastRawTime - 1, EndTime)]
+		if (inLastRawTime <= InitialFrameTime || EndTime < InitialFrameTime)
+			return 0;
+
+		const DWORD lastFrameTime = inLastRawTime - 1 < EndTime ? inLastRawTime - 1 : EndTime;
+		const ULONGLONG duration = (ULONGLONG)(lastFrameTime - InitialFrameTime) + 1;
+
+		// i * 1000 / FrameRate < duration  i  
+		return (size_t)((duration * FrameRate + 999) / 1000);
+	}
+
+	DWORD GetInitialFrameTime() const { return InitialFrameTime; }
+	DWORD GetFrameTime() const { return InitialFrameTime + (DWORD)((ULONGLONG)FrameIndex * 1000 / FrameRate); }
+	size_t GetFrameIndex() const { return FrameIndex; }
+};
+
+class CBVH;
+class CRetargetMap;
+class CBVHLODMap;
+class CBVHExportPlan;
+class CCaptureJournal;
+class CPosePublisher;
+class CClipTransform;
+struct FRotationCacheKey;
+
+// ExportFile    retarget 
+struct FBVHRetargetOutput
+{
+	const CBVH* TargetRig;
+	const CRetargetMap* Map;
+	std::string FileName;
+};
+
+// ExportFile    LOD (joint , frame ) 
+struct FBVHLODOutput
+{
+	const CBVHLODMap* Map;
+	std::string FileName;
 };
 
 class CBVH
@@ -171,8 +280,13 @@ class CBVH
 	std::vector<FBVHJoint*> SortedJointArray;		// Parent-Child 谡   : Parent index child ׻ ۴.
 	std::vector<int> IndexConvertTable;				// SetJointName()  Էµ TableIndex JointArray Index ȯϴ Table
 
-	std::vector<FRawBVHFrame> RawFrames;		//   Frame 
-	std::vector<FBVHFrame> Frames;				// Raw Data    Frame   
+	// frame  Ҵ heap  arena  ޴´.
+	// SessionArena : RawFrames (ClearFrames  ° Reset, memory   ring  )
+	// export  resampling  frame  ׾  ʰ frame  ٷ Ϸ .
+	CBVHArena SessionArena;
+
+	CRawFrameStore RawFrames;					//   Frame 
+	bool bRawFrameSpillFailed;					// memory   frame  Ϸ  ؼ    (ClearFrames )
 
 	// 
 	const DWORD INVALID_ELAPSE_TIME = 0xffffffff;
@@ -180,11 +294,54 @@ class CBVH
 
 	const int ExportFrameRate = 30;
 
+	// export   (RawFrames  ElapseTime ). INVALID_ELAPSE_TIME ̸ ü
+	DWORD ExportBeginTime;
+	DWORD ExportEndTime;
+
 	FRawBVHFrame* CurrentRawBVHFrame;
 
+	// EmitPendingMotion  
+	DWORD EmitBeginTime;						// ù raw frame  ElapseTime
+	size_t EmitRawIndex;						//   raw frame  [i, i + 1]
+	size_t EmittedFrameCount;
+	std::vector<FBVHJointTransform> EmitRow;
+	XMVECTOR EmitRootOrigin;					// ù raw frame  root position
+
+	bool bExportRootTranslation;
+
+	EEulerPrecision EulerPrecision;				// MOTION  Euler ȯ tier (SetRotationTolerance)
+
+	std::vector<FBVHRetargetOutput> RetargetOutputs;
+	std::vector<FBVHLODOutput> LODOutputs;
+	const CClipTransform* ClipTransform;			// resampling  frame   (nullptr ̸ )
+
+	std::unique_ptr<CCaptureJournal> Journal;		//   End  frame  
+	std::unique_ptr<CPosePublisher> PosePublisher;	//   resampling  frame   ޸𸮿 ø.
+
+	// ExportFile  LocalQuat cache (CRotationCache).     
+	std::string RotationCacheDirectory;
+	ULONGLONG RawInputHash;						// End  raw frame Է  hash (export  raw frame  ٽ  ʴ´)
+	bool bRawInputHashValid;					// RawInputHash  ù frame  . cache directory  End  frame   ClearFrames  false
+	std::vector<char> RawMissingJoints;			// Է  ̶  ִ joint (SortedJointArray )
+	bool bLastExportFromCache;
+
 	void GenerateLocalRotation();
 
-	void GenerateEvenSpacedFrameData();
+	// EmitPendingMotion, PublishPendingPoses, PullPendingFrames  :  raw frame    ְ   frame 
+	// EmitRow  LocalQuat, DevQuat (bEulerAngles ̸ Rotation )  ä inFunc(ElapseTime) ȣ
+	// ִ inMaxCount  óϰ,  frame   ȣ⿡ ̾ óѴ.
+	template<typename TFunc>
+	size_t ForEachPendingFrame(bool bEulerAngles, size_t inMaxCount, TFunc inFunc);
+
+	void MakeRotationCacheKey(FRotationCacheKey& outKey) const;
+
+	// RawFrames  inFrameRate  (export ) ,  frame 
+	// inFunc(ElapseTime, rawframe0, rawframe1, interpTime) ȣ. ð rawframe0  ġϸ interpTime  0
+	template<typename TFunc>
+	size_t ForEachEvenSpacedFrame(int inFrameRate, TFunc inFunc) const;
+
+	// ForEachEvenSpacedFrame   frame  (ù/ raw frame  ð )
+	size_t GetEvenSpacedFrameCount(int inFrameRate) const;
 
 	void MakeNameJointTypeMap();
 	JointType GetJointType(const std::string& inJointName);
@@ -214,12 +371,118 @@ public:
 
 	void End();
 
+	// Էµ frame   . (skeleton/ref pose  )
+	// frame ޸𸮴 arena    ȸǰ,  session  ȴ.
+	void ClearFrames();
+
+	const CBVHArena& GetSessionArena() const { return SessionArena; }
+
+	// live Է  ȣ :  inFrameCount  frame  Begin/Add*Value/End  heap Ҵ .
+	// (Ѿ arena  block  þ  frame   ʴ´)
+	void ReserveFrames(size_t inFrameCount);
+
+	// RawFrames  ޸𸮿   ִ ũ (byte).   frame  local rotation  Ǯ inSpillFileName  .
+	// ù Begin  (Ǵ ClearFrames )  ٲ  ִ. 0 ̸  
+	bool SetRawFrameMemoryBudget(size_t inBudget, const std::string& inSpillFileName);
+
+	//  End  frame  inFileName journal  background thread  Ѵ. (ClearFrames ϸ )
+	bool StartJournal(const std::string& inFileName);
+	void StopJournal();
+
+	// process      : journal   frame  RawFrames  ϰ  journal  ̾ Ѵ.
+	// EmitPendingMotion  ´  snapshot  ǵưǷ  ڿ emit ߴ frame  ٽ ´.
+	// ref pose  journal     Ϸ import Ǿ ־ Ѵ.
+	bool ResumeJournal(const std::string& inFileName);
+
+	// ExportFile  [inBeginTime, inEndTime]  resampling
+	void SetExportTimeRange(DWORD inBeginTime, DWORD inEndTime);
+	void ResetExportTimeRange();
+
+	//    0, 0xffffffff (ü)
+	void GetExportTimeRange(DWORD& outBeginTime, DWORD& outEndTime) const;
+
+	// root position channel  SpineBase  ̵ (ù frame )  . ⺻ 0 
+	// capture  Kinect camera space (m) ̹Ƿ rig / SetClipTransform (UnitScale, RootRotation)  .
+	void SetRootTranslationExport(bool bEnable) { bExportRootTranslation = bEnable; }
+	bool IsRootTranslationExported() const { return bExportRootTranslation; }
+
+	// export/emit  quaternion -> Euler ȯ  ȸ  (degree).  ȿ    tier  .
+	// ⺻ 0 (exact, double). MOTION  Ҽ 6 ڸ Ƿ ׺   ¿  巯 ʴ´.
+	void SetRotationTolerance(float inToleranceDegrees) { EulerPrecision = SelectEulerPrecision(inToleranceDegrees); }
+	EEulerPrecision GetEulerPrecision() const { return EulerPrecision; }
+
 	void ImportRefPoseByBVHFile(const std::string& inFileName);
 	void ImportRefPoseByBVHFile2(const std::string& inFileName);
 
 	void DataValidationTest();
 
-	void ExportFile(const std::string& inFileName);
+	// inFileName ( retarget/LOD  ̸)  ".gz"   block    (CBlockCompressedWriter)
+	//    ϳ  ϸ false
+	// memory  (SetRawFrameMemoryBudget)   frame      frame   false
+	bool ExportFile(const std::string& inFileName);
+
+	// ExportFile  solver + resampling  inDirectory  capture/hierarchy  hash   ΰ,
+	//  Է ٽ export   (ref pose, ClipTransform, root ̵  ٲ  )   о .
+	//  ڿ̸   . cache key  Է hash  Ǿ ִ ȸ End  ϹǷ capture  ϱ  Ѵ.
+	// (   frame   ClearFrames  cache   ʴ´)
+	void SetRotationCacheDirectory(const std::string& inDirectory) { RotationCacheDirectory = inDirectory; }
+	bool IsLastExportFromCache() const { return bLastExportFromCache; }
+
+	//   local rotation  plan   target (ȸ , е, text/binary, frame rate)  .
+	// target ϳ ų  ϸ false ( frame    ExportFile   false)
+	bool ExportFiles(const CBVHExportPlan& inPlan);
+
+	// live  :  ȣ   raw frame    ְ  MOTION row  outData  δ. (End  ȣ)
+	// ȯ ߰ row 
+	size_t EmitPendingMotion(std::string& outData);
+	size_t GetEmittedFrameCount() const { return EmittedFrameCount; }
+
+	// resampling  frame  local rotation  inName  ޸ (CPoseSubscriber  )  ø.
+	// EmitPendingMotion Ǵ PublishPendingPoses  ȣ   frame  ö󰣴.
+	bool StartPosePublisher(const std::string& inName);
+	void StopPosePublisher();
+
+	// MOTION text   frame   ޸𸮿 ø. (End  ȣ)
+	size_t PublishPendingPoses();
+
+	//  frame  ִ inMaxCount  outQuats (frame  JointCount * 4 float, SortedJointArray )  
+	// bDevQuat ̸ ref pose  DevQuat, ƴϸ LocalQuat. outElapseTimes  nullptr 
+	// (EmitPendingMotion    ¸ Ƿ   ϳ )
+	size_t PullPendingFrames(float* outQuats, DWORD* outElapseTimes, size_t inMaxCount, bool bDevQuat);
+
+	// Skeleton (ref pose)  :  track   skeleton    
+	const std::vector<FBVHJoint*>& GetSortedJointArray() const { return SortedJointArray; }
+	int GetJointCount() const { return JointCount; }
+	int GetSortedJointIndex(JointType inKinectJointType) const;
+	int FindSortedJointIndex(const std::string& inJointName) const;
+	int GetExportFrameRate() const { return ExportFrameRate; }
+
+	//  frame  WorldQuat κ LocalQuat  (local*parent.world = world)
+	void SolveLocalRotation(FBVHJointTransform* ioFrameInfo) const;
+
+	// LocalQuat  Ǭ  raw frame   frame ϳ : outFrameInfo  LocalQuat 
+	// [0].Position (root ̵ = root position  - inRootOrigin, ClipTransform  )  ä.
+	void InterpolateFrame(const FBVHJointTransform* inRawFrame0, const FBVHJointTransform* inRawFrame1, float inInterpTime, const XMVECTOR& inRootOrigin, FBVHJointTransform* outFrameInfo) const;
+
+	// InterpolateFrame  DevQuat (ref pose )   inClipTransform  Ѵ. (bRootTranslation ̸ root ̵)
+	void ApplyFrameTransform(FBVHJointTransform* ioFrameInfo, const CClipTransform* inClipTransform, bool bRootTranslation) const;
+
+	// HIERARCHY  MOTION header (Frames, Frame Time)
+	void ExportHeader(std::string& outData, size_t inFrameCount) const;
+	void ExportHeader(std::string& outData, size_t inFrameCount, int inFrameRate, const char* inRotationChannels) const;
+
+	// ExportFile  inMap  retarget   inFileName    (inTargetRig, inMap  export   Ǿ )
+	void AddRetargetOutput(const CBVH& inTargetRig, const CRetargetMap& inMap, const std::string& inFileName);
+	void ClearRetargetOutputs();
+
+	// ExportFile  inMap ( skeleton  Compile)   inFileName    (inMap  export   )
+	void AddLODOutput(const CBVHLODMap& inMap, const std::string& inFileName);
+	void ClearLODOutputs();
+
+	//  export/emit/pull ϴ frame  , root ȸ  (inTransform   skeleton  Compile, ϴ  )
+	// nullptr ̸ 
+	bool SetClipTransform(const CClipTransform* inTransform);
+	const CClipTransform* GetClipTransform() const { return ClipTransform; }
 
 //#ifdef __Kinect_h__
 //	static void toEulerianAngle(const Vector4& q, float& roll, float& pitch, float& yaw)
@@ -262,3 +525,31 @@ public:
 //#endif
 };
 
+
+template<typename TFunc>
+size_t CBVH::ForEachEvenSpacedFrame(int inFrameRate, TFunc inFunc) const
+{
+	if (RawFrames.size() < 2)
+		return 0;
+
+	DWORD beginTime, endTime;
+	GetExportTimeRange(beginTime, endTime);
+
+	CBVHResampleCursor cursor(inFrameRate, beginTime, endTime);
+	cursor.Start(RawFrames.GetFrame(0).ElapseTime);
+
+	float interpTime;
+
+	for (size_t i = 0; i + 1 < RawFrames.size() && !cursor.IsFinished(); ++i)
+	{
+		auto& rawframe0 = RawFrames.GetFrame(i);
+		auto& rawframe1 = RawFrames.GetFrame(i + 1);
+
+		for (; cursor.GetFrame(rawframe0.ElapseTime, rawframe1.ElapseTime, interpTime); cursor.Next())
+		{
+			inFunc(cursor.GetFrameTime() - cursor.GetInitialFrameTime(), rawframe0, rawframe1, interpTime);
+		}
+	}
+
+	return cursor.GetFrameIndex();
+}
@@ -0,0 +1,507 @@
+#include "stdafx.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+
+#include "bvhreader.h"
+#include "exportplan.h"
+#include "quaternion.h"
+
+// sidecar file layout : header + frame offset (little endian, packed)
+static const DWORD BVH_READER_INDEX_MAGIC = 0x5842424b;		// "KBBX"
+static const DWORD BVH_READER_INDEX_VERSION = 2;
+
+#pragma pack(push, 1)
+struct FBVHReaderIndexFileHeader
+{
+	DWORD Magic;
+	DWORD Version;
+	DWORD Stride;
+	ULONGLONG FileSize;
+	ULONGLONG FileWriteTime;			// ũⰡ    BVH  ˾ƺ (CMappedFile::GetLastWriteTime)
+	ULONGLONG MotionOffset;
+	ULONGLONG ScanFrame;
+	ULONGLONG ScanOffset;
+	ULONGLONG EntryCount;
+};
+#pragma pack(pop)
+
+static inline bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+//    ϳ (mapping  ޸𸮴 null   ʴ´)
+static bool ParseFloat(const char* inBegin, const char* inEnd, float& outValue)
+{
+	const size_t length = inEnd - inBegin;
+	if (length == 0 || length >= 32)
+		return false;
+
+	char buffer[32];
+	memcpy(buffer, inBegin, length);
+	buffer[length] = '\0';
+
+	char* parsedEnd = nullptr;
+	outValue = strtof(buffer, &parsedEnd);
+	return parsedEnd == buffer + length;
+}
+
+// BVH   е token  д´.
+struct FBVHTokenizer
+{
+	const char* Cursor;
+	const char* End;
+
+	FBVHTokenizer(const char* inBegin, const char* inEnd) : Cursor(inBegin), End(inEnd) {}
+
+	bool NextToken(std::string& outToken)
+	{
+		while (Cursor < End && IsSpace(*Cursor))
+			++Cursor;
+
+		if (Cursor >= End)
+			return false;
+
+		const char* begin = Cursor;
+		while (Cursor < End && !IsSpace(*Cursor))
+			++Cursor;
+
+		outToken.assign(begin, Cursor);
+		return true;
+	}
+
+	bool NextFloat(float& outValue)
+	{
+		while (Cursor < End && IsSpace(*Cursor))
+			++Cursor;
+
+		const char* begin = Cursor;
+		while (Cursor < End && !IsSpace(*Cursor))
+			++Cursor;
+
+		return ParseFloat(begin, Cursor, outValue);
+	}
+};
+
+static bool FindRotationOrder(const std::string& inChannels, RotSeq& outRotSeq)
+{
+	const RotSeq candidates[] = { zyx, zxy, yxz, yzx, xyz, xzy };
+
+	for (RotSeq rotSeq : candidates)
+	{
+		if (inChannels == CBVHExportPlan::GetRotationChannels(rotSeq))
+		{
+			outRotSeq = rotSeq;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//  ϳ (frame ϳ)  channel . ϸ ioCursor    
+static bool ParseFrameLine(const char*& ioCursor, const char* inEnd, int inChannelCount, float* outValues)
+{
+	const char* cursor = ioCursor;
+
+	for (int c = 0; c < inChannelCount; ++c)
+	{
+		while (cursor < inEnd && (*cursor == ' ' || *cursor == '\t'))
+			++cursor;
+
+		const char* begin = cursor;
+		while (cursor < inEnd && !IsSpace(*cursor))
+			++cursor;
+
+		//    begin == cursor
+		if (!ParseFloat(begin, cursor, outValues[c]))
+			return false;
+	}
+
+	const char* lineEnd = (const char*)memchr(cursor, '\n', inEnd - cursor);
+	ioCursor = lineEnd ? lineEnd + 1 : inEnd;
+
+	return true;
+}
+
+CBVHFileReader::CBVHFileReader()
+	: ChannelCount(0), FrameCount(0), FrameTime(0.0f), bBinary(false), MotionOffset(0),
+	ScanFrame(0), ScanOffset(0), bIndexChanged(false), CursorFrame(0), CursorOffset(0)
+{
+}
+
+CBVHFileReader::~CBVHFileReader()
+{
+	Close();
+}
+
+bool CBVHFileReader::Open(const std::string & inFileName, bool bUseSidecarIndex)
+{
+	Close();
+
+	if (!File.Open(inFileName) || !ParseHeader())
+	{
+		Close();
+		return false;
+	}
+
+	ScanFrame = 0;
+	ScanOffset = MotionOffset;
+	CursorFrame = 0;
+	CursorOffset = MotionOffset;
+
+	if (bUseSidecarIndex && !bBinary)
+	{
+		SidecarFileName = GetSidecarFileName(inFileName);
+		LoadIndex();
+	}
+
+	return true;
+}
+
+void CBVHFileReader::Close()
+{
+	if (bIndexChanged && !SidecarFileName.empty())
+	{
+		SaveIndex();
+	}
+
+	File.Close();
+	SidecarFileName.clear();
+
+	Joints.clear();
+	ChannelCount = 0;
+	FrameCount = 0;
+	FrameTime = 0.0f;
+	bBinary = false;
+	MotionOffset = 0;
+
+	IndexOffsets.clear();
+	ScanFrame = 0;
+	ScanOffset = 0;
+	bIndexChanged = false;
+
+	CursorFrame = 0;
+	CursorOffset = 0;
+}
+
+// HIERARCHY ~ "Frame Time:" (binary ̸ "Binary: float32" )
+bool CBVHFileReader::ParseHeader()
+{
+	FBVHTokenizer tokenizer(File.GetData(), File.GetData() + File.GetSize());
+
+	std::vector<int> jointStack;
+	int pendingJoint = -1;
+	ChannelCount = 0;
+
+	std::string token;
+	for (;;)
+	{
+		if (!tokenizer.NextToken(token))
+			return false;
+
+		if (token == "MOTION")
+			break;
+
+		if (token == "ROOT" || token == "JOINT")
+		{
+			FBVHChannelLayout joint;
+			if (!tokenizer.NextToken(joint.Name))
+				return false;
+
+			joint.ParentIndex = jointStack.empty() ? -1 : jointStack.back();
+			joint.Offset[0] = joint.Offset[1] = joint.Offset[2] = 0.0f;
+			joint.PositionChannel[0] = joint.PositionChannel[1] = joint.PositionChannel[2] = -1;
+			joint.RotationChannel = -1;
+			joint.RotationOrder = zyx;
+
+			pendingJoint = (int)Joints.size();
+			Joints.push_back(joint);
+		}
+		else if (token == "End")
+		{
+			// "End Site" Ǵ "End ≮>" : channel 
+			if (!tokenizer.NextToken(token))
+				return false;
+
+			pendingJoint = -1;
+		}
+		else if (token == "{")
+		{
+			jointStack.push_back(pendingJoint);
+		}
+		else if (token == "}")
+		{
+			if (jointStack.empty())
+				return false;
+
+			jointStack.pop_back();
+		}
+		else if (token == "OFFSET")
+		{
+			float offset[3];
+			if (!tokenizer.NextFloat(offset[0]) || !tokenizer.NextFloat(offset[1]) || !tokenizer.NextFloat(offset[2]))
+				return false;
+
+			// End Site  OFFSET  .
+			if (!jointStack.empty() && jointStack.back() >= 0)
+			{
+				memcpy(Joints[jointStack.back()].Offset, offset, sizeof(offset));
+			}
+		}
+		else if (token == "CHANNELS")
+		{
+			if (jointStack.empty() || jointStack.back() < 0 || !tokenizer.NextToken(token))
+				return false;
+
+			FBVHChannelLayout& joint = Joints[jointStack.back()];
+			const int count = atoi(token.c_str());
+
+			std::string rotationChannels;
+			for (int i = 0; i < count; ++i)
+			{
+				if (!tokenizer.NextToken(token))
+					return false;
+
+				const int channel = ChannelCount++;
+
+				if (token == "Xposition")
+					joint.PositionChannel[0] = channel;
+				else if (token == "Yposition")
+					joint.PositionChannel[1] = channel;
+				else if (token == "Zposition")
+					joint.PositionChannel[2] = channel;
+				else
+				{
+					if (rotationChannels.empty())
+						joint.RotationChannel = channel;
+					else
+						rotationChannels += ' ';
+
+					rotationChannels += token;
+				}
+			}
+
+			if (!rotationChannels.empty() && !FindRotationOrder(rotationChannels, joint.RotationOrder))
+				return false;
+		}
+		// ROT, EULER   token  ǳʶڴ.
+	}
+
+	if (!tokenizer.NextToken(token) || token != "Frames:" || !tokenizer.NextToken(token))
+		return false;
+
+	FrameCount = (size_t)strtoull(token.c_str(), nullptr, 10);
+
+	if (!tokenizer.NextToken(token) || token != "Frame" || !tokenizer.NextToken(token) || token != "Time:" || !tokenizer.NextFloat(FrameTime))
+		return false;
+
+	// binary : "Binary: float32\n" ٷ ں frame  float32 channel 
+	bBinary = false;
+
+	const char* cursor = tokenizer.Cursor;
+	while (cursor < tokenizer.End && IsSpace(*cursor))
+		++cursor;
+
+	static const char BINARY_MARKER[] = "Binary: float32\n";
+	const size_t markerLength = sizeof(BINARY_MARKER) - 1;
+
+	if ((size_t)(tokenizer.End - cursor) >= markerLength && memcmp(cursor, BINARY_MARKER, markerLength) == 0)
+	{
+		tokenizer.Cursor = cursor + markerLength;
+		bBinary = true;
+	}
+
+	MotionOffset = tokenizer.Cursor - File.GetData();
+
+	return !Joints.empty() && ChannelCount > 0 && FrameTime > 0.0f;
+}
+
+bool CBVHFileReader::FindFrameOffset(size_t inFrameIndex, size_t & outOffset)
+{
+	const char* data = File.GetData();
+	const size_t size = File.GetSize();
+
+	if (bBinary)
+	{
+		const size_t rowSize = ChannelCount * sizeof(float);
+		if (inFrameIndex >= (size - MotionOffset) / rowSize)
+			return false;
+
+		outOffset = MotionOffset + inFrameIndex * rowSize;
+		return true;
+	}
+
+	if (inFrameIndex == CursorFrame)
+	{
+		outOffset = CursorOffset;
+		return true;
+	}
+
+	const size_t entry = inFrameIndex / INDEX_STRIDE;
+
+	//  ڶ    ̾  .
+	while (IndexOffsets.size() <= entry)
+	{
+		size_t pos = ScanOffset;
+		while (pos < size && IsSpace(data[pos]))
+			++pos;
+
+		if (pos >= size)
+			return false;
+
+		if (ScanFrame % INDEX_STRIDE == 0)
+		{
+			IndexOffsets.push_back(pos);
+			bIndexChanged = true;
+		}
+
+		const char* lineEnd = (const char*)memchr(data + pos, '\n', size - pos);
+		ScanOffset = lineEnd ? lineEnd - data + 1 : size;
+		++ScanFrame;
+	}
+
+	size_t pos = IndexOffsets[entry];
+	for (size_t frame = entry * INDEX_STRIDE; frame < inFrameIndex; ++frame)
+	{
+		const char* lineEnd = (const char*)memchr(data + pos, '\n', size - pos);
+		if (lineEnd == nullptr)
+			return false;
+
+		pos = lineEnd - data + 1;
+		while (pos < size && IsSpace(data[pos]))
+			++pos;
+	}
+
+	if (pos >= size)
+		return false;
+
+	outOffset = pos;
+	return true;
+}
+
+size_t CBVHFileReader::ReadFrames(size_t inFirstFrame, size_t inFrameCount, float * outValues)
+{
+	if (!IsOpen() || inFirstFrame >= FrameCount)
+		return 0;
+
+	inFrameCount = std::min(inFrameCount, FrameCount - inFirstFrame);
+
+	size_t offset = 0;
+	if (!FindFrameOffset(inFirstFrame, offset))
+		return 0;
+
+	const char* data = File.GetData();
+	const size_t size = File.GetSize();
+
+	if (bBinary)
+	{
+		const size_t rowSize = ChannelCount * sizeof(float);
+		const size_t count = std::min(inFrameCount, (size - offset) / rowSize);
+
+		memcpy(outValues, data + offset, count * rowSize);
+		return count;
+	}
+
+	const char* cursor = data + offset;
+	const char* end = data + size;
+
+	size_t count = 0;
+	while (count < inFrameCount)
+	{
+		//  
+		while (cursor < end && IsSpace(*cursor))
+			++cursor;
+
+		const size_t frame = inFirstFrame + count;
+		const size_t lineStart = cursor - data;
+
+		if (!ParseFrameLine(cursor, end, ChannelCount, outValues + count * ChannelCount))
+			break;
+
+		// տ ̾ д ̸ ε  ø.
+		if (frame == ScanFrame)
+		{
+			if (frame % INDEX_STRIDE == 0)
+			{
+				IndexOffsets.push_back(lineStart);
+				bIndexChanged = true;
+			}
+
+			++ScanFrame;
+			ScanOffset = cursor - data;
+		}
+
+		++count;
+	}
+
+	CursorFrame = inFirstFrame + count;
+	CursorOffset = cursor - data;
+
+	return count;
+}
+
+bool CBVHFileReader::LoadIndex()
+{
+	std::ifstream myfile(SidecarFileName, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!myfile)
+		return false;
+
+	const ULONGLONG sidecarSize = (ULONGLONG)myfile.tellg();
+	myfile.seekg(0);
+
+	FBVHReaderIndexFileHeader header;
+	if (sidecarSize < sizeof(header) ||
+		!myfile.read((char*)&header, sizeof(header)) ||
+		header.Magic != BVH_READER_INDEX_MAGIC ||
+		header.Version != BVH_READER_INDEX_VERSION ||
+		header.Stride != INDEX_STRIDE ||
+		header.FileSize != File.GetSize() ||
+		header.FileWriteTime != File.GetLastWriteTime() ||
+		header.MotionOffset != MotionOffset ||
+		header.ScanOffset > File.GetSize() ||
+		header.EntryCount != (header.ScanFrame + INDEX_STRIDE - 1) / INDEX_STRIDE ||
+		header.EntryCount * sizeof(ULONGLONG) != sidecarSize - sizeof(header))
+	{
+		return false;
+	}
+
+	std::vector<ULONGLONG> offsets((size_t)header.EntryCount);
+	if (!offsets.empty() && !myfile.read((char*)offsets.data(), offsets.size() * sizeof(ULONGLONG)))
+		return false;
+
+	for (auto const& value : offsets)
+	{
+		if (value >= File.GetSize())
+			return false;
+	}
+
+	IndexOffsets.assign(offsets.begin(), offsets.end());
+	ScanFrame = (size_t)header.ScanFrame;
+	ScanOffset = (size_t)header.ScanOffset;
+
+	return true;
+}
+
+bool CBVHFileReader::SaveIndex() const
+{
+	std::ofstream myfile(SidecarFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!myfile)
+		return false;
+
+	FBVHReaderIndexFileHeader header = { BVH_READER_INDEX_MAGIC, BVH_READER_INDEX_VERSION, INDEX_STRIDE, File.GetSize(), File.GetLastWriteTime(), MotionOffset, ScanFrame, ScanOffset, IndexOffsets.size() };
+	myfile.write((const char*)&header, sizeof(header));
+
+	std::vector<ULONGLONG> offsets(IndexOffsets.begin(), IndexOffsets.end());
+	myfile.write((const char*)offsets.data(), offsets.size() * sizeof(ULONGLONG));
+
+	return myfile.good();
+}
+
+std::string CBVHFileReader::GetSidecarFileName(const std::string & inFileName)
+{
+	return inFileName + ".idx";
+}
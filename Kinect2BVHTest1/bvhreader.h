@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "bvhexport.h"
+#include "mappedfile.h"
+
+// BVH HIERARCHY  joint ϳ (End Site )
+struct FBVHChannelLayout
+{
+	std::string Name;
+	int ParentIndex;
+	float Offset[3];
+	int PositionChannel[3];			// X/Y/Zposition  channel index (-1 : )
+	int RotationChannel;			// ȸ channel 3  ù index (-1 : )
+	RotSeq RotationOrder;
+};
+
+// ̹ ִ ū BVH (CBVH::ExportFile / CBVHExportSink )  ʿ frame   д´.
+// Open   mapping ϰ HIERARCHY ~ Frame Time  parsing Ѵ. MOTION    ǵ帮 ʴ´.
+// text MOTION    frame ϳ. ó û frame   鼭 INDEX_STRIDE frame   offset  ο ,
+//  ʹ   ο INDEX_STRIDE  ̳ ǳʶڴ. binary ("Binary: float32")  offset  ٷ Ѵ.
+// bUseSidecarIndex    <bvh>.idx   ΰ  Open  ̾ . (ū text BVH     )
+// BVH  ũ⳪   ð   ٸ sidecar    .
+//  ReadFrames  ڶǷ reader ϳ  thread    ʴ´.
+class CBVHFileReader
+{
+	CMappedFile File;
+	std::string SidecarFileName;			//   sidecar   ʴ´.
+
+	std::vector<FBVHChannelLayout> Joints;
+	int ChannelCount;
+	size_t FrameCount;						// header  Frames
+	float FrameTime;
+	bool bBinary;
+	size_t MotionOffset;					// ù frame  ϴ 
+
+	std::vector<size_t> IndexOffsets;		// frame (i * INDEX_STRIDE)   offset
+	size_t ScanFrame;						//   frame 
+	size_t ScanOffset;						// ScanFrame ° frame  ã  
+	bool bIndexChanged;
+
+	size_t CursorFrame;						//   frame   (̾   ã ʴ´)
+	size_t CursorOffset;
+
+	CBVHFileReader(const CBVHFileReader&) = delete;
+	CBVHFileReader& operator=(const CBVHFileReader&) = delete;
+
+	bool ParseHeader();
+	bool FindFrameOffset(size_t inFrameIndex, size_t& outOffset);
+
+	bool LoadIndex();
+	bool SaveIndex() const;
+
+public:
+	static const int INDEX_STRIDE = 256;
+
+	CBVHFileReader();
+	~CBVHFileReader();
+
+	bool Open(const std::string& inFileName, bool bUseSidecarIndex = false);
+
+	//  ڶ sidecar  ϰ ݴ´.
+	void Close();
+
+	bool IsOpen() const { return File.IsOpen(); }
+
+	const std::vector<FBVHChannelLayout>& GetJoints() const { return Joints; }
+	int GetJointCount() const { return (int)Joints.size(); }
+	int GetChannelCount() const { return ChannelCount; }
+	size_t GetFrameCount() const { return FrameCount; }
+	float GetFrameTime() const { return FrameTime; }
+	bool IsBinary() const { return bBinary; }
+
+	//  鼭  frame  (text)
+	size_t GetIndexedFrameCount() const { return ScanFrame; }
+
+	// inFirstFrame  inFrameCount  frame  channel    outValues (inFrameCount * GetChannelCount())  ä.
+	// ȯ :  frame  ( header  Frames  ªų   ٿ )
+	size_t ReadFrames(size_t inFirstFrame, size_t inFrameCount, float* outValues);
+	bool ReadFrame(size_t inFrameIndex, float* outValues) { return ReadFrames(inFrameIndex, 1, outValues) == 1; }
+
+	static std::string GetSidecarFileName(const std::string& inFileName);
+};
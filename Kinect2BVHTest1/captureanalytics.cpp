@@ -0,0 +1,629 @@
+#include "stdafx.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+#include "captureanalytics.h"
+#include "capturereader.h"
+#include "bvhreader.h"
+#include "quaternion.h"
+
+// CKinectCaptureStream    д record 
+static const size_t CAPTURE_BATCH_FRAME_COUNT = 256;
+
+static const char* const KINECT_JOINT_NAMES[JointType_Count] =
+{
+	"SpineBase", "SpineMid", "Neck", "Head",
+	"ShoulderLeft", "ElbowLeft", "WristLeft", "HandLeft",
+	"ShoulderRight", "ElbowRight", "WristRight", "HandRight",
+	"HipLeft", "KneeLeft", "AnkleLeft", "FootLeft",
+	"HipRight", "KneeRight", "AnkleRight", "FootRight",
+	"SpineShoulder", "HandTipLeft", "ThumbLeft", "HandTipRight", "ThumbRight",
+};
+
+// CBVH::SetKinectBoneConfiguration   parent (bone  )
+static const int KINECT_PARENT_JOINT[JointType_Count] =
+{
+	-1, JointType_SpineBase, JointType_SpineShoulder, JointType_Neck,
+	JointType_SpineShoulder, JointType_ShoulderLeft, JointType_ElbowLeft, JointType_WristLeft,
+	JointType_SpineShoulder, JointType_ShoulderRight, JointType_ElbowRight, JointType_WristRight,
+	JointType_SpineBase, JointType_HipLeft, JointType_KneeLeft, JointType_AnkleLeft,
+	JointType_SpineBase, JointType_HipRight, JointType_KneeRight, JointType_AnkleRight,
+	JointType_SpineMid, JointType_HandLeft, JointType_HandLeft, JointType_HandRight, JointType_HandRight,
+};
+
+// frame  ð  ޾ joint  踦 ״´. (slot 0 = root)
+// ȸ block (joint 4 )  x, y, z, w    SoA  ΰ,   4 joint  Ѵ.
+class CJointMotionAccumulator
+{
+	struct FSlotState
+	{
+		DWORD TrackedFrameCount;
+		DWORD LossSpanCount;
+		double LossSeconds;
+		double LongestLossSeconds;
+		double LossBeginTime;
+		bool bLost;
+
+		ULONGLONG BoneCount;				// Welford
+		double BoneMean;
+		double BoneM2;
+	};
+
+	int SlotCount;
+	int BlockCount;
+	std::vector<int> BoneParents;			// slot  parent slot (-1 : bone  )
+
+	std::vector<XMVECTOR> PrevQuat;			// [block * 4 + c] c = x, y, z, w. lane k = slot block * 4 + k
+	std::vector<XMVECTOR> CurQuat;
+	std::vector<XMVECTOR> PrevQuatMask;		// [block]
+	std::vector<XMVECTOR> CurQuatMask;
+	std::vector<XMVECTOR> PrevOmega;		// [block * 3 + c]   angular velocity (radian/s)
+	std::vector<XMVECTOR> PrevOmegaMask;
+
+	std::vector<XMVECTOR> SpeedSum;			// [block] degree/s
+	std::vector<XMVECTOR> SpeedMax;
+	std::vector<XMVECTOR> SpeedCount;
+	std::vector<XMVECTOR> AccelerationSum;	// degree/s^2
+	std::vector<XMVECTOR> AccelerationMax;
+	std::vector<XMVECTOR> AccelerationCount;
+
+	std::vector<FSlotState> Slots;
+
+	ULONGLONG FrameCount;
+	double FirstTime;
+	double PrevTime;
+	double PrevInterval;
+	double MaxInterval;
+
+	XMVECTOR PrevRootPosition;
+	bool bPrevRootValid;
+	double RootSpeedSum;
+	double RootSpeedMax;
+	ULONGLONG RootSpeedCount;
+
+	void AccumulateRotations(double inInterval);
+
+public:
+	CJointMotionAccumulator(int inSlotCount, const int* inBoneParents);
+
+	// inTime (s)   frame  ũ  ϰ false
+	// inPositions/inPositionValid  nullptr ̸ ġ 
+	bool AddFrame(double inTime, const XMVECTOR* inQuats, const bool* inQuatValid, const XMVECTOR* inPositions, const bool* inPositionValid);
+
+	void Finish(const char* const* inJointNames, FClipAnalytics& outResult) const;
+};
+
+CJointMotionAccumulator::CJointMotionAccumulator(int inSlotCount, const int * inBoneParents)
+	: SlotCount(inSlotCount), BlockCount((inSlotCount + 3) / 4),
+	FrameCount(0), FirstTime(0.0), PrevTime(0.0), PrevInterval(0.0), MaxInterval(0.0),
+	bPrevRootValid(false), RootSpeedSum(0.0), RootSpeedMax(0.0), RootSpeedCount(0)
+{
+	BoneParents.assign(inBoneParents, inBoneParents + inSlotCount);
+
+	PrevQuat.resize(BlockCount * 4, XMVectorZero());
+	CurQuat.resize(BlockCount * 4, XMVectorZero());
+	PrevQuatMask.resize(BlockCount, XMVectorFalseInt());
+	CurQuatMask.resize(BlockCount, XMVectorFalseInt());
+	PrevOmega.resize(BlockCount * 3, XMVectorZero());
+	PrevOmegaMask.resize(BlockCount, XMVectorFalseInt());
+
+	SpeedSum.resize(BlockCount, XMVectorZero());
+	SpeedMax.resize(BlockCount, XMVectorZero());
+	SpeedCount.resize(BlockCount, XMVectorZero());
+	AccelerationSum.resize(BlockCount, XMVectorZero());
+	AccelerationMax.resize(BlockCount, XMVectorZero());
+	AccelerationCount.resize(BlockCount, XMVectorZero());
+
+	FSlotState slot;
+	memset(&slot, 0, sizeof(slot));
+	Slots.resize(SlotCount, slot);
+
+	PrevRootPosition = XMVectorZero();
+}
+
+void CJointMotionAccumulator::AccumulateRotations(double inInterval)
+{
+	const XMVECTOR zero = XMVectorZero();
+	const XMVECTOR one = XMVectorSplatOne();
+	const XMVECTOR two = XMVectorReplicate(2.0f);
+	const XMVECTOR minusOne = XMVectorReplicate(-1.0f);
+	const XMVECTOR epsilon = XMVectorReplicate(1e-7f);
+	const XMVECTOR rad2Deg = XMVectorReplicate(180.0f / XM_PI);
+	const XMVECTOR invInterval = XMVectorReplicate((float)(1.0 / inInterval));
+
+	// angular acceleration    ߽  ð .
+	const bool bHasPrevOmega = FrameCount >= 2;
+	const XMVECTOR invAccelerationInterval = XMVectorReplicate(bHasPrevOmega ? (float)(2.0 / (inInterval + PrevInterval)) : 0.0f);
+
+	for (int b = 0; b < BlockCount; ++b)
+	{
+		const XMVECTOR ax = PrevQuat[b * 4 + 0], ay = PrevQuat[b * 4 + 1], az = PrevQuat[b * 4 + 2], aw = PrevQuat[b * 4 + 3];
+		const XMVECTOR bx = CurQuat[b * 4 + 0], by = CurQuat[b * 4 + 1], bz = CurQuat[b * 4 + 2], bw = CurQuat[b * 4 + 3];
+
+		// delta = cur*inverse(prev) (world  ȸ ). ũⰡ 1  ƴϾ  atan2  ϹǷ ȭ ʴ´.
+		XMVECTOR w = aw * bw + ax * bx + ay * by + az * bz;
+		XMVECTOR vx = aw * bx - bw * ax + (ay * bz - az * by);
+		XMVECTOR vy = aw * by - bw * ay + (az * bx - ax * bz);
+		XMVECTOR vz = aw * bz - bw * az + (ax * by - ay * bx);
+
+		// q  -q   ȸ : ª  (w >= 0)
+		const XMVECTOR sign = XMVectorSelect(one, minusOne, XMVectorLess(w, zero));
+		vx = vx * sign;
+		vy = vy * sign;
+		vz = vz * sign;
+		w = XMVectorAbs(w);
+
+		const XMVECTOR vLength = XMVectorSqrt(vx * vx + vy * vy + vz * vz);
+		const XMVECTOR angle = two * XMVectorATan2(vLength, w);
+
+		const XMVECTOR mask = XMVectorAndInt(PrevQuatMask[b], CurQuatMask[b]);
+		const XMVECTOR speed = XMVectorSelect(zero, angle * invInterval * rad2Deg, mask);
+
+		SpeedSum[b] += speed;
+		SpeedMax[b] = XMVectorMax(SpeedMax[b], speed);
+		SpeedCount[b] += XMVectorSelect(zero, one, mask);
+
+		// omega = ȸ * angle / interval.   ȸ angle / |v| ~= 2
+		const XMVECTOR axisScale = XMVectorSelect(two, XMVectorDivide(angle, vLength), XMVectorGreater(vLength, epsilon)) * invInterval;
+		const XMVECTOR omegaX = vx * axisScale;
+		const XMVECTOR omegaY = vy * axisScale;
+		const XMVECTOR omegaZ = vz * axisScale;
+
+		if (bHasPrevOmega)
+		{
+			const XMVECTOR dx = omegaX - PrevOmega[b * 3 + 0];
+			const XMVECTOR dy = omegaY - PrevOmega[b * 3 + 1];
+			const XMVECTOR dz = omegaZ - PrevOmega[b * 3 + 2];
+
+			const XMVECTOR accelerationMask = XMVectorAndInt(mask, PrevOmegaMask[b]);
+			const XMVECTOR acceleration = XMVectorSelect(zero, XMVectorSqrt(dx * dx + dy * dy + dz * dz) * invAccelerationInterval * rad2Deg, accelerationMask);
+
+			AccelerationSum[b] += acceleration;
+			AccelerationMax[b] = XMVectorMax(AccelerationMax[b], acceleration);
+			AccelerationCount[b] += XMVectorSelect(zero, one, accelerationMask);
+		}
+
+		PrevOmega[b * 3 + 0] = omegaX;
+		PrevOmega[b * 3 + 1] = omegaY;
+		PrevOmega[b * 3 + 2] = omegaZ;
+		PrevOmegaMask[b] = mask;
+	}
+}
+
+bool CJointMotionAccumulator::AddFrame(double inTime, const XMVECTOR * inQuats, const bool * inQuatValid, const XMVECTOR * inPositions, const bool * inPositionValid)
+{
+	if (FrameCount > 0 && inTime <= PrevTime)
+		return false;
+
+	// SoA  ű.  block   lane  ׻ invalid
+	for (int b = 0; b < BlockCount; ++b)
+	{
+		unsigned int laneMask[4] = { 0, 0, 0, 0 };
+
+		for (int k = 0; k < 4; ++k)
+		{
+			const int slot = b * 4 + k;
+			const XMVECTOR quat = slot < SlotCount ? inQuats[slot] : XMQuaternionIdentity();
+
+			for (int c = 0; c < 4; ++c)
+			{
+				CurQuat[b * 4 + c].m128_f32[k] = quat.m128_f32[c];
+			}
+
+			laneMask[k] = (slot < SlotCount && inQuatValid[slot]) ? 0xFFFFFFFF : 0;
+		}
+
+		CurQuatMask[b] = XMVectorSetInt(laneMask[0], laneMask[1], laneMask[2], laneMask[3]);
+	}
+
+	const double interval = FrameCount > 0 ? inTime - PrevTime : 0.0;
+
+	if (FrameCount > 0)
+	{
+		MaxInterval = std::max(MaxInterval, interval);
+		AccumulateRotations(interval);
+	}
+	else
+	{
+		FirstTime = inTime;
+	}
+
+	for (int s = 0; s < SlotCount; ++s)
+	{
+		FSlotState& slot = Slots[s];
+
+		if (inQuatValid[s])
+		{
+			++slot.TrackedFrameCount;
+
+			if (slot.bLost)
+			{
+				const double lossSeconds = inTime - slot.LossBeginTime;
+				slot.LossSeconds += lossSeconds;
+				slot.LongestLossSeconds = std::max(slot.LongestLossSeconds, lossSeconds);
+				slot.bLost = false;
+			}
+		}
+		else if (!slot.bLost)
+		{
+			slot.bLost = true;
+			slot.LossBeginTime = inTime;
+			++slot.LossSpanCount;
+		}
+
+		const int parent = BoneParents[s];
+		if (inPositions && parent >= 0 && inPositionValid[s] && inPositionValid[parent])
+		{
+			const double length = XMVectorGetX(XMVector3Length(inPositions[s] - inPositions[parent]));
+
+			++slot.BoneCount;
+			const double delta = length - slot.BoneMean;
+			slot.BoneMean += delta / (double)slot.BoneCount;
+			slot.BoneM2 += delta * (length - slot.BoneMean);
+		}
+	}
+
+	const bool bRootValid = inPositions && inPositionValid[0];
+	if (bRootValid && bPrevRootValid && interval > 0.0)
+	{
+		const double speed = XMVectorGetX(XMVector3Length(inPositions[0] - PrevRootPosition)) / interval;
+
+		RootSpeedSum += speed;
+		RootSpeedMax = std::max(RootSpeedMax, speed);
+		++RootSpeedCount;
+	}
+
+	if (bRootValid)
+	{
+		PrevRootPosition = inPositions[0];
+	}
+	bPrevRootValid = bRootValid;
+
+	std::swap(PrevQuat, CurQuat);
+	std::swap(PrevQuatMask, CurQuatMask);
+
+	PrevTime = inTime;
+	PrevInterval = interval;
+	++FrameCount;
+
+	return true;
+}
+
+void CJointMotionAccumulator::Finish(const char * const * inJointNames, FClipAnalytics & outResult) const
+{
+	outResult.FrameCount = (DWORD)FrameCount;
+	outResult.Duration = FrameCount > 0 ? (float)(PrevTime - FirstTime) : 0.0f;
+	outResult.MaxFrameInterval = (float)MaxInterval;
+	outResult.RootSpeedMean = RootSpeedCount > 0 ? (float)(RootSpeedSum / (double)RootSpeedCount) : 0.0f;
+	outResult.RootSpeedMax = (float)RootSpeedMax;
+
+	outResult.Joints.resize(SlotCount);
+
+	for (int s = 0; s < SlotCount; ++s)
+	{
+		const int b = s / 4;
+		const int k = s % 4;
+
+		const FSlotState& slot = Slots[s];
+		FJointAnalytics& joint = outResult.Joints[s];
+
+		joint.JointName = inJointNames[s];
+
+		const float speedCount = SpeedCount[b].m128_f32[k];
+		const float accelerationCount = AccelerationCount[b].m128_f32[k];
+
+		joint.AngularSpeedMean = speedCount > 0.0f ? SpeedSum[b].m128_f32[k] / speedCount : 0.0f;
+		joint.AngularSpeedMax = SpeedMax[b].m128_f32[k];
+		joint.AngularAccelerationMean = accelerationCount > 0.0f ? AccelerationSum[b].m128_f32[k] / accelerationCount : 0.0f;
+		joint.AngularAccelerationMax = AccelerationMax[b].m128_f32[k];
+
+		joint.BoneLengthMean = (float)slot.BoneMean;
+		joint.BoneLengthStdDev = slot.BoneCount > 1 ? (float)sqrt(slot.BoneM2 / (double)(slot.BoneCount - 1)) : 0.0f;
+
+		joint.TrackedFrameCount = slot.TrackedFrameCount;
+
+		//   ȸ  joint (Kinect   joint )  սǷ  ʴ´.
+		if (slot.TrackedFrameCount == 0)
+		{
+			joint.LossSpanCount = 0;
+			joint.LossSeconds = 0.0f;
+			joint.LongestLossSeconds = 0.0f;
+			continue;
+		}
+
+		double lossSeconds = slot.LossSeconds;
+		double longestLossSeconds = slot.LongestLossSeconds;
+
+		//  ̾ ս 
+		if (slot.bLost)
+		{
+			lossSeconds += PrevTime - slot.LossBeginTime;
+			longestLossSeconds = std::max(longestLossSeconds, PrevTime - slot.LossBeginTime);
+		}
+
+		joint.LossSpanCount = slot.LossSpanCount;
+		joint.LossSeconds = (float)lossSeconds;
+		joint.LongestLossSeconds = (float)longestLossSeconds;
+	}
+}
+
+static void ResetResult(const std::string& inFileName, bool bCapture, FClipAnalytics& outResult)
+{
+	outResult.FileName = inFileName;
+	outResult.bValid = false;
+	outResult.bCapture = bCapture;
+	outResult.FrameCount = 0;
+	outResult.Duration = 0.0f;
+	outResult.MaxFrameInterval = 0.0f;
+	outResult.RootSpeedMean = 0.0f;
+	outResult.RootSpeedMax = 0.0f;
+	outResult.Joints.clear();
+}
+
+bool CCaptureAnalyzer::AnalyzeCapture(const std::string & inFileName, FClipAnalytics & outResult)
+{
+	ResetResult(inFileName, true, outResult);
+
+	CKinectCaptureStream stream;
+	if (!stream.Open(inFileName))
+		return false;
+
+	CJointMotionAccumulator accumulator(JointType_Count, KINECT_PARENT_JOINT);
+
+	std::vector<sKinectFrame> frames(CAPTURE_BATCH_FRAME_COUNT);
+
+	XMVECTOR quats[JointType_Count];
+	XMVECTOR positions[JointType_Count];
+	bool quatValid[JointType_Count];
+	bool positionValid[JointType_Count];
+
+	size_t count;
+	while ((count = stream.Read(frames.data(), frames.size())) > 0)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			const sKinectFrame& frame = frames[i];
+
+			for (int j = 0; j < JointType_Count; ++j)
+			{
+				quats[j] = XMQuaternionIdentity();
+				positions[j] = XMVectorZero();
+				quatValid[j] = false;
+				positionValid[j] = false;
+			}
+
+			for (int k = 0; k < frame.PosCount; ++k)
+			{
+				const int jointType = frame.Pos[k].JointType;
+				if (jointType < 0 || jointType >= JointType_Count)
+					continue;
+
+				positions[jointType] = Vector4ToXMVECTOR(frame.Pos[k].Position);
+				positionValid[jointType] = true;
+			}
+
+			for (int k = 0; k < frame.RotCount; ++k)
+			{
+				const int jointType = frame.Rot[k].JointType;
+				if (jointType < 0 || jointType >= JointType_Count)
+					continue;
+
+				// 0 quaternion : Kinect  ȸ   joint
+				const Vector4& quat = frame.Rot[k].Quaternion;
+				if (quat.x == 0.0f && quat.y == 0.0f && quat.z == 0.0f && quat.w == 0.0f)
+					continue;
+
+				quats[jointType] = Vector4ToXMVECTOR(quat);
+				quatValid[jointType] = true;
+			}
+
+			accumulator.AddFrame(frame.MilliSecond * 0.001, quats, quatValid, positions, positionValid);
+		}
+	}
+
+	accumulator.Finish(KINECT_JOINT_NAMES, outResult);
+	outResult.bValid = outResult.FrameCount > 0;
+
+	return outResult.bValid;
+}
+
+bool CCaptureAnalyzer::AnalyzeBVH(const std::string & inFileName, FClipAnalytics & outResult)
+{
+	ResetResult(inFileName, false, outResult);
+
+	CBVHFileReader reader;
+	if (!reader.Open(inFileName))
+		return false;
+
+	const auto& joints = reader.GetJoints();
+	const int jointCount = reader.GetJointCount();
+	const int channelCount = reader.GetChannelCount();
+	const size_t frameCount = reader.GetFrameCount();
+	const float frameTime = reader.GetFrameTime();
+
+	// BVH  bone ̴ ̹Ƿ root ̵ .
+	std::vector<int> boneParents(jointCount, -1);
+	std::vector<const char*> jointNames(jointCount);
+	for (int j = 0; j < jointCount; ++j)
+	{
+		jointNames[j] = joints[j].Name.c_str();
+	}
+
+	CJointMotionAccumulator accumulator(jointCount, boneParents.data());
+
+	std::vector<float> values(channelCount);
+	std::vector<XMVECTOR> quats(jointCount, XMQuaternionIdentity());
+	std::unique_ptr<bool[]> quatValid(new bool[jointCount]);
+	XMVECTOR rootPosition = XMVectorZero();
+	bool bRootPosition = joints[0].PositionChannel[0] >= 0 && joints[0].PositionChannel[1] >= 0 && joints[0].PositionChannel[2] >= 0;
+
+	const double deg2Rad = XM_PI / 180.0;
+
+	for (size_t f = 0; f < frameCount; ++f)
+	{
+		// տ ̾ Ƿ  ã ʴ´.
+		if (!reader.ReadFrame(f, values.data()))
+			break;
+
+		for (int j = 0; j < jointCount; ++j)
+		{
+			const FBVHChannelLayout& joint = joints[j];
+			quatValid[j] = joint.RotationChannel >= 0;
+
+			if (!quatValid[j])
+				continue;
+
+			const double euler[3] =
+			{
+				values[joint.RotationChannel] * deg2Rad,
+				values[joint.RotationChannel + 1] * deg2Rad,
+				values[joint.RotationChannel + 2] * deg2Rad,
+			};
+
+			const Quaternion quat = EulerToQuaternion(euler, joint.RotationOrder);
+			quats[j] = XMVectorSet((float)quat.x, (float)quat.y, (float)quat.z, (float)quat.w);
+		}
+
+		if (bRootPosition)
+		{
+			rootPosition = XMVectorSet(values[joints[0].PositionChannel[0]], values[joints[0].PositionChannel[1]], values[joints[0].PositionChannel[2]], 0.0f);
+		}
+
+		accumulator.AddFrame(f * (double)frameTime, quats.data(), quatValid.get(), bRootPosition ? &rootPosition : nullptr, &bRootPosition);
+	}
+
+	accumulator.Finish(jointNames.data(), outResult);
+	outResult.bValid = outResult.FrameCount > 0;
+
+	return outResult.bValid;
+}
+
+static bool HasExtension(const std::string& inFileName, const char* inExtension)
+{
+	const size_t length = strlen(inExtension);
+	if (inFileName.size() < length)
+		return false;
+
+	return _stricmp(inFileName.c_str() + inFileName.size() - length, inExtension) == 0;
+}
+
+bool CCaptureAnalyzer::AnalyzeFile(const std::string & inFileName, FClipAnalytics & outResult)
+{
+	if (HasExtension(inFileName, ".bvh") || HasExtension(inFileName, ".bvhb"))
+		return AnalyzeBVH(inFileName, outResult);
+
+	return AnalyzeCapture(inFileName, outResult);
+}
+
+void CCaptureAnalyzer::AnalyzeFiles(const std::vector<std::string>& inFileNames, std::vector<FClipAnalytics>& outResults, int inThreadCount)
+{
+	outResults.clear();
+	outResults.resize(inFileNames.size());
+
+	int threadCount = inThreadCount > 0 ? inThreadCount : (int)std::thread::hardware_concurrency();
+	threadCount = std::max(1, std::min(threadCount, (int)inFileNames.size()));
+
+	// ϸ ũⰡ ޶ ̸  ʰ, thread      .
+	std::atomic<size_t> nextIndex(0);
+
+	auto worker = [&]()
+	{
+		for (;;)
+		{
+			const size_t index = nextIndex++;
+			if (index >= inFileNames.size())
+				break;
+
+			AnalyzeFile(inFileNames[index], outResults[index]);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < threadCount; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+const char * CCaptureAnalyzer::GetSummaryHeader()
+{
+	return "file\ttype\tvalid\tframes\tduration_s\tmax_interval_ms\troot_speed_mean\troot_speed_max\t"
+		"fastest_joint\tangular_speed_max\tangular_accel_joint\tangular_accel_max\t"
+		"loss_spans\tlongest_loss_joint\tlongest_loss_s\tbone_var_joint\tbone_length_stddev\n";
+}
+
+void CCaptureAnalyzer::AppendSummary(const FClipAnalytics & inResult, std::string & outData)
+{
+	const FJointAnalytics* fastest = nullptr;
+	const FJointAnalytics* accelerating = nullptr;
+	const FJointAnalytics* longestLoss = nullptr;
+	const FJointAnalytics* boneVariance = nullptr;
+	DWORD lossSpanCount = 0;
+
+	for (auto const& joint : inResult.Joints)
+	{
+		if (fastest == nullptr || joint.AngularSpeedMax > fastest->AngularSpeedMax)
+			fastest = &joint;
+
+		if (accelerating == nullptr || joint.AngularAccelerationMax > accelerating->AngularAccelerationMax)
+			accelerating = &joint;
+
+		if (longestLoss == nullptr || joint.LongestLossSeconds > longestLoss->LongestLossSeconds)
+			longestLoss = &joint;
+
+		if (boneVariance == nullptr || joint.BoneLengthStdDev > boneVariance->BoneLengthStdDev)
+			boneVariance = &joint;
+
+		lossSpanCount += joint.LossSpanCount;
+	}
+
+	outData += inResult.FileName;
+
+	char buffer[512];
+	snprintf(buffer, sizeof(buffer),
+		"\t%s\t%d\t%u\t%.3f\t%.1f\t%.4f\t%.4f\t%s\t%.1f\t%s\t%.1f\t%u\t%s\t%.3f\t%s\t%.5f\n",
+		inResult.bCapture ? "capture" : "bvh", inResult.bValid ? 1 : 0,
+		(unsigned int)inResult.FrameCount, inResult.Duration, inResult.MaxFrameInterval * 1000.0f,
+		inResult.RootSpeedMean, inResult.RootSpeedMax,
+		fastest ? fastest->JointName.c_str() : "-", fastest ? fastest->AngularSpeedMax : 0.0f,
+		accelerating ? accelerating->JointName.c_str() : "-", accelerating ? accelerating->AngularAccelerationMax : 0.0f,
+		(unsigned int)lossSpanCount,
+		longestLoss ? longestLoss->JointName.c_str() : "-", longestLoss ? longestLoss->LongestLossSeconds : 0.0f,
+		boneVariance ? boneVariance->JointName.c_str() : "-", boneVariance ? boneVariance->BoneLengthStdDev : 0.0f);
+
+	outData += buffer;
+}
+
+bool CCaptureAnalyzer::WriteSummaryFile(const std::string & inFileName, const std::vector<FClipAnalytics>& inResults)
+{
+	std::string content = GetSummaryHeader();
+
+	for (auto const& result : inResults)
+	{
+		AppendSummary(result, content);
+	}
+
+	std::ofstream file(inFileName.c_str());
+	if (!file)
+		return false;
+
+	file << content;
+	file.close();
+
+	return !file.fail();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "bvhexport.h"
+
+struct FJointAnalytics
+{
+	std::string JointName;
+
+	float AngularSpeedMean;			// degree/s (  frame  ȸ )
+	float AngularSpeedMax;
+	float AngularAccelerationMean;	// degree/s^2 (  angular velocity  )
+	float AngularAccelerationMax;
+
+	float BoneLengthMean;			// parent joint  Ÿ (capture . BVH  bone ̰ ̹Ƿ 0)
+	float BoneLengthStdDev;
+
+	DWORD TrackedFrameCount;		// ȸ ִ frame 
+	DWORD LossSpanCount;			// ȸ  (0 quaternion Ǵ )   
+	float LossSeconds;				//    
+	float LongestLossSeconds;
+};
+
+// capture Ǵ export  BVH ϳ 
+struct FClipAnalytics
+{
+	std::string FileName;
+	bool bValid;					//   ߰ų    false
+	bool bCapture;					// true : Kinect capture (joint  JointType , world ȸ), false : BVH (hierarchy , local ȸ)
+
+	DWORD FrameCount;
+	float Duration;					// s
+	float MaxFrameInterval;			// s (capture  frame  Ȯο)
+
+	float RootSpeedMean;			// root ̵ ӵ ( /s : capture  m/s)
+	float RootSpeedMax;
+
+	std::vector<FJointAnalytics> Joints;
+};
+
+// capture / BVH    Ⱦ joint  踦 .
+// angular velocity/acceleration  joint 4  SoA (XMVECTOR lane = joint)  ϰ,
+//    thread  ϳ  óѴ.  ü ޸𸮿 ø ʴ´.
+// õ  clip  Ⱦ  AnalyzeFiles + WriteSummaryFile  clip     .
+class CCaptureAnalyzer
+{
+public:
+	// text/binary capture (CKinectCaptureStream  տ д´. ð ǵư record  ǳʶڴ)
+	static bool AnalyzeCapture(const std::string& inFileName, FClipAnalytics& outResult);
+
+	// CBVH::ExportFile / CBVHExportSink   BVH (text, "Binary: float32"). ȸ channel  Tait-Bryan 
+	static bool AnalyzeBVH(const std::string& inFileName, FClipAnalytics& outResult);
+
+	// Ȯڰ .bvh / .bvhb ̸ AnalyzeBVH, ƴϸ AnalyzeCapture
+	static bool AnalyzeFile(const std::string& inFileName, FClipAnalytics& outResult);
+
+	// inThreadCount  0 ̸ hardware thread . outResults  inFileNames 
+	static void AnalyzeFiles(const std::vector<std::string>& inFileNames, std::vector<FClipAnalytics>& outResults, int inThreadCount = 0);
+
+	// clip ϳ = tab     (  joint,   tracking ս, bone  ȭ  ū joint ...)
+	static const char* GetSummaryHeader();
+	static void AppendSummary(const FClipAnalytics& inResult, std::string& outData);
+
+	static bool WriteSummaryFile(const std::string& inFileName, const std::vector<FClipAnalytics>& inResults);
+};
@@ -0,0 +1,208 @@
+#include "stdafx.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "captureindex.h"
+#include "capturereader.h"
+
+// sidecar file layout : header + entries (little endian, packed)
+static const DWORD CAPTURE_INDEX_MAGIC = 0x5849434b;		// "KCIX"
+static const DWORD CAPTURE_INDEX_VERSION = 2;
+
+#pragma pack(push, 1)
+struct FCaptureIndexFileHeader
+{
+	DWORD Magic;
+	DWORD Version;
+	DWORD Stride;
+	DWORD RecordCount;
+	ULONGLONG CaptureFileSize;
+	ULONGLONG CaptureWriteTime;
+	ULONGLONG EntryCount;
+};
+
+struct FCaptureIndexFileEntry
+{
+	DWORD MilliSecond;
+	ULONGLONG Offset;
+};
+#pragma pack(pop)
+
+CKinectCaptureIndex::CKinectCaptureIndex() : Stride(DEFAULT_STRIDE), RecordCount(0), CaptureFileSize(0), CaptureWriteTime(0)
+{
+}
+
+void CKinectCaptureIndex::Reset(int inStride)
+{
+	Stride = inStride > 0 ? inStride : DEFAULT_STRIDE;
+	RecordCount = 0;
+	CaptureFileSize = 0;
+	CaptureWriteTime = 0;
+	Entries.clear();
+}
+
+void CKinectCaptureIndex::AddRecord(DWORD inMilliSecond, ULONGLONG inOffset)
+{
+	if (RecordCount % Stride == 0)
+	{
+		FCaptureIndexEntry entry = { inMilliSecond, inOffset };
+		Entries.push_back(entry);
+	}
+
+	++RecordCount;
+}
+
+void CKinectCaptureIndex::Build(const char * inData, size_t inSize, int inStride)
+{
+	Reset(inStride);
+	CaptureFileSize = inSize;
+
+	size_t pos = CKinectCaptureReader::FindRecordStart(inData, 0, inSize);
+	while (pos < inSize)
+	{
+		// record  timestamp line  
+		DWORD milliSecond = 0;
+		size_t cursor = pos;
+		while (cursor < inSize && inData[cursor] >= '0' && inData[cursor] <= '9')
+		{
+			milliSecond = milliSecond * 10 + (inData[cursor] - '0');
+			++cursor;
+		}
+
+		AddRecord(milliSecond, pos);
+
+		pos = CKinectCaptureReader::FindRecordStart(inData, cursor, inSize);
+	}
+}
+
+void CKinectCaptureIndex::Build(CKinectCaptureStream & ioStream, int inStride)
+{
+	Reset(inStride);
+	CaptureFileSize = ioStream.GetSize();
+
+	ioStream.Seek(0);
+
+	sKinectFrame frame;
+	for (ULONGLONG offset = ioStream.GetOffset(); ioStream.Read(&frame, 1) == 1; offset = ioStream.GetOffset())
+	{
+		AddRecord(frame.MilliSecond, offset);
+	}
+}
+
+bool CKinectCaptureIndex::Save(const std::string & inFileName) const
+{
+	std::ofstream myfile(inFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!myfile)
+		return false;
+
+	FCaptureIndexFileHeader header = { CAPTURE_INDEX_MAGIC, CAPTURE_INDEX_VERSION, (DWORD)Stride, (DWORD)RecordCount, CaptureFileSize, CaptureWriteTime, Entries.size() };
+	myfile.write((const char*)&header, sizeof(header));
+
+	for (auto const& value : Entries)
+	{
+		FCaptureIndexFileEntry entry = { value.MilliSecond, value.Offset };
+		myfile.write((const char*)&entry, sizeof(entry));
+	}
+
+	return myfile.good();
+}
+
+bool CKinectCaptureIndex::Load(const std::string & inFileName)
+{
+	Reset();
+
+	std::ifstream myfile(inFileName, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!myfile)
+		return false;
+
+	const ULONGLONG fileSize = (ULONGLONG)myfile.tellg();
+	myfile.seekg(0);
+
+	FCaptureIndexFileHeader header;
+	if (fileSize < sizeof(header) ||
+		!myfile.read((char*)&header, sizeof(header)) ||
+		header.Magic != CAPTURE_INDEX_MAGIC ||
+		header.Version != CAPTURE_INDEX_VERSION ||
+		header.Stride == 0)
+	{
+		return false;
+	}
+
+	// entry  sidecar ũ, record  ¾ƾ Ѵ. (߸ų  Ϸ ū resize   ʵ)
+	const ULONGLONG entryCount = ((ULONGLONG)header.RecordCount + header.Stride - 1) / header.Stride;
+	if (header.EntryCount != entryCount ||
+		header.EntryCount != (fileSize - sizeof(header)) / sizeof(FCaptureIndexFileEntry) ||
+		(fileSize - sizeof(header)) % sizeof(FCaptureIndexFileEntry) != 0)
+	{
+		return false;
+	}
+
+	Stride = (int)header.Stride;
+	RecordCount = (int)header.RecordCount;
+	CaptureFileSize = header.CaptureFileSize;
+	CaptureWriteTime = header.CaptureWriteTime;
+
+	Entries.resize((size_t)header.EntryCount);
+	for (auto& value : Entries)
+	{
+		FCaptureIndexFileEntry entry;
+		if (!myfile.read((char*)&entry, sizeof(entry)))
+		{
+			Reset();
+			return false;
+		}
+
+		value.MilliSecond = entry.MilliSecond;
+		value.Offset = entry.Offset;
+	}
+
+	return true;
+}
+
+bool CKinectCaptureIndex::LoadOrBuild(const std::string & inCaptureFileName, CKinectCaptureStream & ioStream)
+{
+	std::string sidecarFileName = GetSidecarFileName(inCaptureFileName);
+
+	const ULONGLONG size = ioStream.GetSize();
+	const ULONGLONG lastWriteTime = ioStream.GetLastWriteTime();
+
+	if (Load(sidecarFileName) && CaptureFileSize == size && CaptureWriteTime == lastWriteTime && !Entries.empty())
+		return true;
+
+	if (ioStream.GetMappedData() != nullptr)
+	{
+		Build(ioStream.GetMappedData(), (size_t)size);
+	}
+	else
+	{
+		Build(ioStream);
+	}
+
+	CaptureWriteTime = lastWriteTime;
+
+	// sidecar 忡 ص  ü   ִ.
+	Save(sidecarFileName);
+
+	return !Entries.empty();
+}
+
+std::string CKinectCaptureIndex::GetSidecarFileName(const std::string & inCaptureFileName)
+{
+	return inCaptureFileName + ".idx";
+}
+
+ULONGLONG CKinectCaptureIndex::FindOffset(DWORD inMilliSecond) const
+{
+	if (Entries.empty())
+		return 0;
+
+	// inMilliSecond  ū ù entry  ٷ 
+	auto iter = std::upper_bound(Entries.begin(), Entries.end(), inMilliSecond,
+		[](DWORD time, const FCaptureIndexEntry& entry) { return time < entry.MilliSecond; });
+
+	if (iter == Entries.begin())
+		return iter->Offset;
+
+	return (iter - 1)->Offset;
+}
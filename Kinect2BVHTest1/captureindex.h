@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+class CKinectCaptureStream;
+
+// capture file  timestamp -> byte offset  (Stride frame  ϳ)
+// <capture file>.idx sidecar  ؼ  session  Ϻ    Ѵ.
+// capture      ʴ´. ó    (LoadOrBuild) , capture  ٲ ٽ .
+struct FCaptureIndexEntry
+{
+	DWORD MilliSecond;				// record  timestamp
+	ULONGLONG Offset;				// record  byte offset ( capture   Ǭ  )
+};
+
+class CKinectCaptureIndex
+{
+	int Stride;
+	int RecordCount;				// ο ݿ record 
+	ULONGLONG CaptureFileSize;		// sidecar  ֽ Ȯο (ũ   ð)
+	ULONGLONG CaptureWriteTime;		// FILETIME (CMappedFile::GetLastWriteTime)
+
+	std::vector<FCaptureIndexEntry> Entries;
+
+	void AddRecord(DWORD inMilliSecond, ULONGLONG inOffset);
+
+public:
+	static const int DEFAULT_STRIDE = 64;
+
+	CKinectCaptureIndex();
+
+	void Reset(int inStride = DEFAULT_STRIDE);
+
+	// ̹ ִ text capture  ó Ⱦ  
+	void Build(const char* inData, size_t inSize, int inStride = DEFAULT_STRIDE);
+
+	//  capture ó mapping    capture  record  ʷ 鼭 . (ioStream    ° ȴ)
+	void Build(CKinectCaptureStream& ioStream, int inStride = DEFAULT_STRIDE);
+
+	bool Save(const std::string& inFileName) const;
+	bool Load(const std::string& inFileName);
+
+	// sidecar  а, ų capture    (ũ⳪  ð ٸ)   
+	// ioStream : inCaptureFileName   stream.     ġ ٲ.
+	bool LoadOrBuild(const std::string& inCaptureFileName, CKinectCaptureStream& ioStream);
+
+	static std::string GetSidecarFileName(const std::string& inCaptureFileName);
+
+	bool IsEmpty() const { return Entries.empty(); }
+	ULONGLONG GetCaptureFileSize() const { return CaptureFileSize; }
+	ULONGLONG GetCaptureWriteTime() const { return CaptureWriteTime; }
+
+	// capture ù record  timestamp
+	DWORD GetBeginTime() const { return Entries.empty() ? 0 : Entries[0].MilliSecond; }
+
+	// inMilliSecond (ų )    record  offset
+	ULONGLONG FindOffset(DWORD inMilliSecond) const;
+};
@@ -0,0 +1,372 @@
+#include "stdafx.h"
+
+#include <string.h>
+
+#include "capturejournal.h"
+#include "mappedfile.h"
+#include "bvhexport.h"
+
+// journal file layout : header + records (little endian, packed)
+static const DWORD CAPTURE_JOURNAL_MAGIC = 0x4c4e4a4b;		// "KJNL"
+static const DWORD CAPTURE_JOURNAL_VERSION = 3;
+
+enum ECaptureJournalRecord
+{
+	ECaptureJournalRecord_Frame = 1,
+	ECaptureJournalRecord_Snapshot = 2,
+};
+
+#pragma pack(push, 1)
+struct FCaptureJournalFileHeader
+{
+	DWORD Magic;
+	DWORD Version;
+	DWORD JointCount;
+	DWORD Reserved;
+};
+
+struct FCaptureJournalRecordHeader
+{
+	DWORD Type;
+	DWORD Size;					// payload byte 
+	DWORD Checksum;				// payload  FNV-1a
+};
+
+// ڿ FCaptureJournalState + char[JointCount]  ٴ´.
+struct FCaptureJournalSnapshot
+{
+	ULONGLONG FrameCount;
+	DWORD LastElapseTime;
+	DWORD Reserved;
+};
+#pragma pack(pop)
+
+static DWORD CalculateChecksum(const char* inData, size_t inSize)
+{
+	DWORD hash = 2166136261u;
+	for (size_t i = 0; i < inSize; ++i)
+	{
+		hash ^= (unsigned char)inData[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static bool TruncateJournalFile(const std::string& inFileName, ULONGLONG inSize)
+{
+	HANDLE file = CreateFileA(inFileName.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER position;
+	position.QuadPart = (LONGLONG)inSize;
+
+	bool bResult = SetFilePointerEx(file, position, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+
+	CloseHandle(file);
+
+	return bResult;
+}
+
+CCaptureJournal::CCaptureJournal() : JointCount(0), PayloadSize(0), StateSize(0), SlotSize(0), QueueCapacity(0), QueueHead(0), QueueTail(0), SnapshotInterval(DEFAULT_SNAPSHOT_INTERVAL), FrameCount(0), LastElapseTime(0), bWriteFailed(false), bSnapshotValid(false), bStop(false)
+{
+}
+
+CCaptureJournal::~CCaptureJournal()
+{
+	Close();
+}
+
+bool CCaptureJournal::Open(const std::string & inFileName, int inJointCount, const FCaptureJournalResumeInfo * inResumeInfo, int inSnapshotInterval, int inQueueSize)
+{
+	Close();
+
+	JointCount = inJointCount;
+	PayloadSize = sizeof(DWORD) + sizeof(FCaptureJournalJoint) * JointCount;
+	StateSize = sizeof(FCaptureJournalState) + JointCount;
+	SlotSize = PayloadSize + StateSize;
+
+	SnapshotInterval = inSnapshotInterval > 0 ? inSnapshotInterval : DEFAULT_SNAPSHOT_INTERVAL;
+
+	Snapshot.assign(sizeof(FCaptureJournalSnapshot) + StateSize, 0);
+	bSnapshotValid = false;
+
+	if (inResumeInfo)
+	{
+		// ߰  record   ̾ .
+		if (!TruncateJournalFile(inFileName, inResumeInfo->ValidSize))
+			return false;
+
+		File.open(inFileName.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+
+		FrameCount = inResumeInfo->FrameCount;
+		LastElapseTime = inResumeInfo->LastElapseTime;
+	}
+	else
+	{
+		File.open(inFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+		FCaptureJournalFileHeader header = { CAPTURE_JOURNAL_MAGIC, CAPTURE_JOURNAL_VERSION, (DWORD)JointCount, 0 };
+		File.write((const char*)&header, sizeof(header));
+		File.flush();
+
+		FrameCount = 0;
+		LastElapseTime = 0;
+	}
+
+	if (!File.good())
+	{
+		File.close();
+		return false;
+	}
+
+	QueueCapacity = inQueueSize > 0 ? inQueueSize : DEFAULT_QUEUE_SIZE;
+	Queue.assign(QueueCapacity * SlotSize, 0);
+	QueueHead = 0;
+	QueueTail = 0;
+
+	bWriteFailed = false;
+	bStop = false;
+
+	Writer = std::thread(&CCaptureJournal::WriterThread, this);
+
+	return true;
+}
+
+void CCaptureJournal::Close()
+{
+	if (!Writer.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		bStop = true;
+	}
+
+	DataReady.notify_all();
+	Writer.join();
+
+	//    snapshot  . (̹  frame    snapshot ״)
+	if (bSnapshotValid)
+	{
+		FCaptureJournalSnapshot snapshot = { FrameCount, LastElapseTime, 0 };
+		memcpy(Snapshot.data(), &snapshot, sizeof(snapshot));
+
+		WriteRecord(ECaptureJournalRecord_Snapshot, Snapshot.data(), Snapshot.size());
+	}
+
+	File.close();
+}
+
+bool CCaptureJournal::Append(const FRawBVHFrame & inFrame, const FCaptureJournalState & inState, const char * inMissingJoints)
+{
+	ULONGLONG index = 0;
+
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		SpaceReady.wait(lock, [this] { return QueueHead - QueueTail < QueueCapacity || bWriteFailed; });
+
+		if (bWriteFailed)
+			return false;
+
+		index = QueueHead;
+	}
+
+	//  ڸ WriterThread   Ƿ lock  ä.
+	char* payload = &Queue[(size_t)(index % QueueCapacity) * SlotSize];
+
+	memcpy(payload, &inFrame.ElapseTime, sizeof(DWORD));
+
+	FCaptureJournalJoint* joints = (FCaptureJournalJoint*)(payload + sizeof(DWORD));
+	for (int j = 0; j < JointCount; ++j)
+	{
+		const auto& frameInfo = inFrame.FrameInfo[j];
+
+		memcpy(joints[j].WorldQuat, frameInfo.WorldQuat.m128_f32, sizeof(joints[j].WorldQuat));
+		memcpy(joints[j].Position, frameInfo.Position.m128_f32, sizeof(joints[j].Position));
+		joints[j].Initialized = frameInfo.Initialized ? 1 : 0;
+	}
+
+	memcpy(payload + PayloadSize, &inState, sizeof(inState));
+	memcpy(payload + PayloadSize + sizeof(inState), inMissingJoints, JointCount);
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		++QueueHead;
+	}
+
+	DataReady.notify_one();
+
+	return true;
+}
+
+void CCaptureJournal::Flush()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	SpaceReady.wait(lock, [this] { return QueueTail == QueueHead || bWriteFailed; });
+}
+
+void CCaptureJournal::WriteRecord(DWORD inType, const char * inPayload, size_t inSize)
+{
+	FCaptureJournalRecordHeader header = { inType, (DWORD)inSize, CalculateChecksum(inPayload, inSize) };
+
+	File.write((const char*)&header, sizeof(header));
+	File.write(inPayload, inSize);
+}
+
+void CCaptureJournal::WriterThread()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	for (;;)
+	{
+		DataReady.wait(lock, [this] { return bStop || QueueTail != QueueHead; });
+
+		const ULONGLONG begin = QueueTail;
+		const ULONGLONG end = QueueHead;
+
+		if (begin == end && bStop)
+			break;
+
+		// [begin, end)  Append  ǵ帮 Ƿ lock  .
+		lock.unlock();
+
+		for (ULONGLONG i = begin; i < end; ++i)
+		{
+			const char* payload = &Queue[(size_t)(i % QueueCapacity) * SlotSize];
+
+			WriteRecord(ECaptureJournalRecord_Frame, payload, PayloadSize);
+
+			memcpy(&LastElapseTime, payload, sizeof(DWORD));
+			++FrameCount;
+
+			const bool bSnapshot = FrameCount % SnapshotInterval == 0;
+			if (bSnapshot || i + 1 == end)
+			{
+				FCaptureJournalSnapshot snapshot = { FrameCount, LastElapseTime, 0 };
+				memcpy(Snapshot.data(), &snapshot, sizeof(snapshot));
+				memcpy(Snapshot.data() + sizeof(snapshot), payload + PayloadSize, StateSize);
+				bSnapshotValid = true;
+
+				if (bSnapshot)
+				{
+					WriteRecord(ECaptureJournalRecord_Snapshot, Snapshot.data(), Snapshot.size());
+				}
+			}
+		}
+
+		//  OS  ѱ.
+		File.flush();
+
+		lock.lock();
+
+		QueueTail = end;
+		if (!File.good())
+			bWriteFailed = true;
+
+		SpaceReady.notify_all();
+	}
+}
+
+bool CCaptureJournal::Read(const std::string & inFileName, int inJointCount, const std::function<void(ULONGLONG, DWORD, const FCaptureJournalJoint*)>& inFrameFunc, FCaptureJournalResumeInfo & outInfo)
+{
+	outInfo.FrameCount = 0;
+	outInfo.LastElapseTime = 0;
+	outInfo.SnapshotFrameCount = 0;
+	memset(&outInfo.SnapshotState, 0, sizeof(outInfo.SnapshotState));
+	outInfo.SnapshotMissingJoints.assign(inJointCount, 0);
+	outInfo.ValidSize = 0;
+
+	CMappedFile file;
+	if (!file.Open(inFileName))
+		return false;
+
+	const char* data = file.GetData();
+	const size_t size = file.GetSize();
+
+	FCaptureJournalFileHeader header;
+	if (size < sizeof(header))
+		return false;
+
+	memcpy(&header, data, sizeof(header));
+	if (header.Magic != CAPTURE_JOURNAL_MAGIC ||
+		header.Version != CAPTURE_JOURNAL_VERSION ||
+		header.JointCount != (DWORD)inJointCount)
+	{
+		return false;
+	}
+
+	const size_t payloadSize = sizeof(DWORD) + sizeof(FCaptureJournalJoint) * inJointCount;
+	const size_t snapshotSize = sizeof(FCaptureJournalSnapshot) + sizeof(FCaptureJournalState) + inJointCount;
+
+	// 1.  record    snapshot
+	size_t offset = sizeof(header);
+	outInfo.ValidSize = offset;
+
+	while (offset + sizeof(FCaptureJournalRecordHeader) <= size)
+	{
+		FCaptureJournalRecordHeader recordHeader;
+		memcpy(&recordHeader, data + offset, sizeof(recordHeader));
+
+		const char* payload = data + offset + sizeof(recordHeader);
+		if (recordHeader.Size > size - offset - sizeof(recordHeader) ||
+			CalculateChecksum(payload, recordHeader.Size) != recordHeader.Checksum)
+		{
+			break;		// ٰ  record
+		}
+
+		if (recordHeader.Type == ECaptureJournalRecord_Frame && recordHeader.Size == payloadSize)
+		{
+			memcpy(&outInfo.LastElapseTime, payload, sizeof(DWORD));
+			++outInfo.FrameCount;
+		}
+		else if (recordHeader.Type == ECaptureJournalRecord_Snapshot && recordHeader.Size == snapshotSize)
+		{
+			FCaptureJournalSnapshot snapshot;
+			memcpy(&snapshot, payload, sizeof(snapshot));
+
+			//  frame record   ʴ snapshot   ʴ´.
+			if (snapshot.FrameCount == outInfo.FrameCount)
+			{
+				outInfo.SnapshotFrameCount = snapshot.FrameCount;
+				memcpy(&outInfo.SnapshotState, payload + sizeof(snapshot), sizeof(FCaptureJournalState));
+				memcpy(outInfo.SnapshotMissingJoints.data(), payload + sizeof(snapshot) + sizeof(FCaptureJournalState), inJointCount);
+			}
+		}
+		else
+		{
+			break;
+		}
+
+		offset += sizeof(recordHeader) + recordHeader.Size;
+		outInfo.ValidSize = offset;
+	}
+
+	// 2. frame record (checksum   Ȯ)
+	// record  ؼ  .
+	std::vector<FCaptureJournalJoint> joints(inJointCount);
+
+	ULONGLONG frameIndex = 0;
+
+	for (offset = sizeof(header); offset < outInfo.ValidSize; )
+	{
+		FCaptureJournalRecordHeader recordHeader;
+		memcpy(&recordHeader, data + offset, sizeof(recordHeader));
+
+		const char* payload = data + offset + sizeof(recordHeader);
+
+		if (recordHeader.Type == ECaptureJournalRecord_Frame)
+		{
+			DWORD elapseTime = 0;
+			memcpy(&elapseTime, payload, sizeof(DWORD));
+			memcpy(joints.data(), payload + sizeof(DWORD), sizeof(FCaptureJournalJoint) * inJointCount);
+
+			inFrameFunc(frameIndex++, elapseTime, joints.data());
+		}
+
+		offset += sizeof(recordHeader) + recordHeader.Size;
+	}
+
+	return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct FRawBVHFrame;
+
+// journal  ϵǴ joint ϳ Է  (CBVH SortedJointArray )
+struct FCaptureJournalJoint
+{
+	float WorldQuat[4];
+	float Position[4];
+	DWORD Initialized;
+};
+
+// snapshot    CBVH   (End  ). resume ϸ   ̾.
+// ڿ RawMissingJoints (joint  char)  ٴ´.
+struct FCaptureJournalState
+{
+	ULONGLONG RawInputHash;
+	ULONGLONG EmitRawIndex;
+	ULONGLONG EmittedFrameCount;
+	DWORD EmitBeginTime;
+	DWORD RawInputHashValid;
+	float EmitRootOrigin[3];
+};
+
+//  snapshot   record  
+struct FCaptureJournalResumeInfo
+{
+	ULONGLONG FrameCount;				//  frame 
+	DWORD LastElapseTime;				//  frame  timestamp
+	ULONGLONG SnapshotFrameCount;		//  snapshot  frame  (0 ̸ snapshot )
+	FCaptureJournalState SnapshotState;
+	std::vector<char> SnapshotMissingJoints;
+	ULONGLONG ValidSize;				//  ڴ ߰  record ̹Ƿ ߶󳽴.
+};
+
+//   capture   ʱ  append-only journal
+// CBVH::End  frame  Է  ̸   queue  ϰ, background thread   Ͽ .
+// SnapshotInterval frame  snapshot record (frame ,  timestamp,  frame  FCaptureJournalState)  .
+//   flush ϹǷ process  ׾ OS  Ѿ record  ´.
+//
+// file : header + record (type, payload ũ, checksum, payload)   (packed)
+class CCaptureJournal
+{
+	int JointCount;
+	size_t PayloadSize;					// frame record payload : DWORD ElapseTime + FCaptureJournalJoint[JointCount]
+	size_t StateSize;					// FCaptureJournalState + char[JointCount]
+	size_t SlotSize;					// queue  ĭ : payload + state
+
+	std::ofstream File;
+
+	// Append (capture thread) -> WriterThread  ѱ ring
+	std::vector<char> Queue;
+	size_t QueueCapacity;				// frame 
+	ULONGLONG QueueHead;				//  frame 
+	ULONGLONG QueueTail;				// Ͽ  frame 
+
+	int SnapshotInterval;
+	ULONGLONG FrameCount;				// journal ü frame  (resume  )
+	DWORD LastElapseTime;
+	bool bWriteFailed;
+
+	std::vector<char> Snapshot;			// snapshot record payload (WriterThread    frame  )
+	bool bSnapshotValid;
+
+	std::thread Writer;
+	std::mutex Mutex;
+	std::condition_variable DataReady;
+	std::condition_variable SpaceReady;
+	bool bStop;
+
+	void WriterThread();
+	void WriteRecord(DWORD inType, const char* inPayload, size_t inSize);
+
+	CCaptureJournal(const CCaptureJournal&) = delete;
+	CCaptureJournal& operator=(const CCaptureJournal&) = delete;
+
+public:
+	static const int DEFAULT_QUEUE_SIZE = 256;
+	static const int DEFAULT_SNAPSHOT_INTERVAL = 300;
+
+	CCaptureJournal();
+	~CCaptureJournal();
+
+	// inResumeInfo   ValidSize ڸ ߶󳻰 ̾ .   .
+	bool Open(const std::string& inFileName, int inJointCount, const FCaptureJournalResumeInfo* inResumeInfo = nullptr,
+		int inSnapshotInterval = DEFAULT_SNAPSHOT_INTERVAL, int inQueueSize = DEFAULT_QUEUE_SIZE);
+
+	//  record    thread  .
+	void Close();
+
+	bool IsOpen() const { return Writer.joinable(); }
+
+	// capture thread  ȣ. heap Ҵ  queue  縸 Ѵ. (queue    ڸ   ٸ)
+	// inMissingJoints : joint  char. snapshot   frame  ɸ inState   ϵȴ.
+	bool Append(const FRawBVHFrame& inFrame, const FCaptureJournalState& inState, const char* inMissingJoints);
+
+	// ݱ Append  frame  Ͽ   ٸ.
+	void Flush();
+
+	//   record    snapshot  ã outInfo  ä ,
+	//   frame record  inFrameFunc(frame index, ElapseTime, joints) ȣ
+	// (index < outInfo.SnapshotFrameCount  frame  snapshot ¿ ̹ ݿǾ ִ)
+	static bool Read(const std::string& inFileName, int inJointCount,
+		const std::function<void(ULONGLONG, DWORD, const FCaptureJournalJoint*)>& inFrameFunc, FCaptureJournalResumeInfo& outInfo);
+};
@@ -0,0 +1,313 @@
+#include "stdafx.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "capturemerge.h"
+#include "bvhexport.h"
+#include "blockcompress.h"
+
+// session  CKinectCaptureStream    д record 
+static const size_t CAPTURE_MERGE_BLOCK_SIZE = 16;
+
+// WriteFile  ̸ŭ ̸ Ͽ . (byte)
+static const size_t CAPTURE_MERGE_WRITE_SIZE = 1 << 20;
+
+CCaptureMerger::FSession::FSession(const FCaptureSessionOptions & inOptions)
+	: Options(inOptions), Block(CAPTURE_MERGE_BLOCK_SIZE), BlockIndex(0), BlockCount(0), State(ESessionState_Waiting),
+	FirstRawTime(0), LastRawTime(0), StartTime(0), EndTime(0), Stats()
+{
+}
+
+CCaptureMerger::CCaptureMerger(ECaptureOverlapRule inOverlapRule)
+	: OverlapRule(inOverlapRule), bHasOutput(false), LastOutputTime(0)
+{
+}
+
+int CCaptureMerger::AddSession(const FCaptureSessionOptions & inOptions)
+{
+	Sessions.emplace_back(new FSession(inOptions));
+	return (int)Sessions.size() - 1;
+}
+
+bool CCaptureMerger::Open()
+{
+	Close();
+
+	for (auto& session : Sessions)
+	{
+		if (!session->Stream.Open(session->Options.FileName))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < Sessions.size(); ++i)
+	{
+		// bFollowPrevious session   session  Finish  Ѵ.
+		if (i == 0 || !Sessions[i]->Options.bFollowPrevious)
+		{
+			Activate((int)i, Sessions[i]->Options.StartTime);
+		}
+	}
+
+	return true;
+}
+
+void CCaptureMerger::Close()
+{
+	for (auto& session : Sessions)
+	{
+		session->Stream.Close();
+
+		session->BlockIndex = 0;
+		session->BlockCount = 0;
+		session->State = ESessionState_Waiting;
+		session->Stats = FCaptureMergeStats();
+	}
+
+	Heap.clear();
+
+	bHasOutput = false;
+	LastOutputTime = 0;
+}
+
+bool CCaptureMerger::FetchBlock(FSession & ioSession)
+{
+	ioSession.BlockIndex = 0;
+	ioSession.BlockCount = ioSession.Stream.Read(ioSession.Block.data(), ioSession.Block.size());
+	ioSession.Stats.ReadFrameCount += ioSession.BlockCount;
+
+	return ioSession.BlockCount > 0;
+}
+
+bool CCaptureMerger::Advance(FSession & ioSession)
+{
+	++ioSession.BlockIndex;
+
+	for (;;)
+	{
+		if (ioSession.BlockIndex >= ioSession.BlockCount && !FetchBlock(ioSession))
+			return false;
+
+		//  ȿ ð ǵư record
+		if (ioSession.GetHead().MilliSecond < ioSession.LastRawTime)
+		{
+			++ioSession.Stats.OutOfOrderFrameCount;
+			++ioSession.BlockIndex;
+			continue;
+		}
+
+		ioSession.LastRawTime = ioSession.GetHead().MilliSecond;
+		ioSession.EndTime = ioSession.GetHeadTime();
+		return true;
+	}
+}
+
+// head ð ̸ session  heap   (  ߰ session)
+bool CCaptureMerger::IsLaterHead(int inA, int inB) const
+{
+	const DWORD timeA = Sessions[inA]->GetHeadTime();
+	const DWORD timeB = Sessions[inB]->GetHeadTime();
+
+	if (timeA != timeB)
+		return timeA > timeB;
+
+	return inA > inB;
+}
+
+void CCaptureMerger::Activate(int inSessionIndex, DWORD inStartTime)
+{
+	FSession& session = *Sessions[inSessionIndex];
+
+	session.StartTime = inStartTime;
+	session.EndTime = inStartTime;
+
+	if (!FetchBlock(session))
+	{
+		Finish(inSessionIndex);
+		return;
+	}
+
+	session.FirstRawTime = session.GetHead().MilliSecond;
+	session.LastRawTime = session.FirstRawTime;
+	session.State = ESessionState_Active;
+
+	Heap.push_back(inSessionIndex);
+	std::push_heap(Heap.begin(), Heap.end(), [this](int inA, int inB) { return IsLaterHead(inA, inB); });
+}
+
+void CCaptureMerger::Finish(int inSessionIndex)
+{
+	FSession& session = *Sessions[inSessionIndex];
+	session.State = ESessionState_Finished;
+
+	const size_t next = (size_t)inSessionIndex + 1;
+	if (next < Sessions.size() && Sessions[next]->Options.bFollowPrevious && Sessions[next]->State == ESessionState_Waiting)
+	{
+		Activate((int)next, session.EndTime + Sessions[next]->Options.Gap);
+	}
+}
+
+bool CCaptureMerger::IsOwner(int inSessionIndex, DWORD inTime) const
+{
+	int owner = inSessionIndex;
+
+	for (int i = 0; i < (int)Sessions.size(); ++i)
+	{
+		const FSession& session = *Sessions[i];
+		if (session.State != ESessionState_Active || session.StartTime > inTime)
+			continue;
+
+		const DWORD startTime = session.StartTime;
+		const DWORD ownerStartTime = Sessions[owner]->StartTime;
+
+		if (OverlapRule == ECaptureOverlapRule_KeepFirst)
+		{
+			if (startTime < ownerStartTime || (startTime == ownerStartTime && i < owner))
+				owner = i;
+		}
+		else
+		{
+			if (startTime > ownerStartTime || (startTime == ownerStartTime && i > owner))
+				owner = i;
+		}
+	}
+
+	return owner == inSessionIndex;
+}
+
+bool CCaptureMerger::Read(sKinectFrame & outFrame)
+{
+	auto compare = [this](int inA, int inB) { return IsLaterHead(inA, inB); };
+
+	while (!Heap.empty())
+	{
+		std::pop_heap(Heap.begin(), Heap.end(), compare);
+		const int index = Heap.back();
+		Heap.pop_back();
+
+		FSession& session = *Sessions[index];
+		const DWORD time = session.GetHeadTime();
+
+		bool bOutput = false;
+
+		if (bHasOutput && time <= LastOutputTime)
+		{
+			++session.Stats.OutOfOrderFrameCount;
+		}
+		else if (!IsOwner(index, time))
+		{
+			++session.Stats.OverlapFrameCount;
+		}
+		else
+		{
+			outFrame = session.GetHead();
+			outFrame.MilliSecond = time;
+
+			bOutput = true;
+			bHasOutput = true;
+			LastOutputTime = time;
+
+			++session.Stats.MergedFrameCount;
+		}
+
+		//   session  , ڿ ̾ session   Finish  Ѵ.
+		if (Advance(session))
+		{
+			Heap.push_back(index);
+			std::push_heap(Heap.begin(), Heap.end(), compare);
+		}
+		else
+		{
+			Finish(index);
+		}
+
+		if (bOutput)
+			return true;
+	}
+
+	return false;
+}
+
+size_t CCaptureMerger::Replay(CBVH & outBVH)
+{
+	size_t count = 0;
+
+	sKinectFrame frame;
+	while (Read(frame))
+	{
+		CKinectCaptureReader::ReplayFrame(frame, outBVH);
+		++count;
+	}
+
+	return count;
+}
+
+bool CCaptureMerger::WriteFile(const std::string & inFileName, bool bBinary)
+{
+	// ".gz" ̸ block   
+	const bool bCompressed = CBlockCompressedWriter::IsCompressedFileName(inFileName);
+
+	CBlockCompressedWriter compressedWriter;
+	std::ofstream file;
+
+	if (bCompressed)
+	{
+		if (!compressedWriter.Open(inFileName))
+			return false;
+	}
+	else
+	{
+		file.open(inFileName.c_str(), std::ios::binary);
+		if (!file.is_open())
+			return false;
+	}
+
+	std::string data;
+	data.reserve(CAPTURE_MERGE_WRITE_SIZE + sizeof(sKinectFrame) * 4);
+
+	if (bBinary)
+	{
+		CKinectCaptureReader::AppendBinaryHeader(data);
+	}
+
+	sKinectFrame frame;
+	while (Read(frame))
+	{
+		if (bBinary)
+		{
+			CKinectCaptureReader::AppendBinaryRecord(frame, data);
+		}
+		else
+		{
+			CKinectCaptureReader::AppendTextRecord(frame, data);
+		}
+
+		if (data.size() >= CAPTURE_MERGE_WRITE_SIZE)
+		{
+			if (bCompressed)
+			{
+				compressedWriter.Write(data);
+			}
+			else
+			{
+				file.write(data.data(), data.size());
+			}
+
+			data.clear();
+		}
+	}
+
+	if (bCompressed)
+	{
+		compressedWriter.Write(data);
+		return compressedWriter.Close();
+	}
+
+	file.write(data.data(), data.size());
+	file.close();
+
+	return !file.fail();
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <Kinect.h>
+
+#include "capturereader.h"
+
+// ģ ð뿡  session  record  
+enum ECaptureOverlapRule
+{
+	ECaptureOverlapRule_KeepFirst,		//   session     session  record  .
+	ECaptureOverlapRule_KeepLast,		//  session  ϸ  session     session  record  .
+};
+
+// capture  ϳ ( take    Ͽ     ϳ)
+// ϸ ElapseTime  ٽ ϹǷ ù record  timeline  StartTime      ű.
+struct FCaptureSessionOptions
+{
+	std::string FileName;
+	DWORD StartTime;			// ù record  timeline ð (ms). bFollowPrevious ̸ 
+	bool bFollowPrevious;		// ٷ տ ߰ session   record + Gap   (ù session  StartTime)
+	DWORD Gap;					// (ms)
+
+	FCaptureSessionOptions(const std::string& inFileName, DWORD inStartTime = 0)
+		: FileName(inFileName), StartTime(inStartTime), bFollowPrevious(false), Gap(0)
+	{
+	}
+
+	FCaptureSessionOptions(const std::string& inFileName, bool inFollowPrevious, DWORD inGap)
+		: FileName(inFileName), StartTime(0), bFollowPrevious(inFollowPrevious), Gap(inGap)
+	{
+	}
+};
+
+struct FCaptureMergeStats
+{
+	ULONGLONG ReadFrameCount;			// Ͽ  record
+	ULONGLONG MergedFrameCount;			// timeline   record
+	ULONGLONG OverlapFrameCount;		// ģ ð  record
+	ULONGLONG OutOfOrderFrameCount;		// ð ǵưų ̹  ð Ƽ  record
+};
+
+//  capture session  timestamp  k-way merge  ϳ timeline  ̾ տ .
+// session  CKinectCaptureStream  CAPTURE_MERGE_BLOCK_SIZE  о ΰ,
+//  ̸ head record   session  heap   rebase  ð .
+// ġ ð ECaptureOverlapRule   session  Ƿ CBVH   ϴ frame  .
+// bFollowPrevious session   session    ڿ  ð . (  ̸  ʴ´)
+// session   ð CBVH  resampling  յ record  Ѵ.
+class CCaptureMerger
+{
+	enum ESessionState
+	{
+		ESessionState_Waiting,			// bFollowPrevious :  session  ⸦ ٸ
+		ESessionState_Active,
+		ESessionState_Finished,
+	};
+
+	struct FSession
+	{
+		FCaptureSessionOptions Options;
+		CKinectCaptureStream Stream;
+
+		std::vector<sKinectFrame> Block;
+		size_t BlockIndex;
+		size_t BlockCount;
+
+		ESessionState State;
+		DWORD FirstRawTime;				//  ù record  MilliSecond
+		DWORD LastRawTime;
+		DWORD StartTime;				// ù record  timeline ð
+		DWORD EndTime;					// ݱ   record  timeline ð
+
+		FCaptureMergeStats Stats;
+
+		explicit FSession(const FCaptureSessionOptions& inOptions);
+
+		const sKinectFrame& GetHead() const { return Block[BlockIndex]; }
+		DWORD GetHeadTime() const { return GetHead().MilliSecond - FirstRawTime + StartTime; }
+	};
+
+	ECaptureOverlapRule OverlapRule;
+	std::vector<std::unique_ptr<FSession>> Sessions;
+	std::vector<int> Heap;				// Active session index, head ð  ̸  
+
+	bool bHasOutput;
+	DWORD LastOutputTime;
+
+	CCaptureMerger(const CCaptureMerger&) = delete;
+	CCaptureMerger& operator=(const CCaptureMerger&) = delete;
+
+	bool FetchBlock(FSession& ioSession);
+	bool Advance(FSession& ioSession);
+	void Activate(int inSessionIndex, DWORD inStartTime);
+	void Finish(int inSessionIndex);
+	bool IsOwner(int inSessionIndex, DWORD inTime) const;
+	bool IsLaterHead(int inA, int inB) const;
+
+public:
+	explicit CCaptureMerger(ECaptureOverlapRule inOverlapRule = ECaptureOverlapRule_KeepLast);
+
+	// Open  timeline  ߰. ȯ : session index
+	int AddSession(const FCaptureSessionOptions& inOptions);
+	int GetSessionCount() const { return (int)Sessions.size(); }
+
+	//    ù block  д´. ϳ    false
+	bool Open();
+	void Close();
+
+	//  merged frame (MilliSecond  timeline ð). ̸ false
+	bool Read(sKinectFrame& outFrame);
+
+	//  frame   outBVH  ִ´. (inBVH  ref pose  import  ) ȯ :  frame 
+	size_t Replay(CBVH& outBVH);
+
+	//  frame  ϳ capture Ϸ  (text  capture   , ".gz" ̸ block  )
+	bool WriteFile(const std::string& inFileName, bool bBinary);
+
+	const FCaptureMergeStats& GetStats(int inSessionIndex) const { return Sessions[inSessionIndex]->Stats; }
+};
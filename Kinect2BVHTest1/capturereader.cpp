@@ -0,0 +1,847 @@
+#include "stdafx.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+#include "capturereader.h"
+#include "captureindex.h"
+#include "mappedfile.h"
+#include "bvhexport.h"
+
+// binary capture file
+static const DWORD CAPTURE_BINARY_MAGIC = 0x5041434b;		// "KCAP"
+static const DWORD CAPTURE_BINARY_VERSION = 1;
+
+//  capture    record ϳ ̺    ʴ  . (block ũ )
+static const size_t CAPTURE_STREAM_MAX_RECORD_SIZE = 1 << 16;
+
+#pragma pack(push, 1)
+struct FCaptureBinaryHeader
+{
+	DWORD Magic;
+	DWORD Version;
+	DWORD Reserved[2];
+};
+
+struct FCaptureBinaryRecordHeader
+{
+	DWORD MilliSecond;
+	WORD PosCount;
+	WORD RotCount;
+};
+
+struct FCaptureBinaryPosition
+{
+	DWORD JointType;
+	float Position[3];
+};
+
+struct FCaptureBinaryRotation
+{
+	DWORD JointType;
+	float Quaternion[4];
+};
+#pragma pack(pop)
+
+// inOffset  binary record ũ. ߷ ְų    0
+static size_t GetBinaryRecordSize(const char* inData, size_t inOffset, size_t inSize)
+{
+	FCaptureBinaryRecordHeader header;
+	if (inSize - inOffset < sizeof(header))
+		return 0;
+
+	memcpy(&header, inData + inOffset, sizeof(header));
+	if (header.PosCount > JointType_Count || header.RotCount > JointType_Count)
+		return 0;
+
+	size_t recordSize = sizeof(header) + header.PosCount * sizeof(FCaptureBinaryPosition) + header.RotCount * sizeof(FCaptureBinaryRotation);
+	if (inSize - inOffset < recordSize)
+		return 0;
+
+	return recordSize;
+}
+
+// GetBinaryRecordSize  Ȯ record ϳ outFrame  
+static void ReadBinaryRecord(const char* inData, size_t inOffset, sKinectFrame& outFrame)
+{
+	size_t offset = inOffset;
+
+	FCaptureBinaryRecordHeader recordHeader;
+	memcpy(&recordHeader, inData + offset, sizeof(recordHeader));
+	offset += sizeof(recordHeader);
+
+	outFrame.MilliSecond = recordHeader.MilliSecond;
+	outFrame.PosCount = recordHeader.PosCount;
+	outFrame.RotCount = recordHeader.RotCount;
+
+	for (int i = 0; i < outFrame.PosCount; ++i)
+	{
+		FCaptureBinaryPosition value;
+		memcpy(&value, inData + offset, sizeof(value));
+		offset += sizeof(value);
+
+		outFrame.Pos[i].JointType = (int)value.JointType;
+		outFrame.Pos[i].Position.x = value.Position[0];
+		outFrame.Pos[i].Position.y = value.Position[1];
+		outFrame.Pos[i].Position.z = value.Position[2];
+		outFrame.Pos[i].Position.w = 0.0f;
+	}
+
+	for (int i = 0; i < outFrame.RotCount; ++i)
+	{
+		FCaptureBinaryRotation value;
+		memcpy(&value, inData + offset, sizeof(value));
+		offset += sizeof(value);
+
+		outFrame.Rot[i].JointType = (int)value.JointType;
+		outFrame.Rot[i].Quaternion.x = value.Quaternion[0];
+		outFrame.Rot[i].Quaternion.y = value.Quaternion[1];
+		outFrame.Rot[i].Quaternion.z = value.Quaternion[2];
+		outFrame.Rot[i].Quaternion.w = value.Quaternion[3];
+	}
+}
+
+static inline bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+//  е token  ϳ д´. (std::ifstream >>   Ģ)
+struct FCaptureTokenizer
+{
+	const char* Cursor;
+	const char* End;
+
+	FCaptureTokenizer(const char* inBegin, const char* inEnd) : Cursor(inBegin), End(inEnd) {}
+
+	bool NextToken(const char*& outBegin, size_t& outLength)
+	{
+		while (Cursor < End && IsSpace(*Cursor))
+			++Cursor;
+
+		if (Cursor >= End)
+			return false;
+
+		outBegin = Cursor;
+		while (Cursor < End && !IsSpace(*Cursor))
+			++Cursor;
+
+		outLength = Cursor - outBegin;
+		return true;
+	}
+
+	bool NextKeyword(const char* inKeyword)
+	{
+		const char* token;
+		size_t length;
+		if (!NextToken(token, length))
+			return false;
+
+		return length == strlen(inKeyword) && memcmp(token, inKeyword, length) == 0;
+	}
+
+	bool NextUInt(DWORD& outValue)
+	{
+		const char* token;
+		size_t length;
+		if (!NextToken(token, length) || length > 10)
+			return false;
+
+		DWORD value = 0;
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (!IsDigit(token[i]))
+				return false;
+			value = value * 10 + (token[i] - '0');
+		}
+
+		outValue = value;
+		return true;
+	}
+
+	bool NextFloat(float& outValue)
+	{
+		const char* token;
+		size_t length;
+		if (!NextToken(token, length) || length >= 32)
+			return false;
+
+		// mapping  ޸𸮴 null   Ƿ   ȯ (std::stof   )
+		char buffer[32];
+		memcpy(buffer, token, length);
+		buffer[length] = '\0';
+
+		char* parsedEnd = nullptr;
+		outValue = strtof(buffer, &parsedEnd);
+		return parsedEnd == buffer + length;
+	}
+};
+
+// record ϳ parsing.    false
+static bool ParseRecord(FCaptureTokenizer& inTokenizer, sKinectFrame& outFrame)
+{
+	if (!inTokenizer.NextUInt(outFrame.MilliSecond))
+		return false;
+
+	DWORD posCount = 0;
+	if (!inTokenizer.NextKeyword("Pos") || !inTokenizer.NextUInt(posCount) || posCount > JointType_Count)
+		return false;
+
+	outFrame.PosCount = (int)posCount;
+
+	for (int i = 0; i < outFrame.PosCount; ++i)
+	{
+		DWORD jointType = 0;
+		auto& value = outFrame.Pos[i];
+		if (!inTokenizer.NextUInt(jointType) || jointType >= JointType_Count ||
+			!inTokenizer.NextFloat(value.Position.x) ||
+			!inTokenizer.NextFloat(value.Position.y) ||
+			!inTokenizer.NextFloat(value.Position.z))
+		{
+			return false;
+		}
+
+		value.JointType = (int)jointType;
+		value.Position.w = 0.0f;
+	}
+
+	DWORD rotCount = 0;
+	if (!inTokenizer.NextKeyword("Rot") || !inTokenizer.NextUInt(rotCount) || rotCount > JointType_Count)
+		return false;
+
+	outFrame.RotCount = (int)rotCount;
+
+	for (int i = 0; i < outFrame.RotCount; ++i)
+	{
+		DWORD jointType = 0;
+		auto& value = outFrame.Rot[i];
+		if (!inTokenizer.NextUInt(jointType) || jointType >= JointType_Count ||
+			!inTokenizer.NextFloat(value.Quaternion.x) ||
+			!inTokenizer.NextFloat(value.Quaternion.y) ||
+			!inTokenizer.NextFloat(value.Quaternion.z) ||
+			!inTokenizer.NextFloat(value.Quaternion.w))
+		{
+			return false;
+		}
+
+		value.JointType = (int)jointType;
+	}
+
+	return true;
+}
+
+CKinectCaptureReader::CKinectCaptureReader() : ThreadCount(0), CaptureBeginTime(0)
+{
+}
+
+void CKinectCaptureReader::SetThreadCount(int inCount)
+{
+	ThreadCount = inCount > 0 ? inCount : 0;
+}
+
+size_t CKinectCaptureReader::FindRecordStart(const char * inData, size_t inOffset, size_t inSize)
+{
+	// record   : ڸ ִ line (timestamp)  line  "Pos"  
+	size_t pos = inOffset;
+
+	while (pos < inSize)
+	{
+		// line  ó ̵
+		if (pos > 0 && inData[pos - 1] != '\n')
+		{
+			const char* newLine = (const char*)memchr(inData + pos, '\n', inSize - pos);
+			if (newLine == nullptr)
+				return inSize;
+
+			pos = newLine - inData + 1;
+			continue;
+		}
+
+		size_t cursor = pos;
+		bool bHasDigit = false;
+		while (cursor < inSize && IsDigit(inData[cursor]))
+		{
+			bHasDigit = true;
+			++cursor;
+		}
+		while (cursor < inSize && inData[cursor] != '\n' && IsSpace(inData[cursor]))
+			++cursor;
+
+		if (bHasDigit && cursor < inSize && inData[cursor] == '\n')
+		{
+			++cursor;
+			if (inSize - cursor >= 3 && memcmp(inData + cursor, "Pos", 3) == 0)
+				return pos;
+		}
+
+		//  line Ȯ
+		++pos;
+	}
+
+	return inSize;
+}
+
+size_t CKinectCaptureReader::CountRecords(const char * inData, size_t inBegin, size_t inEnd)
+{
+	// "Pos"  ϴ line  = record  (joint line  ڷ Ѵ)
+	size_t count = 0;
+	size_t pos = inBegin;
+
+	while (pos < inEnd)
+	{
+		if (inEnd - pos >= 3 && memcmp(inData + pos, "Pos", 3) == 0)
+			++count;
+
+		const char* newLine = (const char*)memchr(inData + pos, '\n', inEnd - pos);
+		if (newLine == nullptr)
+			break;
+
+		pos = newLine - inData + 1;
+	}
+
+	return count;
+}
+
+size_t CKinectCaptureReader::ParseChunk(const char * inData, size_t inBegin, size_t inEnd, sKinectFrame * outFrames, size_t inMaxCount)
+{
+	FCaptureTokenizer tokenizer(inData + inBegin, inData + inEnd);
+
+	size_t count = 0;
+	while (count < inMaxCount && ParseRecord(tokenizer, outFrames[count]))
+	{
+		++count;
+	}
+
+	return count;
+}
+
+bool CKinectCaptureReader::ReadTextFile(const std::string & inFileName)
+{
+	Frames.clear();
+
+	if (CBlockCompressedWriter::IsCompressedFileName(inFileName))
+	{
+		CBlockCompressedReader file;
+		std::string data;
+		if (!file.Open(inFileName) || !file.ReadAll(data, ThreadCount))
+			return false;
+
+		return ParseTextData(data.data(), data.size());
+	}
+
+	CMappedFile file;
+	if (!file.Open(inFileName))
+		return false;
+
+	return ParseTextData(file.GetData(), file.GetSize());
+}
+
+bool CKinectCaptureReader::ParseTextData(const char * inData, size_t inSize)
+{
+	if (inSize == 0)
+		return true;
+
+	CaptureBeginTime = 0;
+	{
+		FCaptureTokenizer tokenizer(inData + FindRecordStart(inData, 0, inSize), inData + inSize);
+		tokenizer.NextUInt(CaptureBeginTime);
+	}
+
+	int threadCount = ThreadCount;
+	if (threadCount <= 0)
+		threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+
+	// chunk  ʹ  thread     ũ.
+	const size_t minChunkSize = 1 << 20;
+	threadCount = (int)std::max<size_t>(1, std::min<size_t>(threadCount, inSize / minChunkSize + 1));
+
+	// 1. record 迡 chunk 
+	std::vector<FCaptureChunk> chunks;
+	size_t begin = FindRecordStart(inData, 0, inSize);
+	for (int i = 1; i <= threadCount && begin < inSize; ++i)
+	{
+		size_t end = (i == threadCount) ? inSize : FindRecordStart(inData, std::max(begin + 1, inSize * i / threadCount), inSize);
+
+		FCaptureChunk chunk = { begin, end, 0, 0, 0 };
+		chunks.push_back(chunk);
+
+		begin = end;
+	}
+
+	auto runParallel = [&chunks](const std::function<void(FCaptureChunk&)>& inTask)
+	{
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < chunks.size(); ++i)
+		{
+			threads.emplace_back(inTask, std::ref(chunks[i]));
+		}
+
+		if (!chunks.empty())
+			inTask(chunks[0]);
+
+		for (auto& thread : threads)
+			thread.join();
+	};
+
+	// 2. chunk  record    ġ ̸ 
+	runParallel([inData](FCaptureChunk& chunk)
+	{
+		chunk.FrameCount = CountRecords(inData, chunk.Begin, chunk.End);
+	});
+
+	size_t totalCount = 0;
+	for (auto& chunk : chunks)
+	{
+		chunk.FrameOffset = totalCount;
+		totalCount += chunk.FrameCount;
+	}
+
+	Frames.resize(totalCount);
+
+	// 3.  chunk  ڱ ġ parsing
+	sKinectFrame* frames = Frames.data();
+	runParallel([inData, frames](FCaptureChunk& chunk)
+	{
+		chunk.ParsedCount = ParseChunk(inData, chunk.Begin, chunk.End, frames + chunk.FrameOffset, chunk.FrameCount);
+	});
+
+	// 4. ̾ ̱ : ߸ record    loader ó ű⼭ ߴ
+	size_t validCount = 0;
+	for (auto const& chunk : chunks)
+	{
+		validCount += chunk.ParsedCount;
+		if (chunk.ParsedCount != chunk.FrameCount)
+			break;
+	}
+
+	Frames.resize(validCount);
+
+	// chunk    ̾ Ƿ  ̹ ĵǾ ִ.
+	auto byTime = [](const sKinectFrame& a, const sKinectFrame& b) { return a.MilliSecond < b.MilliSecond; };
+	if (!std::is_sorted(Frames.begin(), Frames.end(), byTime))
+	{
+		std::stable_sort(Frames.begin(), Frames.end(), byTime);
+	}
+
+	return true;
+}
+
+bool CKinectCaptureReader::ReadTextFileRange(const std::string & inFileName, DWORD inBeginTime, DWORD inEndTime)
+{
+	Frames.clear();
+
+	CKinectCaptureStream stream;
+	if (!stream.Open(inFileName) || stream.IsBinary())
+		return false;
+
+	CKinectCaptureIndex index;
+	if (stream.GetSize() == 0 || !index.LoadOrBuild(inFileName, stream))
+		return stream.GetSize() == 0;
+
+	CaptureBeginTime = index.GetBeginTime();
+
+	const DWORD beginTime = CaptureBeginTime + inBeginTime;
+	const DWORD endTime = CaptureBeginTime + inEndTime;
+
+	stream.Seek(index.FindOffset(beginTime));
+
+	sKinectFrame frame;
+	while (stream.Read(&frame, 1) == 1)
+	{
+		if (frame.MilliSecond <= beginTime)
+		{
+			// beginTime  record ϳ .
+			Frames.clear();
+		}
+
+		Frames.push_back(frame);
+
+		if (frame.MilliSecond >= endTime)
+			break;
+	}
+
+	return true;
+}
+
+bool CKinectCaptureReader::ReadBinaryFile(const std::string & inFileName)
+{
+	Frames.clear();
+
+	if (CBlockCompressedWriter::IsCompressedFileName(inFileName))
+	{
+		CBlockCompressedReader file;
+		std::string data;
+		if (!file.Open(inFileName) || !file.ReadAll(data, ThreadCount))
+			return false;
+
+		return ParseBinaryData(data.data(), data.size());
+	}
+
+	CMappedFile file;
+	if (!file.Open(inFileName))
+		return false;
+
+	return ParseBinaryData(file.GetData(), file.GetSize());
+}
+
+bool CKinectCaptureReader::ParseBinaryData(const char * inData, size_t inSize)
+{
+	FCaptureBinaryHeader header;
+	if (inSize < sizeof(header))
+		return false;
+
+	memcpy(&header, inData, sizeof(header));
+	if (header.Magic != CAPTURE_BINARY_MAGIC || header.Version != CAPTURE_BINARY_VERSION)
+		return false;
+
+	// 1. record     Ҵ : ߸ record   ű⼭ ߴ
+	size_t frameCount = 0;
+	for (size_t offset = sizeof(header), recordSize = 0; (recordSize = GetBinaryRecordSize(inData, offset, inSize)) != 0; offset += recordSize)
+	{
+		++frameCount;
+	}
+
+	Frames.resize(frameCount);
+
+	// 2. 
+	size_t offset = sizeof(header);
+	for (auto& frame : Frames)
+	{
+		const size_t recordSize = GetBinaryRecordSize(inData, offset, inSize);
+
+		ReadBinaryRecord(inData, offset, frame);
+		offset += recordSize;
+	}
+
+	CaptureBeginTime = Frames.empty() ? 0 : Frames.front().MilliSecond;
+
+	auto byTime = [](const sKinectFrame& a, const sKinectFrame& b) { return a.MilliSecond < b.MilliSecond; };
+	if (!std::is_sorted(Frames.begin(), Frames.end(), byTime))
+	{
+		std::stable_sort(Frames.begin(), Frames.end(), byTime);
+	}
+
+	return true;
+}
+
+void CKinectCaptureReader::AppendTextRecord(const sKinectFrame & inFrame, std::string & outData)
+{
+	char buffer[128];
+
+	snprintf(buffer, sizeof(buffer), "%u\nPos %d\n", (unsigned int)inFrame.MilliSecond, inFrame.PosCount);
+	outData += buffer;
+
+	for (int i = 0; i < inFrame.PosCount; ++i)
+	{
+		const auto& value = inFrame.Pos[i];
+		snprintf(buffer, sizeof(buffer), "%d %f %f %f\n", value.JointType, value.Position.x, value.Position.y, value.Position.z);
+		outData += buffer;
+	}
+
+	snprintf(buffer, sizeof(buffer), "Rot %d\n", inFrame.RotCount);
+	outData += buffer;
+
+	for (int i = 0; i < inFrame.RotCount; ++i)
+	{
+		const auto& value = inFrame.Rot[i];
+		snprintf(buffer, sizeof(buffer), "%d %f %f %f %f\n", value.JointType, value.Quaternion.x, value.Quaternion.y, value.Quaternion.z, value.Quaternion.w);
+		outData += buffer;
+	}
+}
+
+void CKinectCaptureReader::AppendBinaryHeader(std::string & outData)
+{
+	FCaptureBinaryHeader header = { CAPTURE_BINARY_MAGIC, CAPTURE_BINARY_VERSION, { 0, 0 } };
+	outData.append((const char*)&header, sizeof(header));
+}
+
+void CKinectCaptureReader::AppendBinaryRecord(const sKinectFrame & inFrame, std::string & outData)
+{
+	FCaptureBinaryRecordHeader header = { inFrame.MilliSecond, (WORD)inFrame.PosCount, (WORD)inFrame.RotCount };
+	outData.append((const char*)&header, sizeof(header));
+
+	for (int i = 0; i < inFrame.PosCount; ++i)
+	{
+		const auto& value = inFrame.Pos[i];
+		FCaptureBinaryPosition position = { (DWORD)value.JointType, { value.Position.x, value.Position.y, value.Position.z } };
+		outData.append((const char*)&position, sizeof(position));
+	}
+
+	for (int i = 0; i < inFrame.RotCount; ++i)
+	{
+		const auto& value = inFrame.Rot[i];
+		FCaptureBinaryRotation rotation = { (DWORD)value.JointType, { value.Quaternion.x, value.Quaternion.y, value.Quaternion.z, value.Quaternion.w } };
+		outData.append((const char*)&rotation, sizeof(rotation));
+	}
+}
+
+bool CKinectCaptureReader::ExportClip(CBVH & inBVH, const std::string & inCaptureFileName, DWORD inBeginTime, DWORD inEndTime, const std::string & inBVHFileName)
+{
+	if (inEndTime < inBeginTime || !ReadTextFileRange(inCaptureFileName, inBeginTime, inEndTime))
+		return false;
+
+	inBVH.ClearFrames();
+
+	Replay(inBVH);
+
+	inBVH.SetExportTimeRange(CaptureBeginTime + inBeginTime, CaptureBeginTime + inEndTime);
+	const bool bResult = inBVH.ExportFile(inBVHFileName);
+	inBVH.ResetExportTimeRange();
+
+	return bResult;
+}
+
+void CKinectCaptureReader::ReplayFrame(const sKinectFrame & inFrame, CBVH & outBVH)
+{
+	outBVH.Begin(inFrame.MilliSecond);
+
+	for (int i = 0; i < inFrame.PosCount; ++i)
+	{
+		const auto& value = inFrame.Pos[i];
+		outBVH.AddJointPositionValue((JointType)value.JointType, Vector4ToXMVECTOR(value.Position));
+	}
+
+	for (int i = 0; i < inFrame.RotCount; ++i)
+	{
+		const auto& value = inFrame.Rot[i];
+		outBVH.AddJointRotationValue((JointType)value.JointType, Vector4ToXMVECTOR(value.Quaternion));
+	}
+
+	outBVH.End();
+}
+
+void CKinectCaptureReader::Replay(CBVH & outBVH) const
+{
+	outBVH.ReserveFrames(Frames.size());
+
+	for (auto const& frame : Frames)
+	{
+		ReplayFrame(frame, outBVH);
+	}
+}
+
+CKinectCaptureStream::CKinectCaptureStream() : Offset(0), bBinary(false), bCompressed(false), BlockBegin(0), NextBlockIndex(0)
+{
+}
+
+bool CKinectCaptureStream::Open(const std::string & inFileName)
+{
+	Close();
+
+	const char* data = nullptr;
+	size_t size = 0;
+
+	if (CBlockCompressedWriter::IsCompressedFileName(inFileName))
+	{
+		if (!CompressedFile.Open(inFileName))
+			return false;
+
+		// header  Ȯ  ֵ ù block  ̸ Ǭ.
+		bCompressed = true;
+		Seek(0);
+
+		data = Block.data();
+		size = Block.size();
+	}
+	else
+	{
+		if (!File.Open(inFileName))
+			return false;
+
+		data = File.GetData();
+		size = File.GetSize();
+	}
+
+	FCaptureBinaryHeader header;
+	if (size >= sizeof(header))
+	{
+		memcpy(&header, data, sizeof(header));
+		if (header.Magic == CAPTURE_BINARY_MAGIC)
+		{
+			if (header.Version != CAPTURE_BINARY_VERSION)
+			{
+				Close();
+				return false;
+			}
+
+			bBinary = true;
+			Offset = sizeof(header);
+		}
+	}
+
+	return true;
+}
+
+void CKinectCaptureStream::Close()
+{
+	File.Close();
+	CompressedFile.Close();
+
+	Offset = 0;
+	bBinary = false;
+
+	bCompressed = false;
+	Block.clear();
+	BlockBegin = 0;
+	NextBlockIndex = 0;
+}
+
+void CKinectCaptureStream::Seek(ULONGLONG inOffset)
+{
+	Offset = std::min(inOffset, GetSize());
+
+	if (!bCompressed)
+		return;
+
+	// Offset   ִ block  ٽ Ǭ.
+	NextBlockIndex = CompressedFile.FindBlock(Offset);
+	BlockBegin = NextBlockIndex < CompressedFile.GetBlockCount() ? CompressedFile.GetBlockUncompressedOffset(NextBlockIndex) : Offset;
+	Block.clear();
+
+	const ULONGLONG offset = Offset;
+	Offset = BlockBegin;
+
+	if (ReadNextBlock())
+	{
+		Offset = offset;
+	}
+	else
+	{
+		Offset = BlockBegin = GetSize();
+		Block.clear();
+	}
+}
+
+bool CKinectCaptureStream::ReadNextBlock()
+{
+	if (NextBlockIndex >= CompressedFile.GetBlockCount() || !CompressedFile.ReadBlock(NextBlockIndex, BlockBuffer))
+		return false;
+
+	// ̹  պκ   block  ڿ δ.
+	Block.erase(0, (size_t)(Offset - BlockBegin));
+	BlockBegin = Offset;
+
+	Block += BlockBuffer;
+	++NextBlockIndex;
+
+	return true;
+}
+
+size_t CKinectCaptureStream::Read(sKinectFrame * outFrames, size_t inMaxCount)
+{
+	if (bCompressed)
+		return ReadCompressed(outFrames, inMaxCount);
+
+	if (!File.IsOpen())
+		return 0;
+
+	const char* data = File.GetData();
+	const size_t size = File.GetSize();
+
+	size_t count = 0;
+
+	if (bBinary)
+	{
+		size_t recordSize = 0;
+		while (count < inMaxCount && (recordSize = GetBinaryRecordSize(data, (size_t)Offset, size)) != 0)
+		{
+			ReadBinaryRecord(data, (size_t)Offset, outFrames[count]);
+			Offset += recordSize;
+			++count;
+		}
+
+		return count;
+	}
+
+	FCaptureTokenizer tokenizer(data + Offset, data + size);
+
+	while (count < inMaxCount)
+	{
+		if (!ParseRecord(tokenizer, outFrames[count]))
+		{
+			// ̰ų   ʴ record
+			Offset = size;
+			return count;
+		}
+
+		Offset = tokenizer.Cursor - data;
+		++count;
+	}
+
+	return count;
+}
+
+size_t CKinectCaptureStream::ReadCompressed(sKinectFrame * outFrames, size_t inMaxCount)
+{
+	size_t count = 0;
+
+	while (count < inMaxCount)
+	{
+		const char* data = Block.data();
+		const size_t size = Block.size();
+		const size_t offset = (size_t)(Offset - BlockBegin);
+
+		// Ǯ   ȿ record   ã´. (0 :  block  ̾)
+		size_t recordEnd = 0;
+		if (bBinary)
+		{
+			const size_t recordSize = GetBinaryRecordSize(data, offset, size);
+			if (recordSize != 0)
+			{
+				recordEnd = offset + recordSize;
+			}
+		}
+		else
+		{
+			//  record   .  block ̸  
+			size_t recordBegin = offset;
+			while (recordBegin < size && IsSpace(data[recordBegin]))
+				++recordBegin;
+
+			recordEnd = CKinectCaptureReader::FindRecordStart(data, recordBegin + 1, size);
+			if (recordEnd == size && NextBlockIndex < CompressedFile.GetBlockCount())
+			{
+				recordEnd = 0;
+			}
+		}
+
+		if (recordEnd == 0)
+		{
+			// record ϳ ξ  Ҵµ  ʰų,  Ǯ block   (Ǵ block  ) 
+			if (size - offset < CAPTURE_STREAM_MAX_RECORD_SIZE && ReadNextBlock())
+				continue;
+
+			Seek(GetSize());
+			return count;
+		}
+
+		if (bBinary)
+		{
+			ReadBinaryRecord(data, offset, outFrames[count]);
+		}
+		else
+		{
+			FCaptureTokenizer tokenizer(data + offset, data + recordEnd);
+			if (!ParseRecord(tokenizer, outFrames[count]))
+			{
+				Seek(GetSize());
+				return count;
+			}
+		}
+
+		Offset = BlockBegin + recordEnd;
+		++count;
+	}
+
+	return count;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <Kinect.h>
+
+#include "mappedfile.h"
+#include "blockcompress.h"
+
+class CBVH;
+class CKinectCaptureIndex;
+
+struct sKinectPosition
+{
+	int JointType;
+	Vector4 Position;
+};
+
+struct sKinectRotation
+{
+	int JointType;
+	Vector4 Quaternion;
+};
+
+// capture file record ϳ : <ms> Pos N ... Rot N ...
+struct sKinectFrame
+{
+	DWORD MilliSecond;
+
+	int PosCount;
+	int RotCount;
+
+	sKinectPosition Pos[JointType_Count];
+	sKinectRotation Rot[JointType_Count];
+};
+
+// Text capture file reader (binary capture  д´)
+// binary capture : header ("KCAP", version) + record ݺ (little endian, packed)
+//   record : DWORD MilliSecond, WORD PosCount, WORD RotCount,
+//            PosCount * (DWORD JointType, float x y z), RotCount * (DWORD JointType, float x y z w)
+// record  timestamp line  ϹǷ,  record 迡 chunk 
+//  thread ̸ Ҵ Frames   parsing Ѵ.
+class CKinectCaptureReader
+{
+	int ThreadCount;
+
+	std::vector<sKinectFrame> Frames;		// timestamp 
+
+	DWORD CaptureBeginTime;					// capture ù record  timestamp
+
+	struct FCaptureChunk
+	{
+		size_t Begin;					// byte offset
+		size_t End;
+		size_t FrameOffset;				// Frames   index
+		size_t FrameCount;				// chunk  record  (Pos line )
+		size_t ParsedCount;				//  parsing  record 
+	};
+
+	static size_t CountRecords(const char* inData, size_t inBegin, size_t inEnd);
+	static size_t ParseChunk(const char* inData, size_t inBegin, size_t inEnd, sKinectFrame* outFrames, size_t inMaxCount);
+
+	bool ParseTextData(const char* inData, size_t inSize);
+	bool ParseBinaryData(const char* inData, size_t inSize);
+
+public:
+	CKinectCaptureReader();
+
+	// 0 ̸ hardware thread  
+	void SetThreadCount(int inCount);
+
+	// ".gz" (CBlockCompressedWriter)  block  ThreadCount  thread   Ǭ  parsing Ѵ.
+	bool ReadTextFile(const std::string& inFileName);
+
+	// capture   [inBeginTime, inEndTime] ms  д´.
+	// sidecar (<capture>.idx) inBeginTime  record  ̵ϰ,     ٱ record ϳ Ѵ.
+	// ".gz"   Ű block  ʿ ŭ Ǭ.
+	bool ReadTextFileRange(const std::string& inFileName, DWORD inBeginTime, DWORD inEndTime);
+
+	bool ReadBinaryFile(const std::string& inFileName);
+
+	// Ͽ  record  outData ڿ δ. (text  capture   )
+	static void AppendTextRecord(const sKinectFrame& inFrame, std::string& outData);
+	static void AppendBinaryHeader(std::string& outData);
+	static void AppendBinaryRecord(const sKinectFrame& inFrame, std::string& outData);
+
+	// [inBeginTime, inEndTime]  а resampling ؼ BVH  . inBVH  ref pose  import  ¿ Ѵ.
+	bool ExportClip(CBVH& inBVH, const std::string& inCaptureFileName, DWORD inBeginTime, DWORD inEndTime, const std::string& inBVHFileName);
+
+	const std::vector<sKinectFrame>& GetFrames() const { return Frames; }
+	DWORD GetCaptureBeginTime() const { return CaptureBeginTime; }
+
+	// inOffset  ó  record   offset ( inSize)
+	static size_t FindRecordStart(const char* inData, size_t inOffset, size_t inSize);
+
+	//  frame  live callback   (Begin/Position/Rotation/End) CBVH  
+	void Replay(CBVH& outBVH) const;
+
+	static void ReplayFrame(const sKinectFrame& inFrame, CBVH& outBVH);
+};
+
+// capture  (text/binary ڵ Ǻ)  տ record  д´.
+// Frames    ø Ƿ  ũ ϰ ȣ  buffer ŭ ޸𸮸 .
+// Ͽ ϵ  ״ ش. (ReadTextFile  ޸  )
+// ".gz" (CBlockCompressedWriter)  block  ϳ Ǯ Ƿ block ϳ   .
+//   offset    Ǭ  
+class CKinectCaptureStream
+{
+	CMappedFile File;
+	ULONGLONG Offset;						//  record  byte offset
+	bool bBinary;
+
+	CBlockCompressedReader CompressedFile;
+	bool bCompressed;
+	std::string Block;						// Ǯ       κ (record  block 迡 ġ  block  ڿ δ)
+	ULONGLONG BlockBegin;					// Block[0]  offset
+	size_t NextBlockIndex;					//  Ǯ block
+	std::string BlockBuffer;
+
+	bool ReadNextBlock();
+	size_t ReadCompressed(sKinectFrame* outFrames, size_t inMaxCount);
+
+public:
+	CKinectCaptureStream();
+
+	bool Open(const std::string& inFileName);
+	void Close();
+
+	// ִ inMaxCount  outFrames  ä. 0 ̸  (  ʴ record   ű⼭ )
+	size_t Read(sKinectFrame* outFrames, size_t inMaxCount);
+
+	//  Read  inOffset (GetOffset ̳ CKinectCaptureIndex   record )  Ѵ.
+	void Seek(ULONGLONG inOffset);
+
+	ULONGLONG GetOffset() const { return Offset; }
+	ULONGLONG GetSize() const { return bCompressed ? CompressedFile.GetUncompressedSize() : File.GetSize(); }
+	ULONGLONG GetLastWriteTime() const { return bCompressed ? CompressedFile.GetLastWriteTime() : File.GetLastWriteTime(); }
+	bool IsBinary() const { return bBinary; }
+
+	//   ̸ mapping  ü ,  ̸ nullptr
+	const char* GetMappedData() const { return bCompressed ? nullptr : File.GetData(); }
+};
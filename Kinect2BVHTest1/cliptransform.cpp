@@ -0,0 +1,166 @@
+#include "stdafx.h"
+
+#include <utility>
+
+#include "cliptransform.h"
+
+static_assert(sizeof(FBVHJointTransform) % sizeof(XMVECTOR) == 0, "FBVHJointTransform stride");
+
+CClipTransform::CClipTransform() : JointCount(0), bMirror(false), bReorient(false), bScale(false)
+{
+	QuatSign = XMVectorSplatOne();
+	PositionScale = XMVectorSplatOne();
+	RootQuat = XMQuaternionIdentity();
+	RootDevQuat = XMQuaternionIdentity();
+}
+
+std::string CClipTransform::GetMirrorJointName(const std::string & inJointName)
+{
+	std::string name = inJointName;
+
+	size_t pos = name.find("Left");
+	if (pos != std::string::npos)
+		return name.replace(pos, 4, "Right");
+
+	pos = name.find("Right");
+	if (pos != std::string::npos)
+		return name.replace(pos, 5, "Left");
+
+	return name;
+}
+
+bool CClipTransform::Compile(const CBVH & inSkeleton, const FClipTransformOptions & inOptions)
+{
+	const auto& joints = inSkeleton.GetSortedJointArray();
+
+	JointCount = inSkeleton.GetJointCount();
+	if (JointCount <= 0 || inOptions.UnitScale <= 0.0f)
+		return false;
+
+	MirrorPairs.clear();
+	RefQuats.resize(JointCount);
+
+	for (int i = 0; i < JointCount; ++i)
+	{
+		RefQuats[i] = joints[i]->RefQuat;
+
+		// ¦  joint (SpineBase, Neck ...)  ڸ ݻ縸 Ѵ.
+		const int mirrorIndex = inSkeleton.FindSortedJointIndex(GetMirrorJointName(joints[i]->JointName));
+		if (mirrorIndex > i)
+		{
+			FMirrorPair pair = { i, mirrorIndex };
+			MirrorPairs.push_back(pair);
+		}
+	}
+
+	bMirror = inOptions.bMirror;
+
+	float quatSign[4] = { -1.0f, -1.0f, -1.0f, 1.0f };
+	float positionScale[4] = { inOptions.UnitScale, inOptions.UnitScale, inOptions.UnitScale, 1.0f };
+
+	if (bMirror)
+	{
+		quatSign[inOptions.MirrorAxis] = 1.0f;
+		positionScale[inOptions.MirrorAxis] = -inOptions.UnitScale;
+	}
+	else
+	{
+		quatSign[0] = quatSign[1] = quatSign[2] = 1.0f;
+	}
+
+	QuatSign = XMVectorSet(quatSign[0], quatSign[1], quatSign[2], quatSign[3]);
+	PositionScale = XMVectorSet(positionScale[0], positionScale[1], positionScale[2], positionScale[3]);
+
+	bScale = inOptions.UnitScale != 1.0f;
+
+	RootQuat = XMQuaternionNormalize(inOptions.RootRotation);
+	bReorient = !XMQuaternionIsIdentity(RootQuat);
+
+	// devRoot' = localRoot*R*inverse(ref) = devRoot*(ref*R*inverse(ref))
+	const FBVHJoint* rootJoint = joints[0];
+	RootDevQuat = XMQuaternionMultiply(XMQuaternionMultiply(rootJoint->RefQuat, RootQuat), rootJoint->InvRefQuat);
+
+	return true;
+}
+
+void CClipTransform::ApplyRotations(XMVECTOR * ioQuats, size_t inFrameCount, bool bDevQuat, size_t inJointStride) const
+{
+	if (!bMirror && !bReorient)
+		return;
+
+	const size_t frameStride = JointCount * inJointStride;
+	const XMVECTOR rootQuat = bDevQuat ? RootDevQuat : RootQuat;
+
+	for (size_t f = 0; f < inFrameCount; ++f)
+	{
+		XMVECTOR* quats = ioQuats + f * frameStride;
+
+		if (bMirror)
+		{
+			for (auto const& pair : MirrorPairs)
+			{
+				std::swap(quats[pair.Index0 * inJointStride], quats[pair.Index1 * inJointStride]);
+			}
+
+			for (int j = 0; j < JointCount; ++j)
+			{
+				XMVECTOR& quat = quats[j * inJointStride];
+				quat = XMVectorMultiply(quat, QuatSign);
+			}
+		}
+
+		if (bReorient)
+		{
+			quats[0] = XMQuaternionMultiply(quats[0], rootQuat);
+		}
+	}
+}
+
+void CClipTransform::ApplyPositions(XMVECTOR * ioPositions, size_t inFrameCount, int inPositionCount, size_t inJointStride) const
+{
+	if (IsIdentity())
+		return;
+
+	const size_t frameStride = inPositionCount * inJointStride;
+	const bool bSwapPairs = bMirror && inPositionCount == JointCount;
+
+	for (size_t f = 0; f < inFrameCount; ++f)
+	{
+		XMVECTOR* positions = ioPositions + f * frameStride;
+
+		if (bSwapPairs)
+		{
+			for (auto const& pair : MirrorPairs)
+			{
+				std::swap(positions[pair.Index0 * inJointStride], positions[pair.Index1 * inJointStride]);
+			}
+		}
+
+		for (int j = 0; j < inPositionCount; ++j)
+		{
+			XMVECTOR& position = positions[j * inJointStride];
+			position = XMVectorMultiply(position, PositionScale);
+
+			if (bReorient)
+			{
+				position = XMVector3Rotate(position, RootQuat);
+			}
+		}
+	}
+}
+
+void CClipTransform::Apply(FBVHJointTransform * ioFrameInfo) const
+{
+	if (!bMirror && !bReorient)
+		return;
+
+	const size_t stride = sizeof(FBVHJointTransform) / sizeof(XMVECTOR);
+
+	ApplyRotations(&ioFrameInfo[0].DevQuat, 1, true, stride);
+
+	for (int j = 0; j < JointCount; ++j)
+	{
+		// localQuat = devQuat*refPoseQuat
+		ioFrameInfo[j].LocalQuat = XMQuaternionMultiply(ioFrameInfo[j].DevQuat, RefQuats[j]);
+	}
+}
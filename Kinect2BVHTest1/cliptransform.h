@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <DirectXMath.h>
+
+#include "bvhexport.h"
+
+enum EClipMirrorAxis
+{
+	EClipMirrorAxis_X,			// ¿  (sample rig  HipLeft  +X)
+	EClipMirrorAxis_Y,
+	EClipMirrorAxis_Z,
+};
+
+struct FClipTransformOptions
+{
+	bool bMirror;					// *Left <-> *Right joint  ٲٰ MirrorAxis 鿡  ݻ
+	EClipMirrorAxis MirrorAxis;
+	XMVECTOR RootRotation;			// root  ߰  ȸ (world , identity ̸ )
+	float UnitScale;				// position  ( : Kinect m -> sample rig mm ̸ 1000)
+
+	FClipTransformOptions() : bMirror(false), MirrorAxis(EClipMirrorAxis_X), RootRotation(XMQuaternionIdentity()), UnitScale(1.0f)
+	{
+	}
+};
+
+// ¿ , root  ,  ȯ clip 迭 ü   Ѵ.
+// skeleton  ¿ joint  table     ΰ, frame  ̸ ˻ 
+//  ȯ + ȣ  (SIMD) + root quaternion  Ѵ.    -> root ȸ -> 
+//
+//  :   X ̸ quaternion (x, y, z, w) -> (x, -y, -z, w), position (x, y, z) -> (-x, y, z)
+// DevQuat  ϸ rest pose  ϰ, LocalQuat  Ϸ rest pose  ¿ Ī̾ Ѵ.
+// root ȸ : localRoot' = localRoot*R, devRoot' = devRoot*(ref*R*inverse(ref)), position' = rotate(position, R)
+class CClipTransform
+{
+	struct FMirrorPair
+	{
+		int Index0;					// SortedJointArray index (Index0 < Index1)
+		int Index1;
+	};
+
+	int JointCount;
+	std::vector<FMirrorPair> MirrorPairs;
+	std::vector<XMVECTOR> RefQuats;
+
+	bool bMirror;
+	bool bReorient;
+	bool bScale;
+
+	XMVECTOR QuatSign;				//   quaternion   ȣ
+	XMVECTOR PositionScale;			//  ȣ * UnitScale
+	XMVECTOR RootQuat;				// R
+	XMVECTOR RootDevQuat;			// ref*R*inverse(ref)
+
+public:
+	CClipTransform();
+
+	bool Compile(const CBVH& inSkeleton, const FClipTransformOptions& inOptions);
+
+	int GetJointCount() const { return JointCount; }
+	size_t GetMirrorPairCount() const { return MirrorPairs.size(); }
+	bool IsIdentity() const { return !bMirror && !bReorient && !bScale; }
+
+	// "HipLeft" <-> "HipRight". Left/Right   ״
+	static std::string GetMirrorJointName(const std::string& inJointName);
+
+	// ioQuats : inFrameCount * JointCount  (frame  SortedJointArray )
+	// inJointStride : joint   (XMVECTOR ). FBVHJointTransform 迭   ٷ   
+	void ApplyRotations(XMVECTOR* ioQuats, size_t inFrameCount, bool bDevQuat, size_t inJointStride = 1) const;
+
+	// ioPositions : inFrameCount * inPositionCount . inPositionCount  JointCount ̸ ¿ joint  ٲٰ, 1 ̸ root 
+	void ApplyPositions(XMVECTOR* ioPositions, size_t inFrameCount, int inPositionCount, size_t inJointStride = 1) const;
+
+	// resampling  frame ϳ : DevQuat  ϰ LocalQuat = DevQuat*RefQuat  ٽ .
+	void Apply(FBVHJointTransform* ioFrameInfo) const;
+};
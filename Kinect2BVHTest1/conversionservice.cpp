@@ -0,0 +1,629 @@
+#include "stdafx.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdarg.h>
+
+#include "conversionservice.h"
+
+// job ϳ CKinectCaptureStream    д record  ( ̸ Interactive job  Ȯ)
+static const size_t CONVERSION_BLOCK_FRAME_COUNT = 256;
+
+static const char* const CONVERSION_PRIORITY_NAMES[EConversionPriority_Count] = { "bulk", "normal", "interactive" };
+
+static DWORD GetElapsedMilliSeconds(std::chrono::steady_clock::time_point inBegin, std::chrono::steady_clock::time_point inEnd)
+{
+	return (DWORD)std::chrono::duration_cast<std::chrono::milliseconds>(inEnd - inBegin).count();
+}
+
+// ӽ Ͽ   ̸ ٲ۴. (д      ʰ)
+static bool WriteFileByRename(const std::string& inFileName, const std::string& inData, bool bReplace)
+{
+	const std::string tempFileName = inFileName + ".tmp";
+
+	std::ofstream file(tempFileName.c_str(), std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	file.write(inData.data(), inData.size());
+	file.close();
+
+	if (file.fail() || !MoveFileExA(tempFileName.c_str(), inFileName.c_str(), bReplace ? MOVEFILE_REPLACE_EXISTING : 0))
+	{
+		DeleteFileA(tempFileName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+static void ListFiles(const std::string& inPattern, std::vector<std::string>& outFileNames)
+{
+	WIN32_FIND_DATAA findData;
+	HANDLE findHandle = FindFirstFileA(inPattern.c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+		{
+			outFileNames.push_back(findData.cFileName);
+		}
+	} while (FindNextFileA(findHandle, &findData));
+
+	FindClose(findHandle);
+
+	//    job  ̸ 
+	std::sort(outFileNames.begin(), outFileNames.end());
+}
+
+// printf    δ. (buffer   ߸ ŭ)
+static void AppendLine(std::string& outData, const char* inFormat, ...)
+{
+	char buffer[256];
+
+	va_list args;
+	va_start(args, inFormat);
+	const int length = vsnprintf(buffer, sizeof(buffer), inFormat, args);
+	va_end(args);
+
+	if (length > 0)
+	{
+		outData.append(buffer, std::min((size_t)length, sizeof(buffer) - 1));
+	}
+}
+
+static std::string RemoveExtension(const std::string& inFileName)
+{
+	const size_t dot = inFileName.rfind('.');
+	return dot == std::string::npos ? inFileName : inFileName.substr(0, dot);
+}
+
+CConversionService::CConversionService(const FConversionServiceOptions & inOptions)
+	: Options(inOptions), Stats(), NextJobId(1), bStopping(false), ReservedWorkerCount(0)
+{
+	Options.SkeletonCacheCapacity = std::max(Options.SkeletonCacheCapacity, 1);
+	Options.PollInterval = std::max(Options.PollInterval, 1);
+	Options.ResultCapacity = std::max(Options.ResultCapacity, 0);
+}
+
+CConversionService::~CConversionService()
+{
+	Stop();
+}
+
+bool CConversionService::Start()
+{
+	if (!Workers.empty())
+		return false;
+
+	int workerCount = Options.WorkerCount;
+	if (workerCount <= 0)
+	{
+		workerCount = std::max((int)std::thread::hardware_concurrency(), 1);
+	}
+
+	// Interactive  ƴ worker  ϳ ־ Ѵ.
+	ReservedWorkerCount = std::min(std::max(Options.InteractiveWorkerCount, 0), workerCount - 1);
+	bStopping = false;
+
+	if (!Options.SpoolDirectory.empty())
+	{
+		ScanSpoolDirectory(true);
+
+		SpoolThread = std::thread(&CConversionService::SpoolMain, this);
+	}
+
+	for (int i = 0; i < workerCount; ++i)
+	{
+		Workers.emplace_back(&CConversionService::WorkerMain, this, i < ReservedWorkerCount);
+	}
+
+	return true;
+}
+
+void CConversionService::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		bStopping = true;
+	}
+
+	JobAvailable.notify_all();
+	InteractiveDone.notify_all();
+	StopRequested.notify_all();
+
+	for (auto& worker : Workers)
+	{
+		worker.join();
+	}
+	Workers.clear();
+
+	if (SpoolThread.joinable())
+	{
+		SpoolThread.join();
+	}
+
+	// spool job  .queued Ϸ  Ƿ  Start  ٽ д´.
+	std::lock_guard<std::mutex> lock(Mutex);
+	for (int priority = 0; priority < EConversionPriority_Count; ++priority)
+	{
+		auto& queue = Queues[priority];
+		queue.erase(std::remove_if(queue.begin(), queue.end(), [](const FQueuedJob& inJob) { return !inJob.SpoolFileName.empty(); }), queue.end());
+
+		Stats.Priorities[priority].QueuedCount = queue.size();
+	}
+}
+
+ULONGLONG CConversionService::Submit(const FConversionJob & inJob, const std::string & inName)
+{
+	return Enqueue(inJob, inName, "");
+}
+
+ULONGLONG CConversionService::Enqueue(const FConversionJob & inJob, const std::string & inName, const std::string & inSpoolFileName)
+{
+	FQueuedJob queuedJob;
+	queuedJob.Name = inName;
+	queuedJob.SpoolFileName = inSpoolFileName;
+	queuedJob.Job = inJob;
+	queuedJob.SubmitTime = TClock::now();
+
+	if (queuedJob.Job.Priority < 0 || queuedJob.Job.Priority >= EConversionPriority_Count)
+	{
+		queuedJob.Job.Priority = EConversionPriority_Normal;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+
+		queuedJob.JobId = NextJobId++;
+
+		Queues[queuedJob.Job.Priority].push_back(queuedJob);
+		++Stats.Priorities[queuedJob.Job.Priority].QueuedCount;
+	}
+
+	// Interactive  worker  ٸ job   Ƿ  .
+	JobAvailable.notify_all();
+
+	return queuedJob.JobId;
+}
+
+bool CConversionService::PopJob(bool bInteractiveOnly, FQueuedJob & outJob)
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	const int lowestPriority = bInteractiveOnly ? EConversionPriority_Interactive : 0;
+
+	auto findQueue = [this, lowestPriority]() -> int
+	{
+		for (int priority = EConversionPriority_Count - 1; priority >= lowestPriority; --priority)
+		{
+			if (!Queues[priority].empty())
+				return priority;
+		}
+		return -1;
+	};
+
+	JobAvailable.wait(lock, [&] { return bStopping || findQueue() >= 0; });
+
+	if (bStopping)
+		return false;
+
+	const int priority = findQueue();
+
+	outJob = Queues[priority].front();
+	Queues[priority].pop_front();
+
+	--Stats.Priorities[priority].QueuedCount;
+	++Stats.Priorities[priority].RunningCount;
+
+	return true;
+}
+
+void CConversionService::WorkerMain(bool bInteractiveOnly)
+{
+	FWorkerContext context;
+	context.Block.resize(CONVERSION_BLOCK_FRAME_COUNT);
+	context.UseCounter = 0;
+
+	FQueuedJob job;
+	while (PopJob(bInteractiveOnly, job))
+	{
+		const TClock::time_point beginTime = TClock::now();
+
+		FConversionJobResult result;
+		result.JobId = job.JobId;
+		result.Name = job.Name;
+		result.Priority = job.Job.Priority;
+		result.FrameCount = 0;
+		result.QueueMilliSeconds = GetElapsedMilliSeconds(job.SubmitTime, beginTime);
+		result.bSkeletonCacheHit = false;
+
+		result.bSuccess = Convert(context, job, result);
+		result.RunMilliSeconds = GetElapsedMilliSeconds(beginTime, TClock::now());
+
+		Complete(job, result);
+	}
+}
+
+CBVH * CConversionService::AcquireSkeleton(FWorkerContext & ioContext, const std::string & inRefPoseFileName, bool & outCacheHit)
+{
+	++ioContext.UseCounter;
+
+	for (auto& value : ioContext.Skeletons)
+	{
+		if (value.RefPoseFileName == inRefPoseFileName)
+		{
+			outCacheHit = true;
+			value.LastUsed = ioContext.UseCounter;
+			return value.BVH.get();
+		}
+	}
+
+	outCacheHit = false;
+
+	// ImportRefPoseByBVHFile      Ȯ ʴ´.
+	if (!std::ifstream(inRefPoseFileName.c_str()).is_open())
+		return nullptr;
+
+	std::unique_ptr<CBVH> bvh(new CBVH());
+	bvh->ImportRefPoseByBVHFile(inRefPoseFileName);
+
+	if (bvh->GetJointCount() <= 0)
+		return nullptr;
+
+	FCachedSkeleton* slot = nullptr;
+
+	if ((int)ioContext.Skeletons.size() < Options.SkeletonCacheCapacity)
+	{
+		ioContext.Skeletons.emplace_back();
+		slot = &ioContext.Skeletons.back();
+	}
+	else
+	{
+		//     skeleton  ٲ۴.
+		slot = &*std::min_element(ioContext.Skeletons.begin(), ioContext.Skeletons.end(),
+			[](const FCachedSkeleton& inA, const FCachedSkeleton& inB) { return inA.LastUsed < inB.LastUsed; });
+	}
+
+	slot->RefPoseFileName = inRefPoseFileName;
+	slot->BVH = std::move(bvh);
+	slot->LastUsed = ioContext.UseCounter;
+
+	return slot->BVH.get();
+}
+
+bool CConversionService::Convert(FWorkerContext & ioContext, const FQueuedJob & inJob, FConversionJobResult & ioResult)
+{
+	CBVH* bvh = AcquireSkeleton(ioContext, inJob.Job.RefPoseFileName, ioResult.bSkeletonCacheHit);
+	if (bvh == nullptr)
+		return false;
+
+	CKinectCaptureStream stream;
+	if (!stream.Open(inJob.Job.CaptureFileName))
+		return false;
+
+	bvh->ClearFrames();
+
+	DWORD lastTime = 0;
+	size_t count = 0;
+	size_t blockCount = 0;
+
+	while ((blockCount = stream.Read(ioContext.Block.data(), ioContext.Block.size())) > 0)
+	{
+		for (size_t i = 0; i < blockCount; ++i)
+		{
+			const sKinectFrame& frame = ioContext.Block[i];
+
+			//  ȿ ð ǵư record
+			if (count > 0 && frame.MilliSecond < lastTime)
+				continue;
+
+			CKinectCaptureReader::ReplayFrame(frame, *bvh);
+
+			lastTime = frame.MilliSecond;
+			++count;
+		}
+
+		WaitForInteractiveJobs(inJob.Job.Priority);
+	}
+
+	ioResult.FrameCount = count;
+
+	if (count < 2)
+	{
+		bvh->ClearFrames();
+		return false;
+	}
+
+	const bool bResult = bvh->ExportFile(inJob.Job.OutputFileName);
+	bvh->ClearFrames();
+
+	return bResult;
+}
+
+void CConversionService::WaitForInteractiveJobs(EConversionPriority inPriority)
+{
+	if (!Options.bPauseLowerPriorityJobs || inPriority >= EConversionPriority_Interactive)
+		return;
+
+	const auto& interactive = Stats.Priorities[EConversionPriority_Interactive];
+
+	//   Interactive job   worker    ٸ. ( worker   ʰ)
+	std::unique_lock<std::mutex> lock(Mutex);
+	InteractiveDone.wait(lock, [&]
+	{
+		return bStopping || (interactive.RunningCount == 0 && (interactive.QueuedCount == 0 || ReservedWorkerCount == 0));
+	});
+}
+
+void CConversionService::Complete(const FQueuedJob & inJob, const FConversionJobResult & inResult)
+{
+	if (!inJob.SpoolFileName.empty())
+	{
+		char buffer[256];
+		snprintf(buffer, sizeof(buffer), "status %s\nqueue_ms %u\nrun_ms %u\nframes %u\n",
+			inResult.bSuccess ? "ok" : "failed", (unsigned int)inResult.QueueMilliSeconds, (unsigned int)inResult.RunMilliSeconds, (unsigned int)inResult.FrameCount);
+
+		WriteFileByRename(GetSpoolPath(inJob.Name + ".result"), buffer, true);
+		DeleteFileA(inJob.SpoolFileName.c_str());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+
+		auto& stats = Stats.Priorities[inResult.Priority];
+		--stats.RunningCount;
+
+		if (inResult.bSuccess)
+		{
+			++stats.CompletedCount;
+		}
+		else
+		{
+			++stats.FailedCount;
+		}
+
+		stats.QueueMilliSecondsTotal += inResult.QueueMilliSeconds;
+		stats.QueueMilliSecondsMax = std::max(stats.QueueMilliSecondsMax, inResult.QueueMilliSeconds);
+		stats.RunMilliSecondsTotal += inResult.RunMilliSeconds;
+		stats.RunMilliSecondsMax = std::max(stats.RunMilliSecondsMax, inResult.RunMilliSeconds);
+
+		if (inResult.bSkeletonCacheHit)
+		{
+			++Stats.SkeletonCacheHitCount;
+		}
+		else
+		{
+			++Stats.SkeletonCacheMissCount;
+		}
+
+		if (Options.ResultCapacity > 0)
+		{
+			if (Results.size() >= (size_t)Options.ResultCapacity)
+			{
+				Results.pop_front();
+				++Stats.DroppedResultCount;
+			}
+
+			Results.push_back(inResult);
+		}
+	}
+
+	if (inResult.Priority == EConversionPriority_Interactive)
+	{
+		InteractiveDone.notify_all();
+	}
+	Idle.notify_all();
+
+	if (!Options.SpoolDirectory.empty())
+	{
+		std::string metrics;
+		AppendMetrics(metrics);
+
+		WriteFileByRename(GetSpoolPath("metrics.txt"), metrics, true);
+	}
+}
+
+void CConversionService::WaitForIdle()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	Idle.wait(lock, [this]
+	{
+		for (auto const& value : Stats.Priorities)
+		{
+			if (value.QueuedCount > 0 || value.RunningCount > 0)
+				return false;
+		}
+		return true;
+	});
+}
+
+FConversionServiceStats CConversionService::GetStats()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	return Stats;
+}
+
+void CConversionService::PopResults(std::vector<FConversionJobResult>& outResults)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+
+	outResults.insert(outResults.end(), Results.begin(), Results.end());
+	Results.clear();
+}
+
+void CConversionService::AppendMetrics(std::string & outData)
+{
+	const FConversionServiceStats stats = GetStats();
+
+	for (int priority = EConversionPriority_Count - 1; priority >= 0; --priority)
+	{
+		const auto& value = stats.Priorities[priority];
+		const char* name = CONVERSION_PRIORITY_NAMES[priority];
+
+		const ULONGLONG finishedCount = value.CompletedCount + value.FailedCount;
+		const double queueMean = finishedCount > 0 ? (double)value.QueueMilliSecondsTotal / (double)finishedCount : 0.0;
+		const double runMean = finishedCount > 0 ? (double)value.RunMilliSecondsTotal / (double)finishedCount : 0.0;
+
+		AppendLine(outData, "%s.queued %u\n", name, (unsigned int)value.QueuedCount);
+		AppendLine(outData, "%s.running %u\n", name, (unsigned int)value.RunningCount);
+		AppendLine(outData, "%s.completed %llu\n", name, value.CompletedCount);
+		AppendLine(outData, "%s.failed %llu\n", name, value.FailedCount);
+		AppendLine(outData, "%s.queue_ms_mean %.1f\n", name, queueMean);
+		AppendLine(outData, "%s.queue_ms_max %u\n", name, (unsigned int)value.QueueMilliSecondsMax);
+		AppendLine(outData, "%s.run_ms_mean %.1f\n", name, runMean);
+		AppendLine(outData, "%s.run_ms_max %u\n", name, (unsigned int)value.RunMilliSecondsMax);
+	}
+
+	AppendLine(outData, "skeleton_cache.hit %llu\n", stats.SkeletonCacheHitCount);
+	AppendLine(outData, "skeleton_cache.miss %llu\n", stats.SkeletonCacheMissCount);
+	AppendLine(outData, "results.dropped %llu\n", stats.DroppedResultCount);
+}
+
+std::string CConversionService::GetSpoolPath(const std::string & inFileName) const
+{
+	const std::string& directory = Options.SpoolDirectory;
+
+	if (directory.empty() || directory.back() == '\\' || directory.back() == '/')
+		return directory + inFileName;
+
+	return directory + "\\" + inFileName;
+}
+
+void CConversionService::SpoolMain()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	while (!StopRequested.wait_for(lock, std::chrono::milliseconds(Options.PollInterval), [this] { return bStopping; }))
+	{
+		lock.unlock();
+		ScanSpoolDirectory(false);
+		lock.lock();
+	}
+}
+
+void CConversionService::ScanSpoolDirectory(bool bRecover)
+{
+	std::vector<std::string> fileNames;
+
+	//    job
+	if (bRecover)
+	{
+		ListFiles(GetSpoolPath("*.queued"), fileNames);
+
+		for (auto const& fileName : fileNames)
+		{
+			const std::string queuedFileName = GetSpoolPath(fileName);
+
+			FConversionJob job;
+			if (ReadJobFile(queuedFileName, job))
+			{
+				Enqueue(job, RemoveExtension(fileName), queuedFileName);
+			}
+		}
+
+		fileNames.clear();
+	}
+
+	ListFiles(GetSpoolPath("*.job"), fileNames);
+
+	for (auto const& fileName : fileNames)
+	{
+		const std::string name = RemoveExtension(fileName);
+		const std::string queuedFileName = GetSpoolPath(name + ".queued");
+
+		// ̸ ٲ ϸ (̹  job ) ǳʶڴ.
+		if (!MoveFileExA(GetSpoolPath(fileName).c_str(), queuedFileName.c_str(), 0))
+			continue;
+
+		FConversionJob job;
+		if (!ReadJobFile(queuedFileName, job))
+		{
+			WriteFileByRename(GetSpoolPath(name + ".result"), "status invalid\n", true);
+			DeleteFileA(queuedFileName.c_str());
+			continue;
+		}
+
+		Enqueue(job, name, queuedFileName);
+	}
+}
+
+bool CConversionService::WriteJobFile(const std::string & inSpoolDirectory, const std::string & inName, const FConversionJob & inJob)
+{
+	std::string data;
+	data.append("capture "); data.append(inJob.CaptureFileName); data.append("\n");
+	data.append("refpose "); data.append(inJob.RefPoseFileName); data.append("\n");
+	data.append("output "); data.append(inJob.OutputFileName); data.append("\n");
+	data.append("priority "); data.append(GetPriorityName(inJob.Priority)); data.append("\n");
+
+	std::string fileName = inSpoolDirectory;
+	if (!fileName.empty() && fileName.back() != '\\' && fileName.back() != '/')
+	{
+		fileName.append("\\");
+	}
+	fileName.append(inName);
+	fileName.append(".job");
+
+	return WriteFileByRename(fileName, data, false);
+}
+
+bool CConversionService::ReadJobFile(const std::string & inFileName, FConversionJob & outJob)
+{
+	std::ifstream file(inFileName.c_str());
+	if (!file.is_open())
+		return false;
+
+	outJob = FConversionJob();
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		//     ִ. ( ̸)
+		const size_t space = line.find(' ');
+		if (space == std::string::npos)
+			continue;
+
+		const std::string key = line.substr(0, space);
+		const std::string value = line.substr(space + 1);
+
+		if (key == "capture")
+		{
+			outJob.CaptureFileName = value;
+		}
+		else if (key == "refpose")
+		{
+			outJob.RefPoseFileName = value;
+		}
+		else if (key == "output")
+		{
+			outJob.OutputFileName = value;
+		}
+		else if (key == "priority")
+		{
+			for (int priority = 0; priority < EConversionPriority_Count; ++priority)
+			{
+				if (_stricmp(value.c_str(), CONVERSION_PRIORITY_NAMES[priority]) == 0)
+				{
+					outJob.Priority = (EConversionPriority)priority;
+				}
+			}
+		}
+	}
+
+	return !outJob.CaptureFileName.empty() && !outJob.RefPoseFileName.empty() && !outJob.OutputFileName.empty();
+}
+
+const char * CConversionService::GetPriorityName(EConversionPriority inPriority)
+{
+	if (inPriority < 0 || inPriority >= EConversionPriority_Count)
+		return CONVERSION_PRIORITY_NAMES[EConversionPriority_Normal];
+
+	return CONVERSION_PRIORITY_NAMES[inPriority];
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "bvhexport.h"
+#include "capturereader.h"
+
+//  . Interactive  / ̸ ׺  job  capture block ̿ .
+enum EConversionPriority
+{
+	EConversionPriority_Bulk,			// archive ϰ ȯ
+	EConversionPriority_Normal,
+	EConversionPriority_Interactive,	// ڰ ٸ ª export
+	EConversionPriority_Count,
+};
+
+// capture ϳ -> BVH ϳ
+struct FConversionJob
+{
+	std::string CaptureFileName;		// text/binary capture
+	std::string RefPoseFileName;		// CBVH::ImportRefPoseByBVHFile
+	std::string OutputFileName;
+	EConversionPriority Priority;
+
+	FConversionJob() : Priority(EConversionPriority_Normal) {}
+};
+
+struct FConversionJobResult
+{
+	ULONGLONG JobId;
+	std::string Name;					// spool job ̸  ̸ (Ȯ )
+	EConversionPriority Priority;
+	bool bSuccess;
+	size_t FrameCount;					// CBVH   capture record 
+	DWORD QueueMilliSeconds;			// Submit ->  
+	DWORD RunMilliSeconds;				//   ->  ( priority   ð )
+	bool bSkeletonCacheHit;
+};
+
+// priority   
+struct FConversionPriorityStats
+{
+	size_t QueuedCount;
+	size_t RunningCount;
+	ULONGLONG CompletedCount;
+	ULONGLONG FailedCount;
+
+	ULONGLONG QueueMilliSecondsTotal;
+	DWORD QueueMilliSecondsMax;
+	ULONGLONG RunMilliSecondsTotal;
+	DWORD RunMilliSecondsMax;
+};
+
+struct FConversionServiceStats
+{
+	FConversionPriorityStats Priorities[EConversionPriority_Count];
+	ULONGLONG SkeletonCacheHitCount;
+	ULONGLONG SkeletonCacheMissCount;
+	ULONGLONG DroppedResultCount;		// PopResults    ResultCapacity  Ѿ  
+};
+
+struct FConversionServiceOptions
+{
+	std::string SpoolDirectory;			//   Submit θ job  ޴´.
+	int WorkerCount;					// 0 ̸ hardware thread 
+	int InteractiveWorkerCount;			//   Interactive job  ϴ worker 
+	int SkeletonCacheCapacity;			// worker  ref pose  import   CBVH 
+	int PollInterval;					// spool directory Ȯ  (ms)
+	int ResultCapacity;					// PopResults  ϴ   (  ͺ , 0 ̸  )
+	bool bPauseLowerPriorityJobs;		// Interactive job  ִ   job  .
+
+	FConversionServiceOptions() : WorkerCount(0), InteractiveWorkerCount(1), SkeletonCacheCapacity(4), PollInterval(200), ResultCapacity(1024), bPauseLowerPriorityJobs(true)
+	{
+	}
+};
+
+// ȯ û  ޾Ƽ óϴ process  service.
+// job  process    ref pose BVH parsing, joint table , arena Ҵ Ź ٽ ϹǷ,
+// worker thread  ref pose  CBVH    ִٰ ClearFrames  ϰ ٽ . (skeleton + arena  warm)
+//
+// job  Submit   ְų, SpoolDirectory  "<name>.job" Ϸ . (ٸ process  WriteJobFile)
+//   <name>.job    :  ٿ "key value" (capture, refpose, output, priority = bulk | normal | interactive)
+//   <name>.queued : service   job (Start    ߴܵ ̹Ƿ ٽ ִ´)
+//   <name>.result :  job  status, queue_ms, run_ms, frames
+//   metrics.txt   : job    priority   ,  ð (AppendMetrics   )
+//  priority ȿ   job  Ѵ.
+class CConversionService
+{
+	typedef std::chrono::steady_clock TClock;
+
+	struct FQueuedJob
+	{
+		ULONGLONG JobId;
+		std::string Name;
+		std::string SpoolFileName;			// <name>.queued (Submit ̸  )
+		FConversionJob Job;
+		TClock::time_point SubmitTime;
+	};
+
+	struct FCachedSkeleton
+	{
+		std::string RefPoseFileName;
+		std::unique_ptr<CBVH> BVH;
+		ULONGLONG LastUsed;
+	};
+
+	// worker ϳ job ̿   
+	struct FWorkerContext
+	{
+		std::vector<FCachedSkeleton> Skeletons;
+		std::vector<sKinectFrame> Block;
+		ULONGLONG UseCounter;
+	};
+
+	FConversionServiceOptions Options;
+
+	std::mutex Mutex;
+	std::condition_variable JobAvailable;
+	std::condition_variable Idle;
+	std::condition_variable InteractiveDone;
+	std::condition_variable StopRequested;
+
+	std::deque<FQueuedJob> Queues[EConversionPriority_Count];
+	FConversionServiceStats Stats;
+	std::deque<FConversionJobResult> Results;
+	ULONGLONG NextJobId;
+	bool bStopping;
+	int ReservedWorkerCount;				// Start   Interactive  worker 
+
+	std::vector<std::thread> Workers;
+	std::thread SpoolThread;
+
+	CConversionService(const CConversionService&) = delete;
+	CConversionService& operator=(const CConversionService&) = delete;
+
+	void WorkerMain(bool bInteractiveOnly);
+	void SpoolMain();
+
+	void ScanSpoolDirectory(bool bRecover);
+	ULONGLONG Enqueue(const FConversionJob& inJob, const std::string& inName, const std::string& inSpoolFileName);
+	bool PopJob(bool bInteractiveOnly, FQueuedJob& outJob);
+
+	CBVH* AcquireSkeleton(FWorkerContext& ioContext, const std::string& inRefPoseFileName, bool& outCacheHit);
+	bool Convert(FWorkerContext& ioContext, const FQueuedJob& inJob, FConversionJobResult& ioResult);
+	void WaitForInteractiveJobs(EConversionPriority inPriority);
+	void Complete(const FQueuedJob& inJob, const FConversionJobResult& inResult);
+
+	std::string GetSpoolPath(const std::string& inFileName) const;
+
+public:
+	explicit CConversionService(const FConversionServiceOptions& inOptions = FConversionServiceOptions());
+	~CConversionService();
+
+	// worker ( spool ) thread  Ѵ.
+	bool Start();
+
+	//   job  ⸦ ٷȴٰ thread  .  ̴ spool job  .queued  ´.
+	void Stop();
+
+	// ȯ : job id
+	ULONGLONG Submit(const FConversionJob& inJob, const std::string& inName = "");
+
+	// /  job    ٸ. (Start Ŀ ȣ. spool      Ȯ  ´)
+	void WaitForIdle();
+
+	FConversionServiceStats GetStats();
+
+	//  ȣ   job  (ִ ResultCapacity )  outResults ڿ δ.
+	void PopResults(std::vector<FConversionJobResult>& outResults);
+
+	// "key value"  پ : priority  queued, running, completed, failed, queue_ms_mean/max, run_ms_mean/max, skeleton cache,   
+	void AppendMetrics(std::string& outData);
+
+	// ٸ process  spool  job  ִ´. (ӽ Ͽ   ̸ ٲٹǷ   job   ʴ´)
+	static bool WriteJobFile(const std::string& inSpoolDirectory, const std::string& inName, const FConversionJob& inJob);
+	static bool ReadJobFile(const std::string& inFileName, FConversionJob& outJob);
+
+	static const char* GetPriorityName(EConversionPriority inPriority);
+};
@@ -0,0 +1,125 @@
+#include "stdafx.h"
+
+#include <stdio.h>
+
+#include "exportplan.h"
+#include "quaternion.h"
+
+const RotSeq DEFAULT_EXPORT_ROTATION_ORDER = zyx;
+
+bool CBVHExportPlan::IsValidTarget(const FBVHExportTarget & inTarget)
+{
+	if (inTarget.FileName.empty() || inTarget.FrameRate <= 0 || inTarget.Precision < 0 || inTarget.Precision > 9)
+		return false;
+
+	return GetRotationChannels(inTarget.RotationOrder) != nullptr;
+}
+
+const char * CBVHExportPlan::GetRotationChannels(RotSeq inRotSeq)
+{
+	switch (inRotSeq)
+	{
+	case zyx: return "Xrotation Yrotation Zrotation";
+	case zxy: return "Yrotation Xrotation Zrotation";
+	case yxz: return "Zrotation Xrotation Yrotation";
+	case yzx: return "Xrotation Zrotation Yrotation";
+	case xyz: return "Zrotation Yrotation Xrotation";
+	case xzy: return "Yrotation Zrotation Xrotation";
+	default:
+		// zyz     ȸ BVH channel  ǥ  .
+		return nullptr;
+	}
+}
+
+CBVHExportSink::CBVHExportSink(const FBVHExportTarget & inTarget) : Target(inTarget)
+{
+}
+
+bool CBVHExportSink::Begin(const CBVH & inBVH, size_t inFrameCount)
+{
+	std::string header;
+	inBVH.ExportHeader(header, inFrameCount, Target.FrameRate, CBVHExportPlan::GetRotationChannels(Target.RotationOrder));
+
+	if (Target.Format == EBVHExportFormat_Binary)
+	{
+		header.append("Binary: float32\n");
+		File.open(Target.FileName.c_str(), std::ios::out | std::ios::binary);
+	}
+	else
+	{
+		File.open(Target.FileName.c_str());
+	}
+
+	File << header;
+
+	return File.good();
+}
+
+void CBVHExportSink::WriteFrame(const XMVECTOR * inEulerAngles, int inJointCount, const XMVECTOR * inRootTranslation)
+{
+	const float convertRad2Deg = 180.0f / XM_PI;
+
+	if (Target.Format == EBVHExportFormat_Binary)
+	{
+		Values.clear();
+		Values.push_back(inRootTranslation ? XMVectorGetX(*inRootTranslation) : 0.0f);
+		Values.push_back(inRootTranslation ? XMVectorGetY(*inRootTranslation) : 0.0f);
+		Values.push_back(inRootTranslation ? XMVectorGetZ(*inRootTranslation) : 0.0f);
+
+		for (int i = 0; i < inJointCount; ++i)
+		{
+			Values.push_back(XMVectorGetX(inEulerAngles[i])*convertRad2Deg);
+			Values.push_back(XMVectorGetY(inEulerAngles[i])*convertRad2Deg);
+			Values.push_back(XMVectorGetZ(inEulerAngles[i])*convertRad2Deg);
+		}
+
+		File.write((const char*)Values.data(), Values.size() * sizeof(float));
+		return;
+	}
+
+	char buffer[64];
+
+	if (inRootTranslation)
+	{
+		snprintf(buffer, sizeof(buffer), "%.*f %.*f %.*f",
+			Target.Precision, XMVectorGetX(*inRootTranslation),
+			Target.Precision, XMVectorGetY(*inRootTranslation),
+			Target.Precision, XMVectorGetZ(*inRootTranslation));
+
+		Line = buffer;
+	}
+	else
+	{
+		Line = "0.0 0.0 0.0";
+	}
+
+	for (int i = 0; i < inJointCount; ++i)
+	{
+		snprintf(buffer, sizeof(buffer), " %.*f %.*f %.*f",
+			Target.Precision, XMVectorGetX(inEulerAngles[i])*convertRad2Deg,
+			Target.Precision, XMVectorGetY(inEulerAngles[i])*convertRad2Deg,
+			Target.Precision, XMVectorGetZ(inEulerAngles[i])*convertRad2Deg);
+
+		Line.append(buffer);
+	}
+
+	Line.append("\n");
+
+	File << Line;
+}
+
+bool CBVHExportSink::End()
+{
+	File.close();
+
+	return !File.fail();
+}
+
+void CBVHExportSink::Abort()
+{
+	if (!File.is_open())
+		return;
+
+	File.close();
+	DeleteFileA(Target.FileName.c_str());
+}
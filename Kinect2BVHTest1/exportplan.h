@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+
+#include "bvhexport.h"
+
+enum EBVHExportFormat
+{
+	EBVHExportFormat_Text,			// Ϲ BVH
+	EBVHExportFormat_Binary,		// BVH header + "Binary: float32" line + frame  float32 channel 
+};
+
+// zyx (quaternion.h  .cpp  include Ѵ)
+extern const RotSeq DEFAULT_EXPORT_ROTATION_ORDER;
+
+// export   ϳ 
+struct FBVHExportTarget
+{
+	std::string FileName;
+	RotSeq RotationOrder;			// Tait-Bryan   (xyz, xzy, yxz, yzx, zxy, zyx)
+	int Precision;					// text  Ҽ ڸ
+	EBVHExportFormat Format;
+	int FrameRate;
+
+	FBVHExportTarget(const std::string& inFileName, RotSeq inRotationOrder = DEFAULT_EXPORT_ROTATION_ORDER, int inPrecision = 6, EBVHExportFormat inFormat = EBVHExportFormat_Text, int inFrameRate = 30)
+		: FileName(inFileName), RotationOrder(inRotationOrder), Precision(inPrecision), Format(inFormat), FrameRate(inFrameRate)
+	{
+	}
+};
+
+// CBVH::ExportFiles     target 
+class CBVHExportPlan
+{
+	std::vector<FBVHExportTarget> Targets;
+
+public:
+	void AddTarget(const FBVHExportTarget& inTarget) { Targets.push_back(inTarget); }
+	const std::vector<FBVHExportTarget>& GetTargets() const { return Targets; }
+
+	static bool IsValidTarget(const FBVHExportTarget& inTarget);
+
+	// quaternion2Euler (res[0..2]) شϴ CHANNELS ̸.  ȸ   ̴. (zyx -> X Y Z)
+	static const char* GetRotationChannels(RotSeq inRotSeq);
+};
+
+// resampling  frame  target ϳ ٷ  .
+class CBVHExportSink
+{
+	const FBVHExportTarget& Target;
+
+	std::ofstream File;
+	std::string Line;
+	std::vector<float> Values;
+
+public:
+	CBVHExportSink(const FBVHExportTarget& inTarget);
+
+	const FBVHExportTarget& GetTarget() const { return Target; }
+
+	bool Begin(const CBVH& inBVH, size_t inFrameCount);
+
+	// inEulerAngles : joint  quaternion2Euler  (radian)
+	// inRootTranslation : root position channel . nullptr ̸ 0
+	void WriteFrame(const XMVECTOR* inEulerAngles, int inJointCount, const XMVECTOR* inRootTranslation = nullptr);
+
+	//    false
+	bool End();
+
+	//     :    ݰ .
+	void Abort();
+};
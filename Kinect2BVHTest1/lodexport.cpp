@@ -0,0 +1,165 @@
+#include "stdafx.h"
+
+#include "lodexport.h"
+#include "quaternion.h"
+
+static void AppendOffset(std::string& outData, const XMVECTOR& inOffset, int inDepth)
+{
+	outData.append(inDepth, '\t');
+	outData.append("OFFSET ");
+	outData.append(std::to_string(XMVectorGetX(inOffset)));
+	outData.append(" ");
+	outData.append(std::to_string(XMVectorGetY(inOffset)));
+	outData.append(" ");
+	outData.append(std::to_string(XMVectorGetZ(inOffset)));
+	outData.append("\n");
+}
+
+static void AppendEndSite(std::string& outData, const std::string& inName, const XMVECTOR& inOffset, int inDepth)
+{
+	outData.append(inDepth, '\t');
+	outData.append("End ");
+	outData.append(inName);
+	outData.append("\n");
+
+	outData.append(inDepth, '\t'); outData.append("{\n");
+	AppendOffset(outData, inOffset, inDepth + 1);
+	outData.append(inDepth, '\t'); outData.append("}\n");
+}
+
+bool CBVHLODMap::Compile(const CBVH & inSkeleton, const std::vector<std::string>& inRemovedJointNames, int inRateDivisor)
+{
+	Joints.clear();
+	Hierarchy.clear();
+
+	const auto& sourceJoints = inSkeleton.GetSortedJointArray();
+
+	if (sourceJoints.empty() || inRateDivisor < 1)
+		return false;
+
+	RateDivisor = inRateDivisor;
+
+	std::vector<char> removed(sourceJoints.size(), 0);
+
+	for (auto const& value : inRemovedJointNames)
+	{
+		int index = inSkeleton.FindSortedJointIndex(value);
+		if (index <= 0)
+			return false;		//  joint ̰ų root
+
+		removed[index] = 1;
+	}
+
+	Joints.reserve(sourceJoints.size());
+	Hierarchy.append("HIERARCHY\n");
+
+	ExportJoint(inSkeleton, removed, sourceJoints[0], sourceJoints[0]->Position, std::vector<int>(), 0);
+
+	return true;
+}
+
+void CBVHLODMap::ExportJoint(const CBVH & inSkeleton, const std::vector<char>& inRemoved, const FBVHJoint * inJoint, const XMVECTOR & inOffset, const std::vector<int>& inFoldIndices, int inDepth)
+{
+	FLODJoint joint;
+	joint.SourceIndex = inSkeleton.FindSortedJointIndex(inJoint->JointName);
+	joint.FoldIndices = inFoldIndices;
+	Joints.push_back(joint);
+
+	Hierarchy.append(inDepth, '\t');
+	Hierarchy.append(inJoint->ParentJoint ? "JOINT " : "ROOT ");
+	Hierarchy.append(inJoint->JointName);
+	Hierarchy.append("\n");
+
+	Hierarchy.append(inDepth, '\t'); Hierarchy.append("{\n");
+
+	AppendOffset(Hierarchy, inOffset, inDepth + 1);
+
+	Hierarchy.append(inDepth + 1, '\t');
+	Hierarchy.append(inJoint->ParentJoint ? "CHANNELS 3 " : "CHANNELS 6 Xposition Yposition Zposition ");
+	Hierarchy.append("Xrotation Yrotation Zrotation\n");
+
+	const size_t length = Hierarchy.size();
+
+	ExportChildren(inSkeleton, inRemoved, inJoint, XMVectorZero(), std::vector<int>(), inDepth + 1);
+
+	// ڽ  ŵ
+	if (Hierarchy.size() == length && inJoint->ChildrenJoint.size() > 0)
+	{
+		AppendEndSite(Hierarchy, "Site", inJoint->ChildrenJoint[0]->Position, inDepth + 1);
+	}
+
+	Hierarchy.append(inDepth, '\t'); Hierarchy.append("}\n");
+}
+
+void CBVHLODMap::ExportChildren(const CBVH & inSkeleton, const std::vector<char>& inRemoved, const FBVHJoint * inParent, const XMVECTOR & inOffset, const std::vector<int>& inFoldIndices, int inDepth)
+{
+	for (auto child : inParent->ChildrenJoint)
+	{
+		const XMVECTOR offset = XMVectorAdd(inOffset, child->Position);
+
+		// ڽ  node  SortedJointArray   End Site (FBVHJoint::GatherJoints)
+		if (child->ChildrenJoint.empty())
+		{
+			if (inFoldIndices.empty())
+			{
+				AppendEndSite(Hierarchy, child->JointName, offset, inDepth);
+			}
+			continue;
+		}
+
+		const int index = inSkeleton.FindSortedJointIndex(child->JointName);
+
+		if (index >= 0 && inRemoved[index])
+		{
+			std::vector<int> foldIndices(1, index);
+			foldIndices.insert(foldIndices.end(), inFoldIndices.begin(), inFoldIndices.end());
+
+			ExportChildren(inSkeleton, inRemoved, child, offset, foldIndices, inDepth);
+		}
+		else
+		{
+			ExportJoint(inSkeleton, inRemoved, child, offset, inFoldIndices, inDepth);
+		}
+	}
+}
+
+void CBVHLODMap::ExportHeader(std::string & outData, size_t inSourceFrameCount, int inSourceFrameRate) const
+{
+	outData.append(Hierarchy);
+
+	outData.append("MOTION\n");
+
+	outData.append("Frames: ");
+	outData.append(std::to_string(GetFrameCount(inSourceFrameCount)));
+	outData.append("\n");
+
+	outData.append("Frame Time: ");
+	outData.append(std::to_string((float)RateDivisor / (float)inSourceFrameRate));
+	outData.append("\n");
+}
+
+void CBVHLODMap::Apply(const FBVHJointTransform * inSourceFrame, FBVHJointTransform * outFrame, EEulerPrecision inPrecision) const
+{
+	const size_t count = Joints.size();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto& joint = Joints[i];
+		auto& value = outFrame[i];
+
+		value = inSourceFrame[joint.SourceIndex];
+
+		if (joint.FoldIndices.empty())
+			continue;
+
+		//   : devC * devJn * ... * devJ1
+		XMVECTOR devQuat = value.DevQuat;
+		for (auto foldIndex : joint.FoldIndices)
+		{
+			devQuat = XMQuaternionMultiply(devQuat, inSourceFrame[foldIndex].DevQuat);
+		}
+
+		value.DevQuat = devQuat;
+		QuaternionToEulerAngles(value.DevQuat, value.Rotation, zyx, inPrecision);
+	}
+}
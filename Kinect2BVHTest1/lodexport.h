@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <DirectXMath.h>
+
+#include "bvhexport.h"
+
+//  skeleton   (joint Ϻ , frame  ø)  Ģ.
+// ̸     joint  flat table  HIERARCHY ڿ   compile  ΰ,
+// frame  source frame  DevQuat   ŵ  ȸ ϱ⸸ Ѵ.
+//
+// ŵ joint J (parent P, child C)  C   ִ´ :
+//   devC' = devC * devJ (XMQuaternionMultiply ),  OFFSET C' = OFFSET J + OFFSET C
+//  joint  world ȸ ״̰, J  rest pose   ŭ C Ʒ ġ ޶.
+// ڽ  ŵ joint  ù ڽ OFFSET  End Site  ܴ. root    .
+class CBVHLODMap
+{
+	struct FLODJoint
+	{
+		int SourceIndex;				// source SortedJointArray index
+		std::vector<int> FoldIndices;	//   ŵ  ( ͺ)
+	};
+
+	std::vector<FLODJoint> Joints;		//  HIERARCHY 
+	std::string Hierarchy;				// HIERARCHY κ (Compile  )
+	int RateDivisor;
+
+	void ExportJoint(const CBVH& inSkeleton, const std::vector<char>& inRemoved, const FBVHJoint* inJoint, const XMVECTOR& inOffset, const std::vector<int>& inFoldIndices, int inDepth);
+	void ExportChildren(const CBVH& inSkeleton, const std::vector<char>& inRemoved, const FBVHJoint* inParent, const XMVECTOR& inOffset, const std::vector<int>& inFoldIndices, int inDepth);
+
+public:
+	CBVHLODMap() : RateDivisor(1) {}
+
+	// inRemovedJointNames :  joint (SortedJointArray  ִ ̸, root )
+	// inRateDivisor : source frame inRateDivisor  ϳ . (1 ̸ )
+	bool Compile(const CBVH& inSkeleton, const std::vector<std::string>& inRemovedJointNames, int inRateDivisor = 1);
+
+	int GetJointCount() const { return (int)Joints.size(); }
+	int GetRateDivisor() const { return RateDivisor; }
+
+	// source frame inSourceFrameCount    frame 
+	size_t GetFrameCount(size_t inSourceFrameCount) const { return (inSourceFrameCount + RateDivisor - 1) / RateDivisor; }
+	bool IsExportedFrame(size_t inSourceFrameIndex) const { return inSourceFrameIndex % RateDivisor == 0; }
+
+	// HIERARCHY  MOTION header (Frame Time = RateDivisor / inSourceFrameRate)
+	void ExportHeader(std::string& outData, size_t inSourceFrameCount, int inSourceFrameRate) const;
+
+	// inSourceFrame (DevQuat, Rotation  ) -> outFrame (GetJointCount )
+	//  ִ joint   Rotation  ״ ϰ,  inPrecision  ٽ ȯѴ.
+	void Apply(const FBVHJointTransform* inSourceFrame, FBVHJointTransform* outFrame, EEulerPrecision inPrecision) const;
+};
@@ -0,0 +1,83 @@
+#include "stdafx.h"
+
+#include "mappedfile.h"
+
+CMappedFile::CMappedFile() : FileHandle(INVALID_HANDLE_VALUE), MappingHandle(nullptr), Data(nullptr), Size(0), LastWriteTime(0)
+{
+}
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+bool CMappedFile::Open(const std::string & inFileName)
+{
+	Close();
+
+	FileHandle = CreateFileA(inFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (FileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(FileHandle, &fileSize) || (ULONGLONG)fileSize.QuadPart > (ULONGLONG)SIZE_MAX)
+	{
+		Close();
+		return false;
+	}
+
+	Size = (size_t)fileSize.QuadPart;
+
+	FILETIME lastWriteTime;
+	if (!GetFileTime(FileHandle, nullptr, nullptr, &lastWriteTime))
+	{
+		Close();
+		return false;
+	}
+
+	LastWriteTime = ((ULONGLONG)lastWriteTime.dwHighDateTime << 32) | lastWriteTime.dwLowDateTime;
+
+	// ũⰡ 0  mapping   .  Ϸ .
+	if (Size == 0)
+		return true;
+
+	MappingHandle = CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (MappingHandle == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	Data = (const char*)MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (Data == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if (Data)
+	{
+		UnmapViewOfFile(Data);
+		Data = nullptr;
+	}
+
+	if (MappingHandle)
+	{
+		CloseHandle(MappingHandle);
+		MappingHandle = nullptr;
+	}
+
+	if (FileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(FileHandle);
+		FileHandle = INVALID_HANDLE_VALUE;
+	}
+
+	Size = 0;
+	LastWriteTime = 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+// Read-only memory mapping of a whole file.
+// Capture/BVH reader stream   ͷ  parsing   .
+class CMappedFile
+{
+	HANDLE FileHandle;
+	HANDLE MappingHandle;
+
+	const char* Data;
+	size_t Size;
+	ULONGLONG LastWriteTime;
+
+public:
+	CMappedFile();
+	~CMappedFile();
+
+	CMappedFile(const CMappedFile&) = delete;
+	CMappedFile& operator=(const CMappedFile&) = delete;
+
+	bool Open(const std::string& inFileName);
+	void Close();
+
+	bool IsOpen() const { return FileHandle != INVALID_HANDLE_VALUE; }
+
+	const char* GetData() const { return Data; }
+	size_t GetSize() const { return Size; }
+
+	// Open     ð (FILETIME, 100ns ). sidecar  ֽ Ȯ  
+	ULONGLONG GetLastWriteTime() const { return LastWriteTime; }
+};
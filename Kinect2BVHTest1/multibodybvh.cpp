@@ -0,0 +1,200 @@
+#include "stdafx.h"
+
+#include <assert.h>
+#include <fstream>
+
+#include "multibodybvh.h"
+#include "quaternion.h"
+
+CMultiBodyBVH::CMultiBodyBVH(const CBVH & inSkeleton, int inBodyCount) : Skeleton(inSkeleton), BodyCount(inBodyCount), JointCount(inSkeleton.GetJointCount()), RawFrames(Arena), CurrentRawJoints(nullptr)
+{
+	assert(BodyCount > 0);
+
+	BodyTracked.resize(BodyCount, false);
+}
+
+void CMultiBodyBVH::Begin(DWORD inMilliSeconds)
+{
+	// resampling  raw frame  ð  .
+	if (RawFrames.size() > 0 && inMilliSeconds < RawFrames[RawFrames.size() - 1].ElapseTime)
+	{
+		CurrentRawJoints = nullptr;
+		return;
+	}
+
+	FMultiBodyRawFrame& rawFrame = RawFrames.AddDefaulted();
+	rawFrame.ElapseTime = inMilliSeconds;
+	rawFrame.Joints = Arena.AllocateArray<FBVHJointTransform>(BodyCount * JointCount);
+
+	CurrentRawJoints = rawFrame.Joints.data();
+}
+
+void CMultiBodyBVH::AddJointRotationValue(int inBodyIndex, JointType inKinectJointType, const XMVECTOR & inQuat)
+{
+	if (CurrentRawJoints == nullptr || inBodyIndex < 0 || inBodyIndex >= BodyCount)
+		return;
+
+	int sortedIndex = Skeleton.GetSortedJointIndex(inKinectJointType);
+	if (sortedIndex < 0)
+		return;
+
+	auto& frameInfo = CurrentRawJoints[inBodyIndex * JointCount + sortedIndex];
+
+	if (XMVectorGetX(inQuat) == 0.0f &&
+		XMVectorGetY(inQuat) == 0.0f &&
+		XMVectorGetZ(inQuat) == 0.0f &&
+		XMVectorGetW(inQuat) == 0.0f)
+	{
+		frameInfo.Initialized = false;
+		return;
+	}
+
+	frameInfo.Initialized = true;
+	frameInfo.WorldQuat = inQuat;
+
+	BodyTracked[inBodyIndex] = true;
+}
+
+void CMultiBodyBVH::AddJointPositionValue(int inBodyIndex, JointType inKinectJointType, const XMVECTOR & inPosition)
+{
+	if (CurrentRawJoints == nullptr || inBodyIndex < 0 || inBodyIndex >= BodyCount)
+		return;
+
+	int sortedIndex = Skeleton.GetSortedJointIndex(inKinectJointType);
+	if (sortedIndex < 0)
+		return;
+
+	auto& frameInfo = CurrentRawJoints[inBodyIndex * JointCount + sortedIndex];
+	frameInfo.Initialized = true;
+	frameInfo.Position = inPosition;
+
+	BodyTracked[inBodyIndex] = true;
+}
+
+void CMultiBodyBVH::End()
+{
+	CurrentRawJoints = nullptr;
+}
+
+void CMultiBodyBVH::ClearFrames()
+{
+	RawFrames.clear();
+	Arena.Reset();
+	BodyTracked.assign(BodyCount, false);
+
+	CurrentRawJoints = nullptr;
+}
+
+void CMultiBodyBVH::GenerateLocalRotation(std::vector<XMVECTOR>& outRootOrigins)
+{
+	outRootOrigins.assign(BodyCount, XMVectorZero());
+	std::vector<bool> rootFound(BodyCount, false);
+
+	// frame  [body]  ӵǾ Ƿ block  ʷ   body  ȴ.
+	for (auto& rawFrame : RawFrames)
+	{
+		for (int body = 0; body < BodyCount; ++body)
+		{
+			if (!BodyTracked[body])
+				continue;
+
+			FBVHJointTransform* joints = &rawFrame.Joints[body * JointCount];
+
+			if (!rootFound[body] && joints[0].Initialized)
+			{
+				rootFound[body] = true;
+				outRootOrigins[body] = joints[0].Position;
+			}
+
+			Skeleton.SolveLocalRotation(joints);
+		}
+	}
+}
+
+bool CMultiBodyBVH::ExportFiles(const std::string & inFileNamePrefix)
+{
+	std::vector<XMVECTOR> rootOrigins;
+	GenerateLocalRotation(rootOrigins);
+
+	//  frame ġ   CBVH::ExportFile   cursor  ϰ,  body   
+	DWORD beginTime, endTime;
+	Skeleton.GetExportTimeRange(beginTime, endTime);
+
+	CBVHResampleCursor cursor(Skeleton.GetExportFrameRate(), beginTime, endTime);
+	size_t frameCount = 0;
+
+	if (RawFrames.size() >= 2)
+	{
+		cursor.Start(RawFrames[0].ElapseTime);
+		frameCount = cursor.GetFrameCount(RawFrames[RawFrames.size() - 1].ElapseTime);
+	}
+
+	const CClipTransform* clipTransform = Skeleton.GetClipTransform();
+	const bool bRootTranslation = Skeleton.IsRootTranslationExported();
+	const EEulerPrecision precision = Skeleton.GetEulerPrecision();
+
+	//  body     ΰ   frame loop  body  MOTION  پ .
+	std::string header;
+	Skeleton.ExportHeader(header, frameCount);
+
+	std::vector<std::ofstream> files(BodyCount);
+	bool bResult = true;
+
+	for (int body = 0; body < BodyCount; ++body)
+	{
+		if (!BodyTracked[body])
+			continue;
+
+		files[body].open(inFileNamePrefix + "_" + std::to_string(body) + ".bvh");
+		if (!files[body].is_open())
+		{
+			bResult = false;
+			continue;
+		}
+
+		files[body] << header;
+	}
+
+	std::vector<FBVHJointTransform> row(JointCount);
+	std::string line;
+	float interpTime;
+
+	for (size_t i = 0; i + 1 < RawFrames.size() && !cursor.IsFinished(); ++i)
+	{
+		for (; cursor.GetFrame(RawFrames[i].ElapseTime, RawFrames[i + 1].ElapseTime, interpTime); cursor.Next())
+		{
+			for (int body = 0; body < BodyCount; ++body)
+			{
+				if (!files[body].is_open())
+					continue;
+
+				Skeleton.InterpolateFrame(GetRawJoints(i, body), GetRawJoints(i + 1, body), interpTime, rootOrigins[body], row.data());
+				Skeleton.ApplyFrameTransform(row.data(), clipTransform, bRootTranslation);
+
+				for (auto& value : row)
+				{
+					QuaternionToEulerAngles(value.DevQuat, value.Rotation, zyx, precision);
+				}
+
+				line.clear();
+				FBVHFrame::ExportMOTION(row.data(), row.size(), line, false, bRootTranslation);
+
+				files[body] << line;
+			}
+		}
+	}
+
+	assert(cursor.GetFrameIndex() == frameCount);
+
+	for (auto& file : files)
+	{
+		if (!file.is_open())
+			continue;
+
+		file.close();
+		if (file.fail())
+			bResult = false;
+	}
+
+	return bResult;
+}
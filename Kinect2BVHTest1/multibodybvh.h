@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <Kinect.h>
+#include <DirectXMath.h>
+
+#include "bvhexport.h"
+#include "bvharena.h"
+
+// Kinect v2  BODY_COUNT(6)  Ѵ.
+// skeleton(ref pose) CBVH ϳ ϰ, body  frame  frame  [body][joint]  block ϳ ؼ
+// local rotation  resampling   body     óѴ.
+// block  CBVH  RawFrames ó arena  Ƿ frame  þ  frame  ű ʴ´.
+struct FMultiBodyRawFrame
+{
+	DWORD ElapseTime;
+	TBVHArray<FBVHJointTransform> Joints;		// [body][joint]
+};
+
+class CMultiBodyBVH
+{
+	const CBVH& Skeleton;			// ImportRefPoseByBVHFile   CBVH ( )
+
+	int BodyCount;
+	int JointCount;
+
+	CBVHArena Arena;									// ClearFrames  Reset
+	TBVHChunkedArray<FMultiBodyRawFrame> RawFrames;
+	std::vector<bool> BodyTracked;						//  ̶ data   body
+
+	FBVHJointTransform* CurrentRawJoints;				//  frame  [body][joint]
+
+	FBVHJointTransform* GetRawJoints(size_t inFrameIndex, int inBodyIndex)
+	{
+		return &RawFrames[inFrameIndex].Joints[inBodyIndex * JointCount];
+	}
+
+	CMultiBodyBVH(const CMultiBodyBVH&) = delete;
+	CMultiBodyBVH& operator=(const CMultiBodyBVH&) = delete;
+
+	// outRootOrigins : body  root  ó  frame  position (root ̵ )
+	void GenerateLocalRotation(std::vector<XMVECTOR>& outRootOrigins);
+
+public:
+	CMultiBodyBVH(const CBVH& inSkeleton, int inBodyCount = BODY_COUNT);
+
+	int GetBodyCount() const { return BodyCount; }
+	bool IsBodyTracked(int inBodyIndex) const { return BodyTracked[inBodyIndex]; }
+
+	//  body   sensor frame (CBVH::Begin ó ð ǵư frame  )
+	void Begin(DWORD inMilliSeconds);
+
+	void AddJointRotationValue(int inBodyIndex, JointType inKinectJointType, const XMVECTOR& inQuat);
+	void AddJointPositionValue(int inBodyIndex, JointType inKinectJointType, const XMVECTOR& inPosition);
+
+	void End();
+
+	void ClearFrames();
+
+	//  body  <inFileNamePrefix>_<body index>.bvh  
+	// Skeleton  export  (frame rate, export , root ̵, ClipTransform, Euler tier)  .
+	// ų   body  ϳ  false ( body   )
+	bool ExportFiles(const std::string& inFileNamePrefix);
+};
@@ -0,0 +1,508 @@
+#include "stdafx.h"
+
+#include <algorithm>
+
+#include "multisensor.h"
+
+static Vector4 XMVECTORToVector4(FXMVECTOR inValue)
+{
+	Vector4 value;
+	value.x = XMVectorGetX(inValue);
+	value.y = XMVectorGetY(inValue);
+	value.z = XMVectorGetZ(inValue);
+	value.w = XMVectorGetW(inValue);
+	return value;
+}
+
+CMultiSensorFusion::FSensor::FSensor(const FSensorOptions & inOptions, const FMultiSensorFusionOptions & inFusionOptions)
+	: Options(inOptions), Queue((size_t)inFusionOptions.QueueCapacity), bClosed(false), PushedFrameCount(0), DroppedFrameCount(0),
+	History((size_t)inFusionOptions.HistoryCapacity), HistoryUsed((size_t)inFusionOptions.HistoryCapacity, false),
+	HistoryHead(0), HistoryCount(0), LatestTime(0), bHasSample(false), bFinished(false), LateFrameCount(0), UsedFrameCount(0)
+{
+}
+
+CMultiSensorFusion::CMultiSensorFusion(const FMultiSensorFusionOptions & inOptions)
+	: Options(inOptions), bStarted(false), BeginTime(0), TickIndex(0)
+{
+	Options.FrameRate = std::max(Options.FrameRate, 1);
+	Options.AlignWindow = std::max(Options.AlignWindow, 0);
+	Options.MaxLatency = std::max(Options.MaxLatency, 0);
+	Options.QueueCapacity = std::max(Options.QueueCapacity, 2);
+	Options.HistoryCapacity = std::max(Options.HistoryCapacity, 2);
+}
+
+int CMultiSensorFusion::AddSensor(const FSensorOptions & inOptions)
+{
+	Sensors.emplace_back(new FSensor(inOptions, Options));
+	return (int)Sensors.size() - 1;
+}
+
+bool CMultiSensorFusion::Push(int inSensorIndex, const sKinectFrame & inFrame, const TrackingState * inTrackingStates)
+{
+	FSensor& sensor = *Sensors[inSensorIndex];
+
+	// queue slot  ٷ   Ƿ (TryPush   ) producer stack  
+	FSensorSample sample;
+	sample.Frame = inFrame;
+
+	for (int i = 0; i < JointType_Count; ++i)
+	{
+		sample.TrackingState[i] = inTrackingStates ? (BYTE)inTrackingStates[i] : (BYTE)TrackingState_Tracked;
+	}
+
+	sensor.PushedFrameCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (!sensor.Queue.TryPush(sample))
+	{
+		sensor.DroppedFrameCount.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	return true;
+}
+
+void CMultiSensorFusion::Close(int inSensorIndex)
+{
+	Sensors[inSensorIndex]->bClosed.store(true, std::memory_order_release);
+}
+
+DWORD CMultiSensorFusion::GetTickTime(ULONGLONG inTickIndex) const
+{
+	return BeginTime + (DWORD)(inTickIndex * 1000 / Options.FrameRate);
+}
+
+void CMultiSensorFusion::PullSensorQueues()
+{
+	const size_t historyCapacity = (size_t)Options.HistoryCapacity;
+	const DWORD tickTime = bStarted ? GetTickTime(TickIndex) : 0;
+
+	for (auto& sensorPtr : Sensors)
+	{
+		FSensor& sensor = *sensorPtr;
+		if (sensor.bFinished)
+			continue;
+
+		// Close   frame  Close    TryPop   δ.
+		const bool bClosed = sensor.bClosed.load(std::memory_order_acquire);
+
+		const bool bTransform = !XMQuaternionIsIdentity(sensor.Options.Rotation) || !XMVector3Equal(sensor.Options.Translation, XMVectorZero());
+
+		while (sensor.HistoryCount < historyCapacity)
+		{
+			const size_t slot = (sensor.HistoryHead + sensor.HistoryCount) % historyCapacity;
+			FSensorSample& sample = sensor.History[slot];
+
+			if (!sensor.Queue.TryPop(sample))
+				break;
+
+			const long long time = (long long)sample.Frame.MilliSecond + sensor.Options.ClockOffset;
+			const DWORD commonTime = time > 0 ? (DWORD)time : 0;
+
+			// ð ǵưų ̹  tick   sample    .
+			if ((sensor.bHasSample && commonTime < sensor.LatestTime) ||
+				(bStarted && commonTime + (DWORD)Options.AlignWindow < tickTime))
+			{
+				++sensor.LateFrameCount;
+				continue;
+			}
+
+			sample.Frame.MilliSecond = commonTime;
+
+			if (bTransform)
+			{
+				for (int k = 0; k < sample.Frame.PosCount; ++k)
+				{
+					Vector4& position = sample.Frame.Pos[k].Position;
+					position = XMVECTORToVector4(XMVector3Rotate(Vector4ToXMVECTOR(position), sensor.Options.Rotation) + sensor.Options.Translation);
+				}
+
+				for (int k = 0; k < sample.Frame.RotCount; ++k)
+				{
+					// worldQuat' = worldQuat*R (sensor space ȸ ڿ  space )
+					Vector4& quat = sample.Frame.Rot[k].Quaternion;
+					quat = XMVECTORToVector4(XMQuaternionMultiply(Vector4ToXMVECTOR(quat), sensor.Options.Rotation));
+				}
+			}
+
+			sensor.HistoryUsed[slot] = false;
+			++sensor.HistoryCount;
+
+			sensor.LatestTime = commonTime;
+			sensor.bHasSample = true;
+		}
+
+		if (bClosed && sensor.Queue.IsEmpty())
+		{
+			sensor.bFinished = true;
+		}
+	}
+}
+
+bool CMultiSensorFusion::IsTickReady(DWORD inTickTime) const
+{
+	bool bAllReady = true;
+	bool bAllFinished = true;
+	bool bHasSample = false;
+	DWORD latestTime = 0;
+
+	for (auto const& sensorPtr : Sensors)
+	{
+		const FSensor& sensor = *sensorPtr;
+
+		if (sensor.bHasSample)
+		{
+			bHasSample = true;
+			latestTime = std::max(latestTime, sensor.LatestTime);
+		}
+
+		if (sensor.bFinished)
+			continue;
+
+		bAllFinished = false;
+
+		// timestamp   ϹǷ T  sample  ϳ  T    sample  ̹  ִ.
+		// History   á  ٸ  .
+		const bool bReady = (sensor.bHasSample && sensor.LatestTime >= inTickTime) || sensor.HistoryCount == (size_t)Options.HistoryCapacity;
+		bAllReady = bAllReady && bReady;
+	}
+
+	if (!bHasSample)
+		return false;
+
+	if (bAllFinished)
+		return inTickTime <= latestTime;
+
+	return bAllReady || latestTime >= inTickTime + (DWORD)Options.MaxLatency;
+}
+
+void CMultiSensorFusion::GatherJointValues(FSensor & ioSensor, size_t inSlot, FSensorJointValues & outValues)
+{
+	for (int i = 0; i < JointType_Count; ++i)
+	{
+		outValues.Position[i] = XMVectorZero();
+		outValues.Quat[i] = XMQuaternionIdentity();
+		outValues.PositionWeight[i] = 0.0f;
+		outValues.QuatWeight[i] = 0.0f;
+	}
+
+	if (!ioSensor.HistoryUsed[inSlot])
+	{
+		ioSensor.HistoryUsed[inSlot] = true;
+		++ioSensor.UsedFrameCount;
+	}
+
+	const FSensorSample& sample = ioSensor.History[inSlot];
+	const float stateWeight[3] = { 0.0f, Options.InferredWeight, 1.0f };
+
+	for (int k = 0; k < sample.Frame.PosCount; ++k)
+	{
+		const int jointType = sample.Frame.Pos[k].JointType;
+		if (jointType < 0 || jointType >= JointType_Count)
+			continue;
+
+		outValues.Position[jointType] = Vector4ToXMVECTOR(sample.Frame.Pos[k].Position);
+		outValues.PositionWeight[jointType] = ioSensor.Options.Weight * stateWeight[std::min((int)sample.TrackingState[jointType], 2)];
+	}
+
+	for (int k = 0; k < sample.Frame.RotCount; ++k)
+	{
+		const int jointType = sample.Frame.Rot[k].JointType;
+		if (jointType < 0 || jointType >= JointType_Count)
+			continue;
+
+		const Vector4& value = sample.Frame.Rot[k].Quaternion;
+		if (value.x == 0.0f && value.y == 0.0f && value.z == 0.0f && value.w == 0.0f)
+			continue;
+
+		outValues.Quat[jointType] = Vector4ToXMVECTOR(value);
+		outValues.QuatWeight[jointType] = ioSensor.Options.Weight * stateWeight[std::min((int)sample.TrackingState[jointType], 2)];
+	}
+}
+
+void CMultiSensorFusion::FuseTick(DWORD inTickTime, sKinectFrame & outFrame)
+{
+	XMVECTOR positionSum[JointType_Count];
+	XMVECTOR quatSum[JointType_Count];
+	float positionWeight[JointType_Count];
+	float quatWeight[JointType_Count];
+
+	for (int i = 0; i < JointType_Count; ++i)
+	{
+		positionSum[i] = XMVectorZero();
+		quatSum[i] = XMVectorZero();
+		positionWeight[i] = 0.0f;
+		quatWeight[i] = 0.0f;
+	}
+
+	const size_t historyCapacity = (size_t)Options.HistoryCapacity;
+	const DWORD alignWindow = (DWORD)Options.AlignWindow;
+
+	for (auto& sensorPtr : Sensors)
+	{
+		FSensor& sensor = *sensorPtr;
+
+		// tick  ̿   sample (History  timestamp )
+		size_t prevSlot = historyCapacity;
+		size_t nextSlot = historyCapacity;
+
+		for (size_t i = 0; i < sensor.HistoryCount; ++i)
+		{
+			const size_t slot = (sensor.HistoryHead + i) % historyCapacity;
+			const DWORD time = sensor.History[slot].Frame.MilliSecond;
+
+			if (time <= inTickTime)
+			{
+				if (inTickTime - time <= alignWindow)
+				{
+					prevSlot = slot;
+				}
+			}
+			else
+			{
+				if (time - inTickTime <= alignWindow)
+				{
+					nextSlot = slot;
+				}
+
+				break;
+			}
+		}
+
+		if (prevSlot == historyCapacity && nextSlot == historyCapacity)
+			continue;
+
+		// ʸ AlignWindow ȿ   sample  ״ .
+		FSensorJointValues values0;
+		FSensorJointValues values1;
+		float interpTime = 0.0f;
+
+		if (prevSlot != historyCapacity)
+		{
+			GatherJointValues(sensor, prevSlot, values0);
+		}
+
+		if (nextSlot != historyCapacity)
+		{
+			GatherJointValues(sensor, nextSlot, values1);
+
+			if (prevSlot == historyCapacity)
+			{
+				values0 = values1;
+			}
+			else
+			{
+				const DWORD time0 = sensor.History[prevSlot].Frame.MilliSecond;
+				const DWORD time1 = sensor.History[nextSlot].Frame.MilliSecond;
+				interpTime = (float)(inTickTime - time0) / (float)(time1 - time0);
+			}
+		}
+		else
+		{
+			values1 = values0;
+		}
+
+		for (int i = 0; i < JointType_Count; ++i)
+		{
+			//  sample  ִ joint    .
+			const float positionWeight0 = values0.PositionWeight[i];
+			const float positionWeight1 = values1.PositionWeight[i];
+
+			if (positionWeight0 > 0.0f || positionWeight1 > 0.0f)
+			{
+				XMVECTOR position;
+				float weight;
+
+				if (positionWeight0 > 0.0f && positionWeight1 > 0.0f)
+				{
+					position = XMVectorLerp(values0.Position[i], values1.Position[i], interpTime);
+					weight = positionWeight0 + (positionWeight1 - positionWeight0) * interpTime;
+				}
+				else
+				{
+					position = positionWeight0 > 0.0f ? values0.Position[i] : values1.Position[i];
+					weight = positionWeight0 > 0.0f ? positionWeight0 : positionWeight1;
+				}
+
+				positionSum[i] += position * weight;
+				positionWeight[i] += weight;
+			}
+
+			const float quatWeight0 = values0.QuatWeight[i];
+			const float quatWeight1 = values1.QuatWeight[i];
+
+			if (quatWeight0 > 0.0f || quatWeight1 > 0.0f)
+			{
+				XMVECTOR quat;
+				float weight;
+
+				if (quatWeight0 > 0.0f && quatWeight1 > 0.0f)
+				{
+					quat = XMQuaternionSlerp(values0.Quat[i], values1.Quat[i], interpTime);
+					weight = quatWeight0 + (quatWeight1 - quatWeight0) * interpTime;
+				}
+				else
+				{
+					quat = quatWeight0 > 0.0f ? values0.Quat[i] : values1.Quat[i];
+					weight = quatWeight0 > 0.0f ? quatWeight0 : quatWeight1;
+				}
+
+				// q  -q   ȸ̹Ƿ   ʰ  ݱ   Ѵ.
+				if (quatWeight[i] > 0.0f && XMVectorGetX(XMVector4Dot(quat, quatSum[i])) < 0.0f)
+				{
+					quat = XMVectorNegate(quat);
+				}
+
+				quatSum[i] += quat * weight;
+				quatWeight[i] += weight;
+			}
+		}
+	}
+
+	outFrame.MilliSecond = inTickTime;
+	outFrame.PosCount = 0;
+	outFrame.RotCount = 0;
+
+	for (int i = 0; i < JointType_Count; ++i)
+	{
+		if (positionWeight[i] > 0.0f)
+		{
+			sKinectPosition& position = outFrame.Pos[outFrame.PosCount++];
+			position.JointType = i;
+			position.Position = XMVECTORToVector4(positionSum[i] / positionWeight[i]);
+		}
+
+		// Ȯ ݴ  ȸ  0    ִ.
+		if (quatWeight[i] > 0.0f && XMVectorGetX(XMVector4Dot(quatSum[i], quatSum[i])) > 1e-12f)
+		{
+			sKinectRotation& rotation = outFrame.Rot[outFrame.RotCount++];
+			rotation.JointType = i;
+			rotation.Quaternion = XMVECTORToVector4(XMQuaternionNormalize(quatSum[i]));
+		}
+		else if (positionWeight[i] > 0.0f)
+		{
+			// Kinect ó 0 quaternion  ѱ. (߸ position  Initialized  Ǿ  WorldQuat  )
+			sKinectRotation& rotation = outFrame.Rot[outFrame.RotCount++];
+			rotation.JointType = i;
+			rotation.Quaternion = XMVECTORToVector4(XMVectorZero());
+		}
+	}
+}
+
+void CMultiSensorFusion::DiscardHistory(DWORD inNextTickTime)
+{
+	const size_t historyCapacity = (size_t)Options.HistoryCapacity;
+
+	for (auto& sensorPtr : Sensors)
+	{
+		FSensor& sensor = *sensorPtr;
+
+		//  tick  AlignWindow  sample    tick   ʴ´.
+		while (sensor.HistoryCount > 0 && sensor.History[sensor.HistoryHead].Frame.MilliSecond + (DWORD)Options.AlignWindow < inNextTickTime)
+		{
+			sensor.HistoryHead = (sensor.HistoryHead + 1) % historyCapacity;
+			--sensor.HistoryCount;
+		}
+	}
+}
+
+bool CMultiSensorFusion::PopFusedFrame(sKinectFrame & outFrame)
+{
+	PullSensorQueues();
+
+	if (!bStarted)
+	{
+		//  sensor  ù sample  (Ǵ MaxLatency ŭ) ٸ ,  ̸ sample  tick  Ѵ.
+		bool bAllArrived = true;
+		bool bHasSample = false;
+		DWORD firstTime = 0;
+		DWORD latestTime = 0;
+
+		for (auto const& sensorPtr : Sensors)
+		{
+			const FSensor& sensor = *sensorPtr;
+
+			if (sensor.HistoryCount > 0)
+			{
+				const DWORD time = sensor.History[sensor.HistoryHead].Frame.MilliSecond;
+				firstTime = bHasSample ? std::min(firstTime, time) : time;
+				latestTime = std::max(latestTime, sensor.LatestTime);
+				bHasSample = true;
+			}
+			else if (!sensor.bFinished)
+			{
+				bAllArrived = false;
+			}
+		}
+
+		if (!bHasSample || (!bAllArrived && latestTime < firstTime + (DWORD)Options.MaxLatency))
+			return false;
+
+		bStarted = true;
+		BeginTime = firstTime;
+		TickIndex = 0;
+	}
+
+	for (;;)
+	{
+		const DWORD tickTime = GetTickTime(TickIndex);
+		if (!IsTickReady(tickTime))
+			return false;
+
+		FuseTick(tickTime, outFrame);
+
+		++TickIndex;
+		DiscardHistory(GetTickTime(TickIndex));
+		PullSensorQueues();
+
+		//  sensor  AlignWindow ȿ sample   tick  ǳʶڴ. (CBVH  յ frame  )
+		if (outFrame.PosCount > 0 || outFrame.RotCount > 0)
+			return true;
+	}
+}
+
+size_t CMultiSensorFusion::Poll(CBVH & outBVH)
+{
+	size_t count = 0;
+
+	sKinectFrame frame;
+	while (PopFusedFrame(frame))
+	{
+		CKinectCaptureReader::ReplayFrame(frame, outBVH);
+		++count;
+	}
+
+	return count;
+}
+
+bool CMultiSensorFusion::IsFinished() const
+{
+	DWORD latestTime = 0;
+	bool bHasSample = false;
+
+	for (auto const& sensorPtr : Sensors)
+	{
+		const FSensor& sensor = *sensorPtr;
+		if (!sensor.bFinished)
+			return false;
+
+		if (sensor.bHasSample)
+		{
+			bHasSample = true;
+			latestTime = std::max(latestTime, sensor.LatestTime);
+		}
+	}
+
+	return !bHasSample || (bStarted && GetTickTime(TickIndex) > latestTime);
+}
+
+FMultiSensorStats CMultiSensorFusion::GetStats(int inSensorIndex) const
+{
+	const FSensor& sensor = *Sensors[inSensorIndex];
+
+	FMultiSensorStats stats;
+	stats.PushedFrameCount = sensor.PushedFrameCount.load(std::memory_order_relaxed);
+	stats.DroppedFrameCount = sensor.DroppedFrameCount.load(std::memory_order_relaxed);
+	stats.LateFrameCount = sensor.LateFrameCount;
+	stats.UsedFrameCount = sensor.UsedFrameCount;
+	return stats;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <Kinect.h>
+
+#include "bvhexport.h"
+#include "capturereader.h"
+
+//  ũ ring queue (producer thread ϳ, consumer thread ϳ). lock  Head/Tail  atomic  ְ޴´.
+//   TryPush  ٸ ʰ false,   TryPop  false
+template<typename T>
+class TSpscQueue
+{
+	std::unique_ptr<T[]> Items;
+	size_t Mask;
+
+	std::atomic<size_t> Head;		// consumer    ġ
+	std::atomic<size_t> Tail;		// producer    ġ
+
+	TSpscQueue(const TSpscQueue&) = delete;
+	TSpscQueue& operator=(const TSpscQueue&) = delete;
+
+public:
+	// inCapacity  2  ŵ ø.
+	explicit TSpscQueue(size_t inCapacity) : Mask(0), Head(0), Tail(0)
+	{
+		size_t capacity = 2;
+		while (capacity < inCapacity)
+		{
+			capacity <<= 1;
+		}
+
+		Items.reset(new T[capacity]);
+		Mask = capacity - 1;
+	}
+
+	bool TryPush(const T& inItem)
+	{
+		const size_t tail = Tail.load(std::memory_order_relaxed);
+		if (tail - Head.load(std::memory_order_acquire) > Mask)
+			return false;
+
+		Items[tail & Mask] = inItem;
+		Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool TryPop(T& outItem)
+	{
+		const size_t head = Head.load(std::memory_order_relaxed);
+		if (head == Tail.load(std::memory_order_acquire))
+			return false;
+
+		outItem = Items[head & Mask];
+		Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool IsEmpty() const
+	{
+		return Head.load(std::memory_order_acquire) == Tail.load(std::memory_order_acquire);
+	}
+};
+
+struct FSensorOptions
+{
+	int ClockOffset;			// sensor timestamp + ClockOffset =  ð (ms)
+	XMVECTOR Rotation;			// sensor camera space ->  space
+	XMVECTOR Translation;		// (m)
+	float Weight;				// sensor ü ŷڵ
+
+	FSensorOptions() : ClockOffset(0), Weight(1.0f)
+	{
+		Rotation = XMQuaternionIdentity();
+		Translation = XMVectorZero();
+	}
+};
+
+struct FMultiSensorFusionOptions
+{
+	int FrameRate;				// fused frame    ð  (Hz)
+	int AlignWindow;			// tick  ̸ŭ (ms)  sample  
+	int MaxLatency;				//  ռ sensor  tick  ̸ŭ (ms)   sensor  fusion
+	int QueueCapacity;			// sensor  producer -> fusion queue  frame 
+	int HistoryCapacity;		// sensor  fusion ʿ ϴ frame 
+	float InferredWeight;		// TrackingState_Inferred joint  ġ (Tracked = 1, NotTracked = 0)
+
+	FMultiSensorFusionOptions() : FrameRate(30), AlignWindow(17), MaxLatency(100), QueueCapacity(64), HistoryCapacity(8), InferredWeight(0.25f)
+	{
+	}
+};
+
+struct FMultiSensorStats
+{
+	ULONGLONG PushedFrameCount;		// producer   frame
+	ULONGLONG DroppedFrameCount;	// queue     frame
+	ULONGLONG LateFrameCount;		// ̹  tick  ռ timestamp   frame
+	ULONGLONG UsedFrameCount;		// fused frame    ̻  frame
+};
+
+//  depth sensor     , sensor  body frame   ð tick  ߾ ϳ frame  ģ.
+//   producer (sensor  thread ϳ) : Push -> sensor  TSpscQueue (lock ,   )
+//   consumer (thread ϳ) : PopFusedFrame / Poll -> sensor  History -> tick  fusion -> CBVH::Begin/Add*Value/End
+// tick T  fusion : sensor  T  ̿   sample ( |t - T| <= AlignWindow)  T   (position lerp, quaternion slerp) ϰ
+// (ʸ   sample), joint  sensor Weight * TrackingState ġ position   , quaternion  ȣ    ȭѴ.
+// 0 quaternion  (Kinect  ȸ   joint) .
+// tick T    ִ sensor  T  sample  °ų,  ռ sensor  T + MaxLatency   .
+// ޸𸮴 sensor  QueueCapacity + HistoryCapacity frame  ȴ.
+class CMultiSensorFusion
+{
+	struct FSensorSample
+	{
+		sKinectFrame Frame;
+		BYTE TrackingState[JointType_Count];
+	};
+
+	struct FSensor
+	{
+		FSensorOptions Options;
+		TSpscQueue<FSensorSample> Queue;
+
+		std::atomic<bool> bClosed;
+		std::atomic<ULONGLONG> PushedFrameCount;
+		std::atomic<ULONGLONG> DroppedFrameCount;
+
+		// consumer  
+		std::vector<FSensorSample> History;		// HistoryCapacity  ring,  ð  timestamp 
+		std::vector<bool> HistoryUsed;
+		size_t HistoryHead;
+		size_t HistoryCount;
+		DWORD LatestTime;
+		bool bHasSample;
+		bool bFinished;							// Close Ǿ queue  .
+		ULONGLONG LateFrameCount;
+		ULONGLONG UsedFrameCount;
+
+		FSensor(const FSensorOptions& inOptions, const FMultiSensorFusionOptions& inFusionOptions);
+	};
+
+	// sample ϳ JointType  ģ . weight  0 ̸  joint
+	struct FSensorJointValues
+	{
+		XMVECTOR Position[JointType_Count];
+		XMVECTOR Quat[JointType_Count];
+		float PositionWeight[JointType_Count];
+		float QuatWeight[JointType_Count];
+	};
+
+	FMultiSensorFusionOptions Options;
+	std::vector<std::unique_ptr<FSensor>> Sensors;
+
+	bool bStarted;
+	DWORD BeginTime;
+	ULONGLONG TickIndex;
+
+	CMultiSensorFusion(const CMultiSensorFusion&) = delete;
+	CMultiSensorFusion& operator=(const CMultiSensorFusion&) = delete;
+
+	DWORD GetTickTime(ULONGLONG inTickIndex) const;
+
+	void PullSensorQueues();
+	bool IsTickReady(DWORD inTickTime) const;
+	void GatherJointValues(FSensor& ioSensor, size_t inSlot, FSensorJointValues& outValues);
+	void FuseTick(DWORD inTickTime, sKinectFrame& outFrame);
+	void DiscardHistory(DWORD inNextTickTime);
+
+public:
+	explicit CMultiSensorFusion(const FMultiSensorFusionOptions& inOptions = FMultiSensorFusionOptions());
+
+	// producer thread  ϱ  sensor  Ѵ. ȯ : sensor index
+	int AddSensor(const FSensorOptions& inOptions = FSensorOptions());
+
+	int GetSensorCount() const { return (int)Sensors.size(); }
+
+	// producer thread (sensor  ϳ)  ȣ. ٸų Ҵ ʴ´.
+	// inTrackingStates : JointType  (JointType_Count ). nullptr ̸  Tracked
+	// queue     false
+	bool Push(int inSensorIndex, const sKinectFrame& inFrame, const TrackingState* inTrackingStates = nullptr);
+
+	// sensor  Է . (  sensor  ٸ ʴ´)
+	void Close(int inSensorIndex);
+
+	// consumer thread  ȣ.  tick  fused frame  غǾ outFrame  ä true
+	bool PopFusedFrame(sKinectFrame& outFrame);
+
+	// غ fused frame   outBVH  ִ´. ȯ :  frame 
+	size_t Poll(CBVH& outBVH);
+
+	//  sensor  Close ǰ  frame   fusion Ǿ.
+	bool IsFinished() const;
+
+	// consumer thread  ȣ
+	FMultiSensorStats GetStats(int inSensorIndex) const;
+};
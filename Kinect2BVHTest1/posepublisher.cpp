@@ -0,0 +1,250 @@
+#include "stdafx.h"
+
+#include <string.h>
+#include <new>
+
+#include "posepublisher.h"
+#include "bvhexport.h"
+
+static const DWORD SHARED_POSE_MAGIC = 0x534f504b;		// "KPOS"
+static const DWORD SHARED_POSE_VERSION = 1;
+
+static_assert(sizeof(std::atomic<ULONGLONG>) == sizeof(ULONGLONG), "shared pose layout");
+
+static size_t GetSlotSize(int inJointCount)
+{
+	return sizeof(FSharedPoseSlotHeader) + sizeof(FSharedPoseJoint) * inJointCount;
+}
+
+static size_t GetSlotOffset(int inJointCount, int inSlotIndex)
+{
+	return sizeof(FSharedPoseHeader) + sizeof(FSharedPoseJointInfo) * inJointCount + GetSlotSize(inJointCount) * inSlotIndex;
+}
+
+CPosePublisher::CPosePublisher() : MappingHandle(nullptr), Data(nullptr), Header(nullptr), FrameCount(0)
+{
+}
+
+CPosePublisher::~CPosePublisher()
+{
+	Close();
+}
+
+bool CPosePublisher::Create(const std::string & inName, const CBVH & inSkeleton, int inSlotCount)
+{
+	Close();
+
+	const int jointCount = inSkeleton.GetJointCount();
+	if (jointCount <= 0 || inSlotCount < 2)
+		return false;
+
+	const auto& sortedJoints = inSkeleton.GetSortedJointArray();
+
+	// ߸ ̸ subscriber  joint  ߸ ã ϹǷ mapping    
+	for (int j = 0; j < jointCount; ++j)
+	{
+		if (sortedJoints[j]->JointName.size() >= sizeof(FSharedPoseJointInfo::Name))
+			return false;
+	}
+
+	const size_t size = GetSlotOffset(jointCount, inSlotCount);
+
+	MappingHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)size, inName.c_str());
+	if (MappingHandle == nullptr)
+		return false;
+
+	//  ̸ mapping    ٸ publisher  subscriber    ̹Ƿ  ʴ´.
+	if (GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		Close();
+		return false;
+	}
+
+	Data = (char*)MapViewOfFile(MappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (Data == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	//   mapping  0  ä ִ. subscriber   ä header   ʵ Magic   
+	FSharedPoseHeader* header = (FSharedPoseHeader*)Data;
+	new (&header->PublishedCount) std::atomic<ULONGLONG>(0);
+
+	header->Version = SHARED_POSE_VERSION;
+	header->JointCount = (DWORD)jointCount;
+	header->SlotCount = (DWORD)inSlotCount;
+	header->FrameRate = (DWORD)inSkeleton.GetExportFrameRate();
+	header->SlotSize = (DWORD)GetSlotSize(jointCount);
+
+	FSharedPoseJointInfo* jointInfos = (FSharedPoseJointInfo*)(Data + sizeof(FSharedPoseHeader));
+
+	for (int j = 0; j < jointCount; ++j)
+	{
+		const FBVHJoint* bvhJoint = sortedJoints[j];
+		auto& jointInfo = jointInfos[j];
+
+		strncpy_s(jointInfo.Name, sizeof(jointInfo.Name), bvhJoint->JointName.c_str(), _TRUNCATE);
+		jointInfo.ParentIndex = bvhJoint->ParentJoint ? bvhJoint->ParentJoint->JointIndex : -1;
+		memcpy(jointInfo.Offset, bvhJoint->Position.m128_f32, sizeof(jointInfo.Offset));
+		memcpy(jointInfo.RefQuat, bvhJoint->RefQuat.m128_f32, sizeof(jointInfo.RefQuat));
+	}
+
+	for (int slot = 0; slot < inSlotCount; ++slot)
+	{
+		FSharedPoseSlotHeader* slotHeader = (FSharedPoseSlotHeader*)(Data + GetSlotOffset(jointCount, slot));
+		new (&slotHeader->Sequence) std::atomic<ULONGLONG>(0);
+	}
+
+	std::atomic_thread_fence(std::memory_order_release);
+	header->Magic = SHARED_POSE_MAGIC;
+
+	Header = header;
+	FrameCount = 0;
+
+	return true;
+}
+
+void CPosePublisher::Close()
+{
+	Header = nullptr;
+
+	if (Data)
+	{
+		UnmapViewOfFile(Data);
+		Data = nullptr;
+	}
+
+	if (MappingHandle)
+	{
+		CloseHandle(MappingHandle);
+		MappingHandle = nullptr;
+	}
+}
+
+void CPosePublisher::Publish(DWORD inElapseTime, const FBVHJointTransform * inFrameInfo)
+{
+	if (Header == nullptr)
+		return;
+
+	const ULONGLONG frameIndex = FrameCount;
+	const int jointCount = (int)Header->JointCount;
+
+	char* slot = Data + GetSlotOffset(jointCount, (int)(frameIndex % Header->SlotCount));
+	FSharedPoseSlotHeader* slotHeader = (FSharedPoseSlotHeader*)slot;
+	FSharedPoseJoint* joints = (FSharedPoseJoint*)(slot + sizeof(FSharedPoseSlotHeader));
+
+	// Ȧ :  
+	slotHeader->Sequence.store(frameIndex * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slotHeader->FrameIndex = frameIndex;
+	slotHeader->ElapseTime = inElapseTime;
+
+	for (int j = 0; j < jointCount; ++j)
+	{
+		memcpy(joints[j].LocalQuat, inFrameInfo[j].LocalQuat.m128_f32, sizeof(joints[j].LocalQuat));
+	}
+
+	slotHeader->Sequence.store(frameIndex * 2 + 2, std::memory_order_release);
+	Header->PublishedCount.store(frameIndex + 1, std::memory_order_release);
+
+	++FrameCount;
+}
+
+CPoseSubscriber::CPoseSubscriber() : MappingHandle(nullptr), Data(nullptr), Header(nullptr)
+{
+}
+
+CPoseSubscriber::~CPoseSubscriber()
+{
+	Close();
+}
+
+bool CPoseSubscriber::Open(const std::string & inName)
+{
+	Close();
+
+	MappingHandle = OpenFileMappingA(FILE_MAP_READ, FALSE, inName.c_str());
+	if (MappingHandle == nullptr)
+		return false;
+
+	Data = (const char*)MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (Data == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	const FSharedPoseHeader* header = (const FSharedPoseHeader*)Data;
+	if (header->Magic != SHARED_POSE_MAGIC || header->Version != SHARED_POSE_VERSION)
+	{
+		Close();
+		return false;
+	}
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	Header = header;
+
+	return true;
+}
+
+void CPoseSubscriber::Close()
+{
+	Header = nullptr;
+
+	if (Data)
+	{
+		UnmapViewOfFile(Data);
+		Data = nullptr;
+	}
+
+	if (MappingHandle)
+	{
+		CloseHandle(MappingHandle);
+		MappingHandle = nullptr;
+	}
+}
+
+const FSharedPoseJointInfo & CPoseSubscriber::GetJointInfo(int inJointIndex) const
+{
+	const FSharedPoseJointInfo* jointInfos = (const FSharedPoseJointInfo*)(Data + sizeof(FSharedPoseHeader));
+	return jointInfos[inJointIndex];
+}
+
+bool CPoseSubscriber::ReadLatest(ULONGLONG & outFrameIndex, DWORD & outElapseTime, FSharedPoseJoint * outJoints) const
+{
+	if (Header == nullptr)
+		return false;
+
+	const int jointCount = (int)Header->JointCount;
+
+	for (int retry = 0; retry < MAX_READ_RETRY; ++retry)
+	{
+		const ULONGLONG publishedCount = Header->PublishedCount.load(std::memory_order_acquire);
+		if (publishedCount == 0)
+			return false;
+
+		const ULONGLONG frameIndex = publishedCount - 1;
+
+		const char* slot = Data + GetSlotOffset(jointCount, (int)(frameIndex % Header->SlotCount));
+		const FSharedPoseSlotHeader* slotHeader = (const FSharedPoseSlotHeader*)slot;
+
+		//   writer   slot  ٽ   ֽ frame  ٽ
+		const ULONGLONG sequence = slotHeader->Sequence.load(std::memory_order_acquire);
+		if (sequence != frameIndex * 2 + 2)
+			continue;
+
+		outFrameIndex = slotHeader->FrameIndex;
+		outElapseTime = slotHeader->ElapseTime;
+		memcpy(outJoints, slot + sizeof(FSharedPoseSlotHeader), sizeof(FSharedPoseJoint) * jointCount);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (slotHeader->Sequence.load(std::memory_order_relaxed) == sequence)
+			return true;
+	}
+
+	return false;
+}
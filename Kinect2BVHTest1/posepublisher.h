@@ -0,0 +1,111 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+
+class CBVH;
+struct FBVHJointTransform;
+
+//  ޸ pose buffer layout ( build  publisher/subscriber  )
+//   FSharedPoseHeader
+//   FSharedPoseJointInfo[JointCount]		: skeleton (Create     )
+//   slot[SlotCount]						: FSharedPoseSlotHeader + FSharedPoseJoint[JointCount]
+//
+// frame n  slot n % SlotCount  . slot  seqlock :
+//  ߿ Sequence = 2n + 1,   2n + 2.   PublishedCount = n + 1
+// reader  ֽ slot    Sequence  ״ ȮѴ.
+// writer   ߿ SlotCount  ƾ 浹ϹǷ reader  ǻ õ ʰ, writer  reader  ٸ ʴ´.
+struct FSharedPoseHeader
+{
+	DWORD Magic;
+	DWORD Version;
+	DWORD JointCount;
+	DWORD SlotCount;
+	DWORD FrameRate;
+	DWORD SlotSize;								// byte
+	std::atomic<ULONGLONG> PublishedCount;		// ϼ frame  (ֽ frame ȣ + 1)
+};
+
+struct FSharedPoseJointInfo
+{
+	char Name[32];
+	int ParentIndex;							// -1 : root
+	float Offset[3];							// BVH OFFSET
+	float RefQuat[4];
+};
+
+struct FSharedPoseSlotHeader
+{
+	std::atomic<ULONGLONG> Sequence;
+	ULONGLONG FrameIndex;
+	DWORD ElapseTime;							// milliseconds (capture timestamp)
+	DWORD Reserved;
+};
+
+struct FSharedPoseJoint
+{
+	float LocalQuat[4];							// parent  ȸ (SortedJointArray )
+};
+
+// CBVH  resampling  frame  ̸ ִ  ޸𸮿 ø.
+class CPosePublisher
+{
+	HANDLE MappingHandle;
+	char* Data;
+
+	FSharedPoseHeader* Header;
+	ULONGLONG FrameCount;
+
+	CPosePublisher(const CPosePublisher&) = delete;
+	CPosePublisher& operator=(const CPosePublisher&) = delete;
+
+public:
+	static const int DEFAULT_SLOT_COUNT = 4;
+
+	CPosePublisher();
+	~CPosePublisher();
+
+	// inName : CreateFileMapping ̸ ( "Local\\KinectPose")
+	// joint ̸ FSharedPoseJointInfo::Name    (31  ʰ) false
+	//  ̸ mapping  ̹  (ٸ publisher   ִ subscriber) false
+	bool Create(const std::string& inName, const CBVH& inSkeleton, int inSlotCount = DEFAULT_SLOT_COUNT);
+	void Close();
+
+	bool IsOpen() const { return Header != nullptr; }
+
+	// inFrameInfo : JointCount  (LocalQuat  ). ٸų Ҵ ʴ´.
+	void Publish(DWORD inElapseTime, const FBVHJointTransform* inFrameInfo);
+
+	ULONGLONG GetPublishedCount() const { return FrameCount; }
+};
+
+//  process Ǵ ٸ process  ֽ pose  д´.
+class CPoseSubscriber
+{
+	HANDLE MappingHandle;
+	const char* Data;
+
+	const FSharedPoseHeader* Header;
+
+	CPoseSubscriber(const CPoseSubscriber&) = delete;
+	CPoseSubscriber& operator=(const CPoseSubscriber&) = delete;
+
+public:
+	static const int MAX_READ_RETRY = 8;
+
+	CPoseSubscriber();
+	~CPoseSubscriber();
+
+	bool Open(const std::string& inName);
+	void Close();
+
+	bool IsOpen() const { return Header != nullptr; }
+
+	int GetJointCount() const { return Header ? (int)Header->JointCount : 0; }
+	int GetFrameRate() const { return Header ? (int)Header->FrameRate : 0; }
+	const FSharedPoseJointInfo& GetJointInfo(int inJointIndex) const;
+
+	//  ֱٿ ϼ frame  outJoints (JointCount )  
+	//  frame  ų, MAX_READ_RETRY   writer  ġ false
+	bool ReadLatest(ULONGLONG& outFrameIndex, DWORD& outElapseTime, FSharedPoseJoint* outJoints) const;
+};
@@ -41,29 +41,139 @@ struct Quaternion {
 
 };
 
+// float tier  (ȭ ȣϴ ʿ)
+struct QuaternionF {
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
 ///////////////////////////////
 // Quaternion to Euler
 ///////////////////////////////
-enum RotSeq { zyx, zyz, zxy, zxz, yxz, yxy, yzx, yzy, xyz, xyx, xzy, xzx };
+enum RotSeq : int { zyx, zyz, zxy, zxz, yxz, yxy, yzx, yzy, xyz, xyx, xzy, xzx };
+
+///////////////////////////////
+// е tier : quaternion2Euler   scalar  ﰢԼ 
+// ִ  exact  ȸ   (EULER_PRECISION_MAX_ERROR, MeasureEulerPrecisionError)
+///////////////////////////////
+enum EEulerPrecision : int
+{
+	EEulerPrecision_Exact,			// double + libm ()
+	EEulerPrecision_Float,			// float + libm
+	EEulerPrecision_Fast,			// float + ׽ ٻ atan2/asin/acos
+	EEulerPrecision_Count,
+};
+
+struct FEulerMathExact
+{
+	typedef double Scalar;
+
+	static double Sqrt(double inValue) { return std::sqrt(inValue); }
+	static double Atan2(double inY, double inX) { return atan2(inY, inX); }
+	static double Asin(double inValue) { return asin(inValue); }
+	static double Acos(double inValue) { return acos(inValue); }
+
+	static bool IsNearSingular(double) { return false; }
+};
+
+struct FEulerMathFloat
+{
+	typedef float Scalar;
+
+	static float Sqrt(float inValue) { return std::sqrt(inValue); }
+	static float Atan2(float inY, float inX) { return std::atan2(inY, inX); }
+
+	// float   ȸ   1  ¦   ִ.
+	static float Asin(float inValue) { return std::asin(inValue > 1.0f ? 1.0f : (inValue < -1.0f ? -1.0f : inValue)); }
+	static float Acos(float inValue) { return std::acos(inValue > 1.0f ? 1.0f : (inValue < -1.0f ? -1.0f : inValue)); }
+
+	// gimbal lock ó ù°/°  ϴ    0   float    Ŀ.
+	//   ȣϴ ʿ exact  ٽ Ѵ. (zyx  +-90    |r21| > 0.998  )
+	static bool IsNearSingular(float inR21) { return std::fabs(inR21) > 0.997f; }
+};
+
+// sqrt   ϳ (sqrtss) ̹Ƿ ٻ ʴ´.
+struct FEulerMathFast
+{
+	typedef float Scalar;
+
+	static float Sqrt(float inValue) { return std::sqrt(inValue); }
+
+	static bool IsNearSingular(float inR21) { return FEulerMathFloat::IsNearSingular(inR21); }
+
+	// [0, 1]  atan  11  minimax ׽ + 8 и 
+	static float Atan2(float inY, float inX)
+	{
+		const float absX = std::fabs(inX);
+		const float absY = std::fabs(inY);
+
+		const float maxValue = absX > absY ? absX : absY;
+		if (maxValue == 0.0f)
+			return 0.0f;
+
+		const float a = (absX > absY ? absY : absX) / maxValue;
+		const float s = a*a;
+
+		float result = (((((-0.01172120f*s + 0.05265332f)*s - 0.11643287f)*s + 0.19354346f)*s - 0.33262347f)*s + 0.99997726f)*a;
+
+		if (absY > absX)
+			result = XM_PIDIV2 - result;
+		if (inX < 0.0f)
+			result = XM_PI - result;
+
+		return inY < 0.0f ? -result : result;
+	}
+
+	// acos(a) = sqrt(1 - a)*p(a), 0 <= a <= 1 (Abramowitz & Stegun 4.4.46)
+	static float AcosPositive(float inValue)
+	{
+		const float a = inValue > 1.0f ? 1.0f : inValue;
+		const float p = ((((((-0.0012624911f*a + 0.0066700901f)*a - 0.0170881256f)*a + 0.0308918810f)*a - 0.0501743046f)*a + 0.0889789874f)*a - 0.2145988016f)*a + 1.5707963050f;
 
-void twoaxisrot(double r11, double r12, double r21, double r31, double r32, double res[]) {
-	res[0] = atan2(r11, r12);
-	res[1] = acos(r21);
-	res[2] = atan2(r31, r32);
+		return std::sqrt(1.0f - a)*p;
+	}
+
+	static float Acos(float inValue)
+	{
+		return inValue >= 0.0f ? AcosPositive(inValue) : XM_PI - AcosPositive(-inValue);
+	}
+
+	static float Asin(float inValue)
+	{
+		return inValue >= 0.0f ? XM_PIDIV2 - AcosPositive(inValue) : AcosPositive(-inValue) - XM_PIDIV2;
+	}
+};
+
+// ȯ : TMath::IsNearSingular ̸ false
+template<typename TMath>
+inline bool twoaxisrot(typename TMath::Scalar r11, typename TMath::Scalar r12, typename TMath::Scalar r21, typename TMath::Scalar r31, typename TMath::Scalar r32, typename TMath::Scalar res[]) {
+	res[0] = TMath::Atan2(r11, r12);
+	res[1] = TMath::Acos(r21);
+	res[2] = TMath::Atan2(r31, r32);
+	return !TMath::IsNearSingular(r21);
 }
 
-void threeaxisrot(double r11, double r12, double r21, double r31, double r32, double res[]) {
-	res[0] = atan2(r31, r32);
-	res[1] = asin(r21);
-	res[2] = atan2(r11, r12);
+template<typename TMath>
+inline bool threeaxisrot(typename TMath::Scalar r11, typename TMath::Scalar r12, typename TMath::Scalar r21, typename TMath::Scalar r31, typename TMath::Scalar r32, typename TMath::Scalar res[]) {
+	res[0] = TMath::Atan2(r31, r32);
+	res[1] = TMath::Asin(r21);
+	res[2] = TMath::Atan2(r11, r12);
+	return !TMath::IsNearSingular(r21);
 }
 
-void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
+// TQuat : x, y, z, w  TMath::Scalar  ȭ quaternion (Quaternion, QuaternionF)
+// ȯ false ̸ gimbal lock ó  tier δ  ũ. (exact  ׻ true)
+template<typename TMath, typename TQuat>
+inline bool quaternion2Euler(const TQuat& q, typename TMath::Scalar res[], RotSeq rotSeq)
 {
+	bool bResult = true;
+
 	switch (rotSeq) {
 	case zyx:
 	{
-		threeaxisrot(2 * (q.x*q.y + q.w*q.z),
+		bResult = threeaxisrot<TMath>(2 * (q.x*q.y + q.w*q.z),
 			q.w*q.w + q.x*q.x - q.y*q.y - q.z*q.z,
 			-2 * (q.x*q.z - q.w*q.y),
 			2 * (q.y*q.z + q.w*q.x),
@@ -88,7 +198,7 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		break;
 	}
 	case zyz:
-		twoaxisrot(2 * (q.y*q.z - q.w*q.x),
+		bResult = twoaxisrot<TMath>(2 * (q.y*q.z - q.w*q.x),
 			2 * (q.x*q.z + q.w*q.y),
 			q.w*q.w - q.x*q.x - q.y*q.y + q.z*q.z,
 			2 * (q.y*q.z + q.w*q.x),
@@ -97,7 +207,7 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		break;
 
 	case zxy:
-		threeaxisrot(-2 * (q.x*q.y - q.w*q.z),
+		bResult = threeaxisrot<TMath>(-2 * (q.x*q.y - q.w*q.z),
 			q.w*q.w - q.x*q.x + q.y*q.y - q.z*q.z,
 			2 * (q.y*q.z + q.w*q.x),
 			-2 * (q.x*q.z - q.w*q.y),
@@ -106,7 +216,7 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		break;
 
 	case zxz:
-		twoaxisrot(2 * (q.x*q.z + q.w*q.y),
+		bResult = twoaxisrot<TMath>(2 * (q.x*q.z + q.w*q.y),
 			-2 * (q.y*q.z - q.w*q.x),
 			q.w*q.w - q.x*q.x - q.y*q.y + q.z*q.z,
 			2 * (q.x*q.z - q.w*q.y),
@@ -115,7 +225,7 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		break;
 
 	case yxz:
-		threeaxisrot(2 * (q.x*q.z + q.w*q.y),
+		bResult = threeaxisrot<TMath>(2 * (q.x*q.z + q.w*q.y),
 			q.w*q.w - q.x*q.x - q.y*q.y + q.z*q.z,
 			-2 * (q.y*q.z - q.w*q.x),
 			2 * (q.x*q.y + q.w*q.z),
@@ -124,7 +234,7 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		break;
 
 	case yxy:
-		twoaxisrot(2 * (q.x*q.y - q.w*q.z),
+		bResult = twoaxisrot<TMath>(2 * (q.x*q.y - q.w*q.z),
 			2 * (q.y*q.z + q.w*q.x),
 			q.w*q.w - q.x*q.x + q.y*q.y - q.z*q.z,
 			2 * (q.x*q.y + q.w*q.z),
@@ -133,7 +243,7 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		break;
 
 	case yzx:
-		threeaxisrot(-2 * (q.x*q.z - q.w*q.y),
+		bResult = threeaxisrot<TMath>(-2 * (q.x*q.z - q.w*q.y),
 			q.w*q.w + q.x*q.x - q.y*q.y - q.z*q.z,
 			2 * (q.x*q.y + q.w*q.z),
 			-2 * (q.y*q.z - q.w*q.x),
@@ -142,7 +252,7 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		break;
 
 	case yzy:
-		twoaxisrot(2 * (q.y*q.z + q.w*q.x),
+		bResult = twoaxisrot<TMath>(2 * (q.y*q.z + q.w*q.x),
 			-2 * (q.x*q.y - q.w*q.z),
 			q.w*q.w - q.x*q.x + q.y*q.y - q.z*q.z,
 			2 * (q.y*q.z - q.w*q.x),
@@ -151,7 +261,7 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		break;
 
 	case xyz:
-		threeaxisrot(-2 * (q.y*q.z - q.w*q.x),
+		bResult = threeaxisrot<TMath>(-2 * (q.y*q.z - q.w*q.x),
 			q.w*q.w - q.x*q.x - q.y*q.y + q.z*q.z,
 			2 * (q.x*q.z + q.w*q.y),
 			-2 * (q.x*q.y - q.w*q.z),
@@ -160,7 +270,7 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		break;
 
 	case xyx:
-		twoaxisrot(2 * (q.x*q.y + q.w*q.z),
+		bResult = twoaxisrot<TMath>(2 * (q.x*q.y + q.w*q.z),
 			-2 * (q.x*q.z - q.w*q.y),
 			q.w*q.w + q.x*q.x - q.y*q.y - q.z*q.z,
 			2 * (q.x*q.y - q.w*q.z),
@@ -169,7 +279,7 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		break;
 
 	case xzy:
-		threeaxisrot(2 * (q.y*q.z + q.w*q.x),
+		bResult = threeaxisrot<TMath>(2 * (q.y*q.z + q.w*q.x),
 			q.w*q.w - q.x*q.x + q.y*q.y - q.z*q.z,
 			-2 * (q.x*q.y - q.w*q.z),
 			2 * (q.x*q.z + q.w*q.y),
@@ -178,7 +288,7 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		break;
 
 	case xzx:
-		twoaxisrot(2 * (q.x*q.z - q.w*q.y),
+		bResult = twoaxisrot<TMath>(2 * (q.x*q.z - q.w*q.y),
 			2 * (q.x*q.y + q.w*q.z),
 			q.w*q.w + q.x*q.x - q.y*q.y - q.z*q.z,
 			2 * (q.x*q.z + q.w*q.y),
@@ -189,12 +299,19 @@ void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
 		std::cout << "Unknown rotation sequence" << std::endl;
 		break;
 	}
+
+	return bResult;
+}
+
+inline void quaternion2Euler(const Quaternion& q, double res[], RotSeq rotSeq)
+{
+	quaternion2Euler<FEulerMathExact>(q, res, rotSeq);
 }
 
 ///////////////////////////////
 // Helper functions
 ///////////////////////////////
-Quaternion operator*(Quaternion& q1, Quaternion& q2) {
+inline Quaternion operator*(Quaternion& q1, Quaternion& q2) {
 	Quaternion q;
 	q.w = q1.w*q2.w - q1.x*q2.x - q1.y*q2.y - q1.z*q2.z;
 	q.x = q1.w*q2.x + q1.x*q2.w + q1.y*q2.z - q1.z*q2.y;
@@ -208,7 +325,7 @@ Quaternion operator*(Quaternion& q1, Quaternion& q2) {
 //	cout << noshowpos;
 //}
 
-double rad2deg(double rad) {
+inline double rad2deg(double rad) {
 	return rad*180.0 / XM_PI;
 }
 
@@ -0,0 +1,263 @@
+#include "stdafx.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "rawframestore.h"
+#include "bvhexport.h"
+
+CRawFrameStore::CRawFrameStore(CBVHArena & inArena) : Arena(inArena), Slots(inArena), JointCount(0), MemoryBudget(0), SlotCapacity(0), FrameCount(0), SpilledCount(0), MappedCount(0)
+{
+}
+
+CRawFrameStore::~CRawFrameStore()
+{
+	SpillReader.Close();
+	SpillWriter.close();
+
+	if (!SpillFileName.empty())
+	{
+		DeleteFileA(SpillFileName.c_str());
+	}
+}
+
+size_t CRawFrameStore::GetRecordSize() const
+{
+	return sizeof(DWORD) + sizeof(float) * 3 + JointCount * sizeof(float) * 4;
+}
+
+void CRawFrameStore::UpdateCapacity(int inJointCount)
+{
+	JointCount = inJointCount;
+	SlotCapacity = 0;
+
+	if (MemoryBudget > 0)
+	{
+		const size_t frameSize = sizeof(FRawBVHFrame) + sizeof(FBVHJointTransform) * JointCount;
+
+		//  frame    frame  ׻ ޸𸮿 ־ Ѵ.
+		SlotCapacity = MemoryBudget / frameSize;
+		if (SlotCapacity < 2)
+			SlotCapacity = 2;
+	}
+
+	RecordBuffer.resize(GetRecordSize());
+}
+
+bool CRawFrameStore::SetMemoryBudget(size_t inBudget, const std::string & inSpillFileName)
+{
+	if (FrameCount > 0)
+		return false;
+
+	if (inBudget > 0 && inSpillFileName.empty())
+		return false;
+
+	SpillReader.Close();
+	SpillWriter.close();
+
+	if (!SpillFileName.empty())
+	{
+		DeleteFileA(SpillFileName.c_str());
+	}
+
+	MemoryBudget = inBudget;
+	SpillFileName = inBudget > 0 ? inSpillFileName : std::string();
+
+	// capture ߿     ̸  д.
+	if (!SpillFileName.empty())
+	{
+		SpillWriter.open(SpillFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!SpillWriter.good())
+		{
+			MemoryBudget = 0;
+			SpillFileName.clear();
+			return false;
+		}
+	}
+
+	// slot  꿡  ٽ  .
+	Slots.clear();
+
+	return true;
+}
+
+void CRawFrameStore::Reserve(size_t inFrameCount, int inJointCount)
+{
+	if (FrameCount == 0)
+		UpdateCapacity(inJointCount);
+
+	//   ring ũ ̻ slot  ʿ .
+	size_t slotCount = FrameCount + inFrameCount;
+	if (SlotCapacity != 0 && slotCount > SlotCapacity)
+		slotCount = SlotCapacity;
+
+	if (slotCount <= Slots.size())
+		return;
+
+	const size_t frameInfoSize = sizeof(FBVHJointTransform) * JointCount + alignof(FBVHJointTransform);
+
+	// chunk       FrameInfo 뷮 
+	size_t newSlotCount = slotCount - Slots.size();
+
+	Slots.reserve(slotCount);
+	Arena.Reserve(newSlotCount * frameInfoSize, frameInfoSize);
+}
+
+FRawBVHFrame & CRawFrameStore::Add(DWORD inElapseTime, int inJointCount)
+{
+	if (FrameCount == 0)
+		UpdateCapacity(inJointCount);
+
+	assert(inJointCount == JointCount);
+	assert(!IsFull());
+
+	FRawBVHFrame* frame = nullptr;
+
+	size_t slotIndex = GetSlotIndex(FrameCount);
+	if (slotIndex < Slots.size())
+	{
+		// Ϸ  frame  ڸ 
+		frame = &Slots[slotIndex];
+
+		for (auto& value : frame->FrameInfo)
+		{
+			value = FBVHJointTransform();
+		}
+	}
+	else
+	{
+		frame = &Slots.AddDefaulted();
+		frame->FrameInfo = Arena.AllocateArray<FBVHJointTransform>(JointCount);
+	}
+
+	frame->ElapseTime = inElapseTime;
+	++FrameCount;
+
+	return *frame;
+}
+
+bool CRawFrameStore::SpillOldest()
+{
+	if (SpillFileName.empty() || SpilledCount == FrameCount)
+		return false;
+
+	const auto& frame = Slots[GetSlotIndex(SpilledCount)];
+
+	char* record = RecordBuffer.data();
+
+	memcpy(record, &frame.ElapseTime, sizeof(DWORD));
+	record += sizeof(DWORD);
+
+	// root translation 
+	memcpy(record, frame.FrameInfo[0].Position.m128_f32, sizeof(float) * 3);
+	record += sizeof(float) * 3;
+
+	for (int j = 0; j < JointCount; ++j)
+	{
+		memcpy(record, frame.FrameInfo[j].LocalQuat.m128_f32, sizeof(float) * 4);
+		record += sizeof(float) * 4;
+	}
+
+	// export ߿ mapping ߴ ̸ ٽ   ݴ´.
+	if (SpillReader.IsOpen())
+	{
+		SpillReader.Close();
+	}
+
+	if (!SpillWriter.is_open())
+	{
+		SpillWriter.open(SpillFileName.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+	}
+
+	// buffer   θ ߿ Ⱑ   ̹ SpilledCount   frame  Ƿ frame  .
+	SpillWriter.write(RecordBuffer.data(), RecordBuffer.size());
+	SpillWriter.flush();
+	if (!SpillWriter.good())
+		return false;
+
+	++SpilledCount;
+
+	return true;
+}
+
+bool CRawFrameStore::MapSpillFile() const
+{
+	//   flush ϰ ݾƾ mapping   ִ.
+	if (SpillWriter.is_open())
+	{
+		SpillWriter.close();
+	}
+
+	if (!SpillReader.Open(SpillFileName))
+		return false;
+
+	if (SpillReader.GetSize() < SpilledCount * GetRecordSize())
+	{
+		SpillReader.Close();
+		return false;
+	}
+
+	MappedCount = SpilledCount;
+
+	return true;
+}
+
+const FRawBVHFrame & CRawFrameStore::GetFrame(size_t inIndex) const
+{
+	if (inIndex >= SpilledCount)
+		return Slots[GetSlotIndex(inIndex)];
+
+	if (SpillFrames.empty())
+	{
+		SpillFrames = Arena.AllocateArray<FRawBVHFrame>(2);
+
+		for (auto& value : SpillFrames)
+		{
+			value.FrameInfo = Arena.AllocateArray<FBVHJointTransform>(JointCount);
+		}
+	}
+
+	FRawBVHFrame& frame = SpillFrames[inIndex % 2];
+
+	if ((!SpillReader.IsOpen() || MappedCount != SpilledCount) && !MapSpillFile())
+	{
+		assert(false);
+		return frame;
+	}
+
+	const char* record = SpillReader.GetData() + inIndex * GetRecordSize();
+
+	memcpy(&frame.ElapseTime, record, sizeof(DWORD));
+	record += sizeof(DWORD);
+
+	memcpy(frame.FrameInfo[0].Position.m128_f32, record, sizeof(float) * 3);
+	record += sizeof(float) * 3;
+
+	for (int j = 0; j < JointCount; ++j)
+	{
+		memcpy(frame.FrameInfo[j].LocalQuat.m128_f32, record, sizeof(float) * 4);
+		record += sizeof(float) * 4;
+	}
+
+	return frame;
+}
+
+void CRawFrameStore::Clear()
+{
+	Slots.clear();
+
+	FrameCount = 0;
+	SpilledCount = 0;
+	MappedCount = 0;
+	SlotCapacity = 0;
+
+	SpillFrames = TBVHArray<FRawBVHFrame>();
+
+	SpillReader.Close();
+	SpillWriter.close();
+
+	if (!SpillFileName.empty())
+	{
+		SpillWriter.open(SpillFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	}
+}
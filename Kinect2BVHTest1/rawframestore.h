@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+
+#include "bvharena.h"
+#include "mappedfile.h"
+
+struct FRawBVHFrame;
+
+// CBVH  RawFrames 
+// memory    frame  arena  д.
+//    ȿ  frame  ring  ϰ,   frame 
+// (local rotation  Ǭ ) append-only ӽ Ϸ .  frame  export   mapping ؼ  д´.
+//
+// ӽ  record : DWORD ElapseTime + float root Position[3] + joint  float LocalQuat[4] (packed)
+class CRawFrameStore
+{
+	CBVHArena& Arena;
+
+	TBVHChunkedArray<FRawBVHFrame> Slots;		// ޸𸮿 ִ frame (  ring)
+
+	int JointCount;
+
+	size_t MemoryBudget;					// byte, 0 ̸  
+	size_t SlotCapacity;					// 0 ̸  
+
+	size_t FrameCount;						// ü frame 
+	size_t SpilledCount;					// Ϸ  frame  (index 0 )
+
+	std::string SpillFileName;
+	std::vector<char> RecordBuffer;
+
+	//  frame     (GetFrame  const ̹Ƿ mutable)
+	mutable std::ofstream SpillWriter;
+	mutable CMappedFile SpillReader;
+	mutable size_t MappedCount;
+	mutable TBVHArray<FRawBVHFrame> SpillFrames;	// о  frame (ӵ  frame  ÿ   ֵ 2)
+
+	size_t GetRecordSize() const;
+	size_t GetSlotIndex(size_t inIndex) const { return SlotCapacity ? inIndex % SlotCapacity : inIndex; }
+
+	void UpdateCapacity(int inJointCount);
+	bool MapSpillFile() const;
+
+	CRawFrameStore(const CRawFrameStore&) = delete;
+	CRawFrameStore& operator=(const CRawFrameStore&) = delete;
+
+public:
+	explicit CRawFrameStore(CBVHArena& inArena);
+	~CRawFrameStore();
+
+	// frame    ٲ  ִ. inBudget  0 ̸  
+	bool SetMemoryBudget(size_t inBudget, const std::string& inSpillFileName);
+	size_t GetMemoryBudget() const { return MemoryBudget; }
+
+	// inFrameCount  (  ring ũ)  heap Ҵ  ߰  ֵ غ
+	void Reserve(size_t inFrameCount, int inJointCount);
+
+	// 0  ʱȭ FrameInfo    frame.   IsFull    SpillOldest ؾ Ѵ.
+	FRawBVHFrame& Add(DWORD inElapseTime, int inJointCount);
+
+	bool IsFull() const { return SlotCapacity != 0 && FrameCount - SpilledCount >= SlotCapacity; }
+
+	//   (޸𸮿 ִ) frame. local rotation  Ǭ  SpillOldest  .
+	FRawBVHFrame& GetOldestResident() { return Slots[GetSlotIndex(SpilledCount)]; }
+	bool SpillOldest();
+
+	size_t size() const { return FrameCount; }
+	size_t GetSpilledCount() const { return SpilledCount; }
+
+	// ޸𸮿 ִ frame (inIndex >= GetSpilledCount())
+	FRawBVHFrame& GetResident(size_t inIndex) { return Slots[GetSlotIndex(inIndex)]; }
+
+	//  frame  LocalQuat, root (index 0)  Position  ElapseTime  ȴ.
+	//  frame  ȯ ¦/Ȧ  index  ٽ GetFrame ϱ  ȿϴ. (i, i + 1    resampling )
+	const FRawBVHFrame& GetFrame(size_t inIndex) const;
+
+	// frame   . arena  Reset  ȣ ʿ Ѵ.
+	void Clear();
+};
@@ -0,0 +1,193 @@
+#include "stdafx.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "replaysimulator.h"
+#include "capturereader.h"
+#include "bvhexport.h"
+
+static double GetPercentile(const std::vector<float>& inSortedValues, double inRatio)
+{
+	if (inSortedValues.empty())
+		return 0.0;
+
+	size_t index = (size_t)(inRatio * (double)(inSortedValues.size() - 1) + 0.5);
+	return inSortedValues[index];
+}
+
+CKinectReplaySimulator::CKinectReplaySimulator(const std::vector<sKinectFrame>& inFrames) : Frames(inFrames)
+{
+}
+
+bool CKinectReplaySimulator::Run(const std::string & inRefPoseFileName, const FReplaySimulatorOptions & inOptions, FReplaySimulatorReport & outReport) const
+{
+	outReport = FReplaySimulatorReport();
+
+	if (Frames.size() < 2 || inOptions.BodyCount <= 0 || inOptions.RepeatCount <= 0)
+		return false;
+
+	const size_t frameCount = Frames.size();
+	const size_t totalFrameCount = frameCount * inOptions.RepeatCount;
+
+	std::vector<std::unique_ptr<CBVH>> bodies;
+	for (int body = 0; body < inOptions.BodyCount; ++body)
+	{
+		bodies.emplace_back(new CBVH());
+		bodies[body]->ImportRefPoseByBVHFile(inRefPoseFileName);
+
+		if (bodies[body]->GetJointCount() == 0)
+			return false;
+
+		bodies[body]->ReserveFrames(totalFrameCount);
+	}
+
+	// ݺ   capture ڷ ð ̾ δ.
+	const DWORD captureBeginTime = Frames.front().MilliSecond;
+	const DWORD captureLength = Frames.back().MilliSecond - captureBeginTime + 1;
+
+	std::mt19937 random(inOptions.Seed);
+	std::uniform_int_distribution<int> jitter(-inOptions.JitterMilliSeconds, inOptions.JitterMilliSeconds);
+	std::uniform_real_distribution<float> dropout(0.0f, 1.0f);
+
+	// body  ù frame  timestamp (CBVH   row ð  )
+	const DWORD INVALID_TIME = 0xffffffff;
+	std::vector<DWORD> emitBeginTimes(inOptions.BodyCount, INVALID_TIME);
+	const int frameRate = bodies.front()->GetExportFrameRate();
+
+	// row ϳ latency ϳ ( ߿ þ ʵ row ŭ)
+	const size_t rowCapacity = (size_t)((ULONGLONG)captureLength * inOptions.RepeatCount * frameRate / 1000 + 1);
+
+	std::vector<float> latencies;
+	latencies.reserve(rowCapacity * inOptions.BodyCount);
+
+	std::string rows;
+	sKinectFrame frame;
+
+	typedef std::chrono::steady_clock TClock;
+
+	const bool bPaced = inOptions.Speed > 0.0f;
+	double lastDelay = 0.0;
+
+	const TClock::time_point startTime = TClock::now();
+
+	for (int repeat = 0; repeat < inOptions.RepeatCount; ++repeat)
+	{
+		for (size_t i = 0; i < frameCount; ++i)
+		{
+			const DWORD timeStamp = Frames[i].MilliSecond + repeat * captureLength;
+
+			if (bPaced)
+			{
+				// sensor  frame   ð (ms).   
+				double delay = (double)(timeStamp - captureBeginTime) / inOptions.Speed;
+				if (inOptions.JitterMilliSeconds > 0)
+				{
+					delay += jitter(random);
+				}
+
+				delay = std::max(delay, lastDelay);
+				lastDelay = delay;
+
+				std::this_thread::sleep_until(startTime + std::chrono::microseconds((long long)(delay * 1000.0)));
+			}
+
+			const TClock::time_point deliveryTime = TClock::now();
+
+			++outReport.SensorFrameCount;
+
+			for (int body = 0; body < inOptions.BodyCount; ++body)
+			{
+				if (inOptions.DropoutRate > 0.0f && dropout(random) < inOptions.DropoutRate)
+				{
+					++outReport.DroppedBodyFrameCount;
+					continue;
+				}
+
+				// body  capture  ٸ ġ  timestamp  
+				frame = Frames[(i + body * frameCount / inOptions.BodyCount) % frameCount];
+				frame.MilliSecond = timeStamp;
+
+				CKinectCaptureReader::ReplayFrame(frame, *bodies[body]);
+				++outReport.BodyFrameCount;
+
+				if (emitBeginTimes[body] == INVALID_TIME)
+				{
+					emitBeginTimes[body] = timeStamp;
+				}
+
+				const size_t firstRow = bodies[body]->GetEmittedFrameCount();
+
+				rows.clear();
+				size_t rowCount = bodies[body]->EmitPendingMotion(rows);
+
+				if (rowCount > 0)
+				{
+					const TClock::time_point emitTime = TClock::now();
+
+					for (size_t row = firstRow; row < firstRow + rowCount; ++row)
+					{
+						float latency = 0.0f;
+
+						if (bPaced)
+						{
+							// row ð sensor sample  Ծ  ð (jitter )
+							const DWORD rowTime = emitBeginTimes[body] + (DWORD)(row * 1000 / frameRate);
+							const double sensorDelay = (double)(rowTime - captureBeginTime) / inOptions.Speed;
+
+							latency = (float)(std::chrono::duration<double, std::milli>(emitTime - startTime).count() - sensorDelay);
+						}
+						else
+						{
+							latency = std::chrono::duration<float, std::milli>(emitTime - deliveryTime).count();
+						}
+
+						latencies.push_back(latency);
+					}
+
+					outReport.RowCount += rowCount;
+				}
+			}
+		}
+	}
+
+	outReport.ElapsedSeconds = std::chrono::duration<double>(TClock::now() - startTime).count();
+
+	if (outReport.ElapsedSeconds > 0.0)
+	{
+		outReport.FramesPerSecond = outReport.SensorFrameCount / outReport.ElapsedSeconds;
+		outReport.RowsPerSecond = outReport.RowCount / outReport.ElapsedSeconds;
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+
+	outReport.LatencyP50 = GetPercentile(latencies, 0.50);
+	outReport.LatencyP99 = GetPercentile(latencies, 0.99);
+	outReport.LatencyP999 = GetPercentile(latencies, 0.999);
+	outReport.LatencyMax = latencies.empty() ? 0.0 : latencies.back();
+
+	return true;
+}
+
+std::string CKinectReplaySimulator::FormatReport(const FReplaySimulatorReport & inReport)
+{
+	char buffer[512];
+
+	snprintf(buffer, sizeof(buffer),
+		"sensor frames : %zu (body frames %zu, dropped %zu)\n"
+		"rows : %zu\n"
+		"elapsed : %.3f s\n"
+		"throughput : %.1f frames/s, %.1f rows/s\n"
+		"latency (ms) : p50 %.3f, p99 %.3f, p999 %.3f, max %.3f\n",
+		inReport.SensorFrameCount, inReport.BodyFrameCount, inReport.DroppedBodyFrameCount,
+		inReport.RowCount,
+		inReport.ElapsedSeconds,
+		inReport.FramesPerSecond, inReport.RowsPerSecond,
+		inReport.LatencyP50, inReport.LatencyP99, inReport.LatencyP999, inReport.LatencyMax);
+
+	return buffer;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+struct sKinectFrame;
+
+struct FReplaySimulatorOptions
+{
+	float Speed;					// 1 = ǽð, N = N , 0  = ٸ ʰ ִ ӵ
+	int BodyCount;					// ÿ Ǵ body  (body  capture  ٸ ġ )
+	int RepeatCount;				// capture  ̾ ٿ  Ƚ
+	int JitterMilliSeconds;			//  ð +-JitterMilliSeconds ȿ . (timestamp  ״)
+	float DropoutRate;				// body frame   Ȯ [0, 1]
+	unsigned int Seed;
+
+	FReplaySimulatorOptions() : Speed(1.0f), BodyCount(1), RepeatCount(1), JitterMilliSeconds(0), DropoutRate(0.0f), Seed(1)
+	{
+	}
+};
+
+struct FReplaySimulatorReport
+{
+	size_t SensorFrameCount;		//  sensor frame 
+	size_t BodyFrameCount;			// CBVH   body frame 
+	size_t DroppedBodyFrameCount;
+	size_t RowCount;				//  MOTION row  ( body)
+	double ElapsedSeconds;
+
+	double FramesPerSecond;			// ó sensor frame / 
+	double RowsPerSecond;
+
+	// MOTION row  ð (sensor timestamp)  replay ð迡    row    (ms)
+	// resampling   sensor frame  ٸ ð Ѵ. Speed  0 ̸ row  ϼ frame  ޺
+	double LatencyP50;
+	double LatencyP99;
+	double LatencyP999;
+	double LatencyMax;
+};
+
+//  sensor  capture  live body frame callback   ȣ (Begin/Position/Rotation/End + EmitPendingMotion) 
+//  ӵ  ϰ, ó  ð .
+class CKinectReplaySimulator
+{
+	const std::vector<sKinectFrame>& Frames;
+
+public:
+	explicit CKinectReplaySimulator(const std::vector<sKinectFrame>& inFrames);
+
+	// inRefPoseFileName : body  CBVH   import  ref pose
+	bool Run(const std::string& inRefPoseFileName, const FReplaySimulatorOptions& inOptions, FReplaySimulatorReport& outReport) const;
+
+	static std::string FormatReport(const FReplaySimulatorReport& inReport);
+};
@@ -0,0 +1,72 @@
+#include "stdafx.h"
+
+#include "retarget.h"
+
+bool CRetargetMap::Compile(const CBVH & inSource, const CBVH & inTarget, const std::vector<FRetargetRule>& inRules)
+{
+	const auto& sourceJoints = inSource.GetSortedJointArray();
+	const auto& targetJoints = inTarget.GetSortedJointArray();
+
+	Joints.resize(targetJoints.size());
+
+	for (size_t i = 0; i < targetJoints.size(); ++i)
+	{
+		const FBVHJoint* targetJoint = targetJoints[i];
+
+		const FRetargetRule* rule = nullptr;
+		for (auto const& value : inRules)
+		{
+			if (value.TargetJointName == targetJoint->JointName)
+			{
+				rule = &value;
+				break;
+			}
+		}
+
+		auto& joint = Joints[i];
+		joint.SourceIndex = -1;
+		joint.RefQuat = targetJoint->RefQuat;
+		joint.PreQuat = XMQuaternionIdentity();
+		joint.PostQuat = XMQuaternionIdentity();
+
+		if (rule && rule->bSkip)
+			continue;
+
+		joint.SourceIndex = inSource.FindSortedJointIndex(rule ? rule->SourceJointName : targetJoint->JointName);
+		if (joint.SourceIndex < 0)
+		{
+			if (rule)
+				return false;		// Ģ ִ source joint  
+
+			continue;
+		}
+
+		XMVECTOR correction = rule ? XMQuaternionNormalize(rule->Correction) : XMQuaternionIdentity();
+
+		joint.PreQuat = XMQuaternionInverse(correction);
+		joint.PostQuat = XMQuaternionMultiply(sourceJoints[joint.SourceIndex]->InvRefQuat, correction);
+	}
+
+	return true;
+}
+
+void CRetargetMap::Apply(const FBVHJointTransform * inSourceFrame, FBVHJointTransform * outTargetFrame) const
+{
+	const size_t count = Joints.size();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto& joint = Joints[i];
+		auto& value = outTargetFrame[i];
+
+		if (joint.SourceIndex < 0)
+		{
+			value.DevQuat = XMQuaternionIdentity();
+			value.LocalQuat = joint.RefQuat;
+			continue;
+		}
+
+		value.DevQuat = XMQuaternionMultiply(XMQuaternionMultiply(joint.PreQuat, inSourceFrame[joint.SourceIndex].LocalQuat), joint.PostQuat);
+		value.LocalQuat = XMQuaternionMultiply(value.DevQuat, joint.RefQuat);
+	}
+}
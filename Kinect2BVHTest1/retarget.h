@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <DirectXMath.h>
+
+#include "bvhexport.h"
+
+// source joint -> target joint  Ģ
+struct FRetargetRule
+{
+	std::string SourceJointName;
+	std::string TargetJointName;
+
+	XMVECTOR Correction;		// source joint ǥ -> target joint ǥ ȸ (rest pose )
+	bool bSkip;					// target joint  ref pose  
+
+	FRetargetRule(const std::string& inSourceJointName, const std::string& inTargetJointName, bool inSkip = false)
+		: SourceJointName(inSourceJointName), TargetJointName(inTargetJointName), Correction(XMQuaternionIdentity()), bSkip(inSkip)
+	{
+	}
+
+	FRetargetRule(const std::string& inSourceJointName, const std::string& inTargetJointName, const XMVECTOR& inCorrection)
+		: SourceJointName(inSourceJointName), TargetJointName(inTargetJointName), Correction(inCorrection), bSkip(false)
+	{
+	}
+};
+
+// ̸  Ģ target joint  flat table    compile  ΰ,
+// frame  ڿ ˻  gather + quaternion  Ѵ.
+//
+// target  deviation  source deviation   ȸ ǥ踸 ٲ  :
+//   devT   = inverse(C) * devS * C,  devS = localS * inverse(refS)
+//   localT = devT * refT
+// ( XMQuaternionMultiply )
+class CRetargetMap
+{
+	struct FRetargetJoint
+	{
+		int SourceIndex;			// source SortedJointArray index, -1 ̸ ref pose
+		XMVECTOR PreQuat;			// inverse(C)
+		XMVECTOR PostQuat;			// inverse(refS) * C
+		XMVECTOR RefQuat;			// target ref quaternion
+	};
+
+	std::vector<FRetargetJoint> Joints;		// target SortedJointArray 
+
+public:
+	// inRules   target joint   ̸ source joint  Ѵ. ( ref pose)
+	bool Compile(const CBVH& inSource, const CBVH& inTarget, const std::vector<FRetargetRule>& inRules);
+
+	int GetTargetJointCount() const { return (int)Joints.size(); }
+
+	// inSourceFrame  LocalQuat κ target  LocalQuat, DevQuat  
+	void Apply(const FBVHJointTransform* inSourceFrame, FBVHJointTransform* outTargetFrame) const;
+};
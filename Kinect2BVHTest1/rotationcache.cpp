@@ -0,0 +1,222 @@
+#include "stdafx.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "rotationcache.h"
+#include "bvhexport.h"
+
+static const DWORD ROTATION_CACHE_MAGIC = 0x43524c4b;		// "KLRC"
+static const DWORD ROTATION_CACHE_VERSION = 1;
+
+#pragma pack(push, 1)
+struct FRotationCacheFileHeader
+{
+	DWORD Magic;
+	DWORD Version;
+	ULONGLONG CaptureHash;
+	ULONGLONG SkeletonHash;
+	DWORD JointCount;
+	DWORD FrameRate;
+	DWORD BeginTime;
+	DWORD EndTime;
+	ULONGLONG FrameCount;
+};
+#pragma pack(pop)
+
+ULONGLONG CRotationCache::Hash(ULONGLONG inHash, const void * inData, size_t inSize)
+{
+	const unsigned char* data = (const unsigned char*)inData;
+
+	for (size_t i = 0; i < inSize; ++i)
+	{
+		inHash ^= data[i];
+		inHash *= 1099511628211ull;
+	}
+
+	return inHash;
+}
+
+std::string CRotationCache::GetFileName(const std::string & inDirectory, const FRotationCacheKey & inKey)
+{
+	ULONGLONG hash = Hash(HASH_SEED, &inKey.CaptureHash, sizeof(inKey.CaptureHash));
+	hash = Hash(hash, &inKey.SkeletonHash, sizeof(inKey.SkeletonHash));
+	hash = Hash(hash, &inKey.JointCount, sizeof(inKey.JointCount));
+	hash = Hash(hash, &inKey.FrameRate, sizeof(inKey.FrameRate));
+	hash = Hash(hash, &inKey.BeginTime, sizeof(inKey.BeginTime));
+	hash = Hash(hash, &inKey.EndTime, sizeof(inKey.EndTime));
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.klrc", (unsigned long long)hash);
+
+	std::string fileName = inDirectory;
+	if (!fileName.empty() && fileName.back() != '\\' && fileName.back() != '/')
+	{
+		fileName += '\\';
+	}
+
+	return fileName + name;
+}
+
+size_t CRotationCache::GetRecordSize(int inJointCount)
+{
+	return sizeof(DWORD) + sizeof(float) * 3 + inJointCount * sizeof(float) * 4;
+}
+
+static bool IsSameKey(const FRotationCacheFileHeader& inHeader, const FRotationCacheKey& inKey)
+{
+	return inHeader.CaptureHash == inKey.CaptureHash &&
+		inHeader.SkeletonHash == inKey.SkeletonHash &&
+		inHeader.JointCount == inKey.JointCount &&
+		inHeader.FrameRate == inKey.FrameRate &&
+		inHeader.BeginTime == inKey.BeginTime &&
+		inHeader.EndTime == inKey.EndTime;
+}
+
+CRotationCacheWriter::CRotationCacheWriter() : FrameCount(0)
+{
+	memset(&Key, 0, sizeof(Key));
+}
+
+CRotationCacheWriter::~CRotationCacheWriter()
+{
+	if (File.is_open())
+	{
+		Close();
+	}
+}
+
+bool CRotationCacheWriter::Open(const std::string & inFileName, const FRotationCacheKey & inKey)
+{
+	if (inKey.JointCount == 0)
+		return false;
+
+	File.open(inFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!File)
+		return false;
+
+	FileName = inFileName;
+	Key = inKey;
+	FrameCount = 0;
+	RecordBuffer.resize(CRotationCache::GetRecordSize(Key.JointCount));
+
+	// frame  Close  ä. (  ߴܵǸ Reader  ũ ɷ)
+	FRotationCacheFileHeader header = { ROTATION_CACHE_MAGIC, ROTATION_CACHE_VERSION, Key.CaptureHash, Key.SkeletonHash, Key.JointCount, Key.FrameRate, Key.BeginTime, Key.EndTime, 0 };
+	File.write((const char*)&header, sizeof(header));
+
+	return File.good();
+}
+
+void CRotationCacheWriter::Write(DWORD inElapseTime, const FBVHJointTransform * inFrameInfo)
+{
+	char* record = RecordBuffer.data();
+
+	memcpy(record, &inElapseTime, sizeof(DWORD));
+	record += sizeof(DWORD);
+
+	memcpy(record, inFrameInfo[0].Position.m128_f32, sizeof(float) * 3);
+	record += sizeof(float) * 3;
+
+	for (DWORD j = 0; j < Key.JointCount; ++j)
+	{
+		memcpy(record, inFrameInfo[j].LocalQuat.m128_f32, sizeof(float) * 4);
+		record += sizeof(float) * 4;
+	}
+
+	File.write(RecordBuffer.data(), RecordBuffer.size());
+	++FrameCount;
+}
+
+bool CRotationCacheWriter::Close()
+{
+	if (!File.is_open())
+		return false;
+
+	bool bResult = File.good();
+	if (bResult)
+	{
+		File.seekp(offsetof(FRotationCacheFileHeader, FrameCount));
+		File.write((const char*)&FrameCount, sizeof(FrameCount));
+		bResult = File.good();
+	}
+
+	File.close();
+	bResult = bResult && !File.fail();
+
+	if (!bResult)
+	{
+		DeleteFileA(FileName.c_str());
+	}
+
+	return bResult;
+}
+
+CRotationCacheReader::CRotationCacheReader() : JointCount(0), FrameCount(0), RecordSize(0)
+{
+}
+
+bool CRotationCacheReader::Open(const std::string & inFileName, const FRotationCacheKey & inKey)
+{
+	Close();
+
+	if (!File.Open(inFileName))
+		return false;
+
+	FRotationCacheFileHeader header;
+	if (File.GetSize() < sizeof(header))
+	{
+		Close();
+		return false;
+	}
+
+	memcpy(&header, File.GetData(), sizeof(header));
+
+	const size_t recordSize = CRotationCache::GetRecordSize(inKey.JointCount);
+
+	if (header.Magic != ROTATION_CACHE_MAGIC ||
+		header.Version != ROTATION_CACHE_VERSION ||
+		!IsSameKey(header, inKey) ||
+		File.GetSize() != sizeof(header) + header.FrameCount * recordSize)
+	{
+		Close();
+		return false;
+	}
+
+	JointCount = (int)inKey.JointCount;
+	FrameCount = (size_t)header.FrameCount;
+	RecordSize = recordSize;
+
+	return true;
+}
+
+void CRotationCacheReader::Close()
+{
+	File.Close();
+
+	JointCount = 0;
+	FrameCount = 0;
+	RecordSize = 0;
+}
+
+DWORD CRotationCacheReader::Read(size_t inIndex, FBVHJointTransform * outFrameInfo) const
+{
+	const char* record = File.GetData() + sizeof(FRotationCacheFileHeader) + inIndex * RecordSize;
+
+	DWORD elapseTime;
+	memcpy(&elapseTime, record, sizeof(DWORD));
+	record += sizeof(DWORD);
+
+	XMVECTOR position = XMVectorZero();
+	memcpy(position.m128_f32, record, sizeof(float) * 3);
+	outFrameInfo[0].Position = position;
+	record += sizeof(float) * 3;
+
+	for (int j = 0; j < JointCount; ++j)
+	{
+		memcpy(outFrameInfo[j].LocalQuat.m128_f32, record, sizeof(float) * 4);
+		record += sizeof(float) * 4;
+	}
+
+	return elapseTime;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+
+#include "mappedfile.h"
+
+struct FBVHJointTransform;
+
+// CBVH::ExportFile  solver + resampling  ( frame  LocalQuat  root ̵)  Ϸ  δ cache
+// LocalQuat  capture  hierarchy  ϹǷ ref pose (RefQuat)  export  (ClipTransform, root ̵) 
+// ٲ  cache  о InvRefQuat  Euler ȯ ϸ ȴ.
+// , Է  ִ joint  LocalQuat  RefQuat  äǷ ׷ joint  RefQuat  key  Եȴ.
+//
+//  : header (key, frame ) + frame record (DWORD ElapseTime + float root ̵[3] + joint  float LocalQuat[4], packed)
+struct FRotationCacheKey
+{
+	ULONGLONG CaptureHash;			// raw frame Է (ElapseTime, Initialized, WorldQuat, root Position)
+	ULONGLONG SkeletonHash;			// joint  parent, Է  ִ joint  RefQuat
+	DWORD JointCount;
+	DWORD FrameRate;
+	DWORD BeginTime;				// export  (CBVH::SetExportTimeRange)
+	DWORD EndTime;
+};
+
+class CRotationCache
+{
+public:
+	static const ULONGLONG HASH_SEED = 14695981039346656037ull;
+
+	// FNV-1a (64 bit). inHash  ̾ 
+	static ULONGLONG Hash(ULONGLONG inHash, const void* inData, size_t inSize);
+
+	// inDirectory ȿ key    ̸ (<hash>.klrc)
+	static std::string GetFileName(const std::string& inDirectory, const FRotationCacheKey& inKey);
+
+	static size_t GetRecordSize(int inJointCount);
+};
+
+class CRotationCacheWriter
+{
+	std::ofstream File;
+	std::string FileName;
+	FRotationCacheKey Key;
+
+	std::vector<char> RecordBuffer;
+	ULONGLONG FrameCount;
+
+	CRotationCacheWriter(const CRotationCacheWriter&) = delete;
+	CRotationCacheWriter& operator=(const CRotationCacheWriter&) = delete;
+
+public:
+	CRotationCacheWriter();
+	~CRotationCacheWriter();
+
+	bool Open(const std::string& inFileName, const FRotationCacheKey& inKey);
+
+	// inFrameInfo : JointCount . LocalQuat  [0].Position (root ̵)  
+	void Write(DWORD inElapseTime, const FBVHJointTransform* inFrameInfo);
+
+	// header  frame  ä ݴ´. ٰ   .
+	bool Close();
+};
+
+class CRotationCacheReader
+{
+	CMappedFile File;
+
+	int JointCount;
+	size_t FrameCount;
+	size_t RecordSize;
+
+public:
+	CRotationCacheReader();
+
+	// key  ٸų frame ŭ record   (  ) false
+	bool Open(const std::string& inFileName, const FRotationCacheKey& inKey);
+	void Close();
+
+	size_t GetFrameCount() const { return FrameCount; }
+
+	// outFrameInfo  LocalQuat  [0].Position  ä ElapseTime ȯ
+	DWORD Read(size_t inIndex, FBVHJointTransform* outFrameInfo) const;
+};
@@ -0,0 +1,330 @@
+#include "stdafx.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+#include "streamexport.h"
+#include "capturereader.h"
+#include "cliptransform.h"
+#include "quaternion.h"
+
+// header  "Frames: " ڿ  δ ڸ (   ڷ )
+static const int FRAME_COUNT_WIDTH = 20;
+
+// stage   ϳ : ̸   Free ( ) ->  stage -> Full ->  stage -> Free  .
+template<typename TBatch>
+struct TStreamLink
+{
+	std::vector<std::unique_ptr<TBatch>> Pool;
+	TBoundedQueue<TBatch*> Free;
+	TBoundedQueue<TBatch*> Full;
+
+	template<typename TInit>
+	TStreamLink(size_t inDepth, TInit inInit) : Free(inDepth), Full(inDepth)
+	{
+		for (size_t i = 0; i < inDepth; ++i)
+		{
+			Pool.emplace_back(new TBatch());
+			inInit(*Pool.back());
+			Free.Push(Pool.back().get());
+		}
+	}
+
+	void Close()
+	{
+		Free.Close();
+		Full.Close();
+	}
+};
+
+struct FStreamCaptureBatch
+{
+	std::vector<sKinectFrame> Frames;
+	size_t Count;
+};
+
+struct FStreamFrameBatch
+{
+	std::vector<FBVHJointTransform> FrameInfo;		// frame  JointCount  (LocalQuat, DevQuat, root  Position)
+	size_t Count;
+};
+
+struct FStreamTextBatch
+{
+	std::string Text;
+};
+
+typedef TStreamLink<FStreamCaptureBatch> FStreamCaptureLink;
+typedef TStreamLink<FStreamFrameBatch> FStreamFrameLink;
+typedef TStreamLink<FStreamTextBatch> FStreamTextLink;
+
+static void RunReaderStage(CKinectCaptureStream& inStream, FStreamCaptureLink& outLink, std::atomic<ULONGLONG>& outRawFrameCount)
+{
+	FStreamCaptureBatch* batch;
+	while (outLink.Free.Pop(batch))
+	{
+		batch->Count = inStream.Read(batch->Frames.data(), batch->Frames.size());
+		if (batch->Count == 0)
+			break;
+
+		outRawFrameCount += batch->Count;
+
+		if (!outLink.Full.Push(batch))
+			return;
+	}
+
+	outLink.Full.Close();
+}
+
+// CBVH  frame   ʰ record  raw frame   ä CBVH::SolveLocalRotation  Ǯ,
+// CBVH::ForEachEvenSpacedFrame   CBVHResampleCursor (SetExportTimeRange  )  CBVH::InterpolateFrame  resampling Ѵ.
+// raw frame   ʿ ֱ   Ѵ.
+static void RunSolverStage(const CBVH& inSkeleton, const FStreamExportOptions& inOptions, FStreamCaptureLink& inLink, FStreamFrameLink& outLink, std::atomic<ULONGLONG>& outFrameCount)
+{
+	const int jointCount = inSkeleton.GetJointCount();
+
+	DWORD exportBeginTime, exportEndTime;
+	inSkeleton.GetExportTimeRange(exportBeginTime, exportEndTime);
+
+	CBVHResampleCursor cursor(inSkeleton.GetExportFrameRate(), exportBeginTime, exportEndTime);
+
+	std::vector<FBVHJointTransform> rawFrame0(jointCount);
+	std::vector<FBVHJointTransform> rawFrame1(jointCount);
+	DWORD rawTime0 = 0;
+	bool bHasRawFrame = false;
+
+	XMVECTOR rootOrigin = XMVectorZero();
+	float interpTime;
+
+	FStreamFrameBatch* outBatch = nullptr;
+	const size_t batchFrameCount = inOptions.BatchFrameCount;
+
+	FStreamCaptureBatch* inBatch;
+	while (inLink.Full.Pop(inBatch))
+	{
+		for (size_t i = 0; i < inBatch->Count; ++i)
+		{
+			const sKinectFrame& capture = inBatch->Frames[i];
+
+			if (bHasRawFrame && capture.MilliSecond < rawTime0)
+				continue;
+
+			std::fill(rawFrame1.begin(), rawFrame1.end(), FBVHJointTransform());
+
+			for (int k = 0; k < capture.PosCount; ++k)
+			{
+				const int index = inSkeleton.GetSortedJointIndex((JointType)capture.Pos[k].JointType);
+				if (index < 0)
+					continue;
+
+				rawFrame1[index].Initialized = true;
+				rawFrame1[index].Position = Vector4ToXMVECTOR(capture.Pos[k].Position);
+			}
+
+			for (int k = 0; k < capture.RotCount; ++k)
+			{
+				const int index = inSkeleton.GetSortedJointIndex((JointType)capture.Rot[k].JointType);
+				if (index < 0)
+					continue;
+
+				const Vector4& quat = capture.Rot[k].Quaternion;
+				if (quat.x == 0.0f && quat.y == 0.0f && quat.z == 0.0f && quat.w == 0.0f)
+				{
+					rawFrame1[index].Initialized = false;
+					continue;
+				}
+
+				rawFrame1[index].Initialized = true;
+				rawFrame1[index].WorldQuat = Vector4ToXMVECTOR(quat);
+			}
+
+			inSkeleton.SolveLocalRotation(rawFrame1.data());
+
+			const DWORD rawTime1 = capture.MilliSecond;
+
+			if (!bHasRawFrame)
+			{
+				bHasRawFrame = true;
+				cursor.Start(rawTime1);
+				rootOrigin = rawFrame1[0].Position;
+
+				std::swap(rawFrame0, rawFrame1);
+				rawTime0 = rawTime1;
+				continue;
+			}
+
+			for (; cursor.GetFrame(rawTime0, rawTime1, interpTime); cursor.Next())
+			{
+				if (outBatch == nullptr)
+				{
+					if (!outLink.Free.Pop(outBatch))
+						return;
+
+					outBatch->Count = 0;
+				}
+
+				FBVHJointTransform* frameInfo = outBatch->FrameInfo.data() + outBatch->Count * jointCount;
+
+				inSkeleton.InterpolateFrame(rawFrame0.data(), rawFrame1.data(), interpTime, rootOrigin, frameInfo);
+				inSkeleton.ApplyFrameTransform(frameInfo, inOptions.ClipTransform, inOptions.bRootTranslation);
+
+				if (++outBatch->Count == batchFrameCount)
+				{
+					if (!outLink.Full.Push(outBatch))
+						return;
+
+					outBatch = nullptr;
+				}
+			}
+
+			std::swap(rawFrame0, rawFrame1);
+			rawTime0 = rawTime1;
+		}
+
+		inLink.Free.Push(inBatch);
+	}
+
+	if (outBatch && outBatch->Count > 0)
+	{
+		outLink.Full.Push(outBatch);
+	}
+
+	outFrameCount = cursor.GetFrameIndex();
+	outLink.Full.Close();
+}
+
+static void RunFormatterStage(int inJointCount, EEulerPrecision inPrecision, bool bRootTranslation, FStreamFrameLink& inLink, FStreamTextLink& outLink)
+{
+	FStreamFrameBatch* inBatch;
+	while (inLink.Full.Pop(inBatch))
+	{
+		FStreamTextBatch* outBatch;
+		if (!outLink.Free.Pop(outBatch))
+			return;
+
+		outBatch->Text.clear();
+
+		for (size_t i = 0; i < inBatch->Count; ++i)
+		{
+			FBVHJointTransform* frameInfo = inBatch->FrameInfo.data() + i * inJointCount;
+
+			for (int j = 0; j < inJointCount; ++j)
+			{
+				QuaternionToEulerAngles(frameInfo[j].DevQuat, frameInfo[j].Rotation, zyx, inPrecision);
+			}
+
+			FBVHFrame::ExportMOTION(frameInfo, inJointCount, outBatch->Text, false, bRootTranslation);
+		}
+
+		inLink.Free.Push(inBatch);
+
+		if (!outLink.Full.Push(outBatch))
+			return;
+	}
+
+	outLink.Full.Close();
+}
+
+CBVHStreamExporter::CBVHStreamExporter(const CBVH & inSkeleton, const FStreamExportOptions & inOptions)
+	: Skeleton(inSkeleton), Options(inOptions), RawFrameCount(0), FrameCount(0)
+{
+}
+
+bool CBVHStreamExporter::Export(const std::string & inCaptureFileName, const std::string & inBVHFileName)
+{
+	RawFrameCount = 0;
+	FrameCount = 0;
+
+	const int jointCount = Skeleton.GetJointCount();
+	if (jointCount <= 0 || Options.BatchFrameCount == 0 || Options.QueueDepth <= 0)
+		return false;
+
+	if (Options.ClipTransform && Options.ClipTransform->GetJointCount() != jointCount)
+		return false;
+
+	CKinectCaptureStream stream;
+	if (!stream.Open(inCaptureFileName))
+		return false;
+
+	std::string header;
+	Skeleton.ExportHeader(header, 0);
+
+	const size_t framesPos = header.find("\nFrames: 0\n");
+	if (framesPos == std::string::npos)
+		return false;
+
+	std::ofstream file(inBVHFileName.c_str());
+	if (!file)
+		return false;
+
+	// "Frames: "   ڸ  д.
+	const size_t countPos = framesPos + 9;
+	file.write(header.data(), countPos);
+	const std::streampos frameCountOffset = file.tellp();
+	file << std::string(FRAME_COUNT_WIDTH, ' ');
+	file.write(header.data() + countPos + 1, header.size() - countPos - 1);
+
+	const size_t batchFrameCount = Options.BatchFrameCount;
+	const size_t depth = (size_t)Options.QueueDepth;
+
+	FStreamCaptureLink captureLink(depth, [=](FStreamCaptureBatch& outBatch)
+	{
+		outBatch.Frames.resize(batchFrameCount);
+		outBatch.Count = 0;
+	});
+
+	FStreamFrameLink frameLink(depth, [=](FStreamFrameBatch& outBatch)
+	{
+		outBatch.FrameInfo.resize(batchFrameCount * jointCount);
+		outBatch.Count = 0;
+	});
+
+	FStreamTextLink textLink(depth, [=](FStreamTextBatch& outBatch)
+	{
+		// joint  channel 3 ,  ϳ 뷫 12 
+		outBatch.Text.reserve(batchFrameCount * (jointCount * 3 + 3) * 12);
+	});
+
+	std::thread reader(RunReaderStage, std::ref(stream), std::ref(captureLink), std::ref(RawFrameCount));
+	std::thread solver(RunSolverStage, std::cref(Skeleton), std::cref(Options), std::ref(captureLink), std::ref(frameLink), std::ref(FrameCount));
+	std::thread formatter(RunFormatterStage, jointCount, Skeleton.GetEulerPrecision(), Options.bRootTranslation, std::ref(frameLink), std::ref(textLink));
+
+	// writer : ȣ thread
+	bool bWriteFailed = !file;
+
+	FStreamTextBatch* textBatch;
+	while (!bWriteFailed && textLink.Full.Pop(textBatch))
+	{
+		file.write(textBatch->Text.data(), textBatch->Text.size());
+		textLink.Free.Push(textBatch);
+
+		bWriteFailed = !file;
+	}
+
+	if (bWriteFailed)
+	{
+		//  stage  ٸ   .
+		captureLink.Close();
+		frameLink.Close();
+		textLink.Close();
+	}
+
+	reader.join();
+	solver.join();
+	formatter.join();
+
+	if (bWriteFailed)
+		return false;
+
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "%-*llu", FRAME_COUNT_WIDTH, (unsigned long long)FrameCount.load());
+
+	file.seekp(frameCountOffset);
+	file.write(buffer, FRAME_COUNT_WIDTH);
+	file.close();
+
+	return !file.fail();
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "bvhexport.h"
+
+class CClipTransform;
+
+//  ũ ring queue. Push    , Pop    ٸ. (stage  backpressure)
+// Close  Push  false, Pop   ׸    false
+template<typename T>
+class TBoundedQueue
+{
+	std::vector<T> Items;
+	size_t Head;
+	size_t Count;
+	bool bClosed;
+
+	std::mutex Mutex;
+	std::condition_variable NotEmpty;
+	std::condition_variable NotFull;
+
+public:
+	explicit TBoundedQueue(size_t inCapacity) : Items(inCapacity), Head(0), Count(0), bClosed(false)
+	{
+	}
+
+	bool Push(const T& inItem)
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		NotFull.wait(lock, [this] { return bClosed || Count < Items.size(); });
+
+		if (bClosed)
+			return false;
+
+		Items[(Head + Count) % Items.size()] = inItem;
+		++Count;
+
+		lock.unlock();
+		NotEmpty.notify_one();
+		return true;
+	}
+
+	bool Pop(T& outItem)
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		NotEmpty.wait(lock, [this] { return bClosed || Count > 0; });
+
+		if (Count == 0)
+			return false;
+
+		outItem = Items[Head];
+		Head = (Head + 1) % Items.size();
+		--Count;
+
+		lock.unlock();
+		NotFull.notify_one();
+		return true;
+	}
+
+	void Close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			bClosed = true;
+		}
+
+		NotEmpty.notify_all();
+		NotFull.notify_all();
+	}
+};
+
+struct FStreamExportOptions
+{
+	size_t BatchFrameCount;					// stage ̿ ѱ  frame 
+	int QueueDepth;							// stage    (̸ŭ ռ  stage  ٸ)
+	bool bRootTranslation;					// CBVH::SetRootTranslationExport  
+	const CClipTransform* ClipTransform;	// CBVH::SetClipTransform   (nullptr ̸ )
+
+	FStreamExportOptions() : BatchFrameCount(64), QueueDepth(4), bRootTranslation(false), ClipTransform(nullptr)
+	{
+	}
+};
+
+// capture  ó     BVH  Ѵ. (CBVH::ExportFile   , SetExportTimeRange  )
+//  stage  ڱ thread  ,  ũ  TBoundedQueue  帥.
+//   reader (CKinectCaptureStream) -> solver + resampler -> euler + formatter -> writer (ȣ thread)
+//  stage  QueueDepth  ̸   Ƿ, capture ̿ ϰ
+// ޸𸮴 (BatchFrameCount * QueueDepth) frame  ǰ frame  Ҵ .
+// ü frame     Ƿ header  "Frames:"  ڸ  ΰ  ä.
+// capture  ð  ϸ, ð ǵư record  .
+class CBVHStreamExporter
+{
+	const CBVH& Skeleton;
+	FStreamExportOptions Options;
+
+	std::atomic<ULONGLONG> RawFrameCount;
+	std::atomic<ULONGLONG> FrameCount;
+
+	CBVHStreamExporter(const CBVHStreamExporter&) = delete;
+	CBVHStreamExporter& operator=(const CBVHStreamExporter&) = delete;
+
+public:
+	// inSkeleton : ref pose  import  CBVH (frame   , export ϴ  ). Euler ȯ tier  inSkeleton  .
+	CBVHStreamExporter(const CBVH& inSkeleton, const FStreamExportOptions& inOptions = FStreamExportOptions());
+
+	bool Export(const std::string& inCaptureFileName, const std::string& inBVHFileName);
+
+	//  Export  Է record ,  frame 
+	ULONGLONG GetRawFrameCount() const { return RawFrameCount; }
+	ULONGLONG GetFrameCount() const { return FrameCount; }
+};
@@ -0,0 +1,254 @@
+#include "stdafx.h"
+
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+
+#include "syntheticcapture.h"
+#include "blockcompress.h"
+
+// Ͽ    ũ
+static const size_t SYNTHETIC_CAPTURE_WRITE_SIZE = 4 << 20;
+
+CSyntheticCaptureGenerator::CSyntheticCaptureGenerator(const CBVH & inRefPose, const FSyntheticCaptureOptions & inOptions) : Options(inOptions), GeneratedCount(0), LastTime(0)
+{
+	const auto& sortedJoints = inRefPose.GetSortedJointArray();
+
+	Joints.resize(sortedJoints.size());
+	WorldQuats.resize(sortedJoints.size());
+
+	for (size_t i = 0; i < sortedJoints.size(); ++i)
+	{
+		const FBVHJoint* bvhJoint = sortedJoints[i];
+		auto& joint = Joints[i];
+
+		joint.ParentIndex = bvhJoint->ParentJoint ? bvhJoint->ParentJoint->JointIndex : -1;
+		joint.KinectJointType = bvhJoint->KinectJointType;
+		joint.RefQuat = bvhJoint->RefQuat;
+
+		// OFFSET  mm. root  sensor  2 m  .
+		XMVECTOR offset = XMVectorScale(bvhJoint->Position, 0.001f);
+		joint.RefPosition = joint.ParentIndex < 0 ? XMVectorSet(0.0f, 0.0f, 2.0f, 0.0f) : XMVectorAdd(Joints[joint.ParentIndex].RefPosition, offset);
+
+		if (joint.KinectJointType < JointType_Count)
+		{
+			CaptureJointIndices.push_back((int)i);
+		}
+	}
+
+	std::stable_sort(CaptureJointIndices.begin(), CaptureJointIndices.end(), [this](int a, int b)
+	{
+		return Joints[a].KinectJointType < Joints[b].KinectJointType;
+	});
+
+	Reset();
+}
+
+float CSyntheticCaptureGenerator::NextRandom(float inMin, float inMax)
+{
+	// std::uniform_real_distribution    ޶  ȯѴ.
+	float value = (float)(Random() >> 8) * (1.0f / 16777216.0f);
+	return inMin + (inMax - inMin) * value;
+}
+
+void CSyntheticCaptureGenerator::Reset()
+{
+	Random.seed(Options.Seed);
+
+	for (auto& joint : Joints)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float weight = NextRandom(0.2f, 0.8f);
+
+			joint.Frequency[axis][0] = NextRandom(0.05f, 0.5f);
+			joint.Frequency[axis][1] = NextRandom(0.5f, 2.0f);
+			joint.Phase[axis][0] = NextRandom(0.0f, XM_2PI);
+			joint.Phase[axis][1] = NextRandom(0.0f, XM_2PI);
+			joint.Weight[axis][0] = weight;
+			joint.Weight[axis][1] = 1.0f - weight;
+		}
+
+		joint.DropoutFrames = 0;
+	}
+
+	GeneratedCount = 0;
+	LastTime = 0;
+}
+
+void CSyntheticCaptureGenerator::NextFrame(sKinectFrame & outFrame)
+{
+	// timestamp :   + jitter, ׻ 
+	long long time = (long long)Options.BeginTime + (long long)GeneratedCount * Options.FrameInterval;
+	if (Options.JitterMilliSeconds > 0)
+	{
+		time += (long long)floorf(NextRandom(-(float)Options.JitterMilliSeconds, (float)Options.JitterMilliSeconds + 1.0f));
+	}
+
+	if (time < 0)
+		time = 0;
+
+	if (GeneratedCount > 0 && time <= (long long)LastTime)
+		time = LastTime + 1;
+
+	LastTime = (DWORD)time;
+	++GeneratedCount;
+
+	const float seconds = (float)(LastTime - Options.BeginTime) * 0.001f;
+
+	// root   ̵
+	XMVECTOR sway = XMVectorSet(0.3f * sinf(XM_2PI * 0.05f * seconds), 0.0f, 0.2f * sinf(XM_2PI * 0.03f * seconds + 1.0f), 0.0f);
+
+	for (size_t i = 0; i < Joints.size(); ++i)
+	{
+		const auto& joint = Joints[i];
+
+		float angles[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			angles[axis] = Options.Amplitude * (
+				joint.Weight[axis][0] * sinf(XM_2PI * joint.Frequency[axis][0] * seconds + joint.Phase[axis][0]) +
+				joint.Weight[axis][1] * sinf(XM_2PI * joint.Frequency[axis][1] * seconds + joint.Phase[axis][1]));
+		}
+
+		// local*parent.world = world
+		XMVECTOR localQuat = XMQuaternionMultiply(XMQuaternionRotationRollPitchYaw(angles[0], angles[1], angles[2]), joint.RefQuat);
+		WorldQuats[i] = joint.ParentIndex < 0 ? localQuat : XMQuaternionMultiply(localQuat, WorldQuats[joint.ParentIndex]);
+	}
+
+	outFrame.MilliSecond = LastTime;
+	outFrame.PosCount = 0;
+	outFrame.RotCount = 0;
+
+	for (int index : CaptureJointIndices)
+	{
+		auto& joint = Joints[index];
+
+		//   joint  sensor ó zero quaternion
+		bool bDropout = false;
+		if (joint.DropoutFrames > 0)
+		{
+			--joint.DropoutFrames;
+			bDropout = true;
+		}
+		else if (NextRandom(0.0f, 1.0f) < Options.DropoutRate)
+		{
+			joint.DropoutFrames = (int)(Random() % (unsigned int)std::max(1, Options.MaxDropoutFrames));
+			bDropout = true;
+		}
+
+		XMFLOAT3 position;
+		XMStoreFloat3(&position, XMVectorAdd(joint.RefPosition, sway));
+
+		auto& pos = outFrame.Pos[outFrame.PosCount++];
+		pos.JointType = joint.KinectJointType;
+		pos.Position.x = position.x;
+		pos.Position.y = position.y;
+		pos.Position.z = position.z;
+		pos.Position.w = 0.0f;
+
+		XMFLOAT4 quat(0.0f, 0.0f, 0.0f, 0.0f);
+		if (!bDropout)
+		{
+			XMStoreFloat4(&quat, XMQuaternionNormalize(WorldQuats[index]));
+		}
+
+		auto& rot = outFrame.Rot[outFrame.RotCount++];
+		rot.JointType = joint.KinectJointType;
+		rot.Quaternion.x = quat.x;
+		rot.Quaternion.y = quat.y;
+		rot.Quaternion.z = quat.z;
+		rot.Quaternion.w = quat.w;
+	}
+}
+
+bool CSyntheticCaptureGenerator::WriteFile(const std::string & inFileName, ULONGLONG * outFrameCount)
+{
+	if (outFrameCount)
+		*outFrameCount = 0;
+
+	// ".gz" ̸ block    (TargetSize    ũ)
+	const bool bCompressed = CBlockCompressedWriter::IsCompressedFileName(inFileName);
+
+	CBlockCompressedWriter compressedWriter;
+	std::ofstream file;
+
+	if (bCompressed)
+	{
+		if (!compressedWriter.Open(inFileName))
+			return false;
+	}
+	else
+	{
+		file.open(inFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.good())
+			return false;
+	}
+
+	Reset();
+
+	std::string buffer;
+	buffer.reserve(SYNTHETIC_CAPTURE_WRITE_SIZE * 2);
+
+	if (Options.Format == ECaptureFileFormat_Binary)
+	{
+		CKinectCaptureReader::AppendBinaryHeader(buffer);
+	}
+
+	ULONGLONG writtenSize = 0;
+	sKinectFrame frame;
+
+	for (;;)
+	{
+		if (Options.TargetSize > 0 ? writtenSize + buffer.size() >= Options.TargetSize : GeneratedCount >= Options.FrameCount)
+			break;
+
+		NextFrame(frame);
+
+		if (Options.Format == ECaptureFileFormat_Binary)
+		{
+			CKinectCaptureReader::AppendBinaryRecord(frame, buffer);
+		}
+		else
+		{
+			CKinectCaptureReader::AppendTextRecord(frame, buffer);
+		}
+
+		if (buffer.size() >= SYNTHETIC_CAPTURE_WRITE_SIZE)
+		{
+			if (bCompressed)
+			{
+				compressedWriter.Write(buffer);
+			}
+			else
+			{
+				file.write(buffer.data(), buffer.size());
+				if (!file.good())
+					return false;
+			}
+
+			writtenSize += buffer.size();
+			buffer.clear();
+		}
+	}
+
+	bool bResult;
+
+	if (bCompressed)
+	{
+		compressedWriter.Write(buffer);
+		bResult = compressedWriter.Close();
+	}
+	else
+	{
+		file.write(buffer.data(), buffer.size());
+		file.close();
+
+		bResult = !file.fail();
+	}
+
+	if (outFrameCount)
+		*outFrameCount = GeneratedCount;
+
+	return bResult;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <random>
+#include <DirectXMath.h>
+
+#include "bvhexport.h"
+#include "capturereader.h"
+
+enum ECaptureFileFormat
+{
+	ECaptureFileFormat_Text,		// rawtest.txt   
+	ECaptureFileFormat_Binary,		// CKinectCaptureReader::ReadBinaryFile
+};
+
+struct FSyntheticCaptureOptions
+{
+	ECaptureFileFormat Format;
+
+	ULONGLONG TargetSize;			//  ũ (byte). Ѵ record   . 0 ̸ FrameCount 
+	ULONGLONG FrameCount;
+
+	DWORD BeginTime;				// ù record  timestamp (ms)
+	int FrameInterval;				// record  (ms)
+	int JitterMilliSeconds;			// timestamp  +-JitterMilliSeconds ȿ . ( )
+
+	float Amplitude;				// joint  ref pose   ִ  (radian)
+	float DropoutRate;				// frame  joint ϳ  ұ  Ȯ (zero quaternion  )
+	int MaxDropoutFrames;			//    1 ~ MaxDropoutFrames frame  
+
+	unsigned int Seed;
+
+	FSyntheticCaptureOptions() : Format(ECaptureFileFormat_Text), TargetSize(0), FrameCount(1000), BeginTime(1000), FrameInterval(33), JitterMilliSeconds(2),
+		Amplitude(0.4f), DropoutRate(0.002f), MaxDropoutFrames(30), Seed(1)
+	{
+	}
+};
+
+// ref pose skeleton  seed   ε巯  ȸ  capture  .
+//  ref pose,  option ̸   ´. (ũ⿡  record   )
+//
+// joint ȸ : ึ ļ/ ٸ sin    (local = delta * ref, world = local * parent.world)
+// joint ġ : ref pose ġ (mm -> m) + root   ̵. ȸ ݿ ʴ´. (ġ export   )
+class CSyntheticCaptureGenerator
+{
+	struct FJointMotion
+	{
+		int ParentIndex;				// SortedJointArray index, root  -1
+		int KinectJointType;			// JointType_Count ̸̻ capture   ʴ´.
+
+		XMVECTOR RefQuat;
+		XMVECTOR RefPosition;			// world (m)
+
+		float Frequency[3][2];			// Hz
+		float Phase[3][2];
+		float Weight[3][2];
+
+		int DropoutFrames;				//   ս frame 
+	};
+
+	FSyntheticCaptureOptions Options;
+
+	std::vector<FJointMotion> Joints;
+	std::vector<XMVECTOR> WorldQuats;
+	std::vector<int> CaptureJointIndices;		// capture   joint (KinectJointType )
+
+	std::mt19937 Random;
+
+	ULONGLONG GeneratedCount;
+	DWORD LastTime;
+
+	float NextRandom(float inMin, float inMax);
+
+public:
+	CSyntheticCaptureGenerator(const CBVH& inRefPose, const FSyntheticCaptureOptions& inOptions);
+
+	// ó frame  ٽ .
+	void Reset();
+
+	void NextFrame(sKinectFrame& outFrame);
+
+	// Options.Format  inFileName  . ".gz" ̸ block   (CBlockCompressedWriter)
+	bool WriteFile(const std::string& inFileName, ULONGLONG* outFrameCount = nullptr);
+};